@@ -18,13 +18,19 @@ public:
   DxCubeRenderer(const DxCubeRenderer&) = delete;
   DxCubeRenderer& operator=(const DxCubeRenderer&) = delete;
 
-  DxCubeRenderer(const winrt::com_ptr<ID3D11Device>& device);
+  DxCubeRenderer(const winrt::com_ptr<ID3D11Device>& device,
+                 InstanceFormat format = InstanceFormat::Matrix);
   ~DxCubeRenderer();
   void UploadPallete();
   void Render(const float projection[16],
               const float view[16],
               const Instance* data,
               uint32_t instanceCount);
+  // InstanceFormat::Compact
+  void Render(const float projection[16],
+              const float view[16],
+              const CompactInstance* data,
+              uint32_t instanceCount);
 };
 
 }
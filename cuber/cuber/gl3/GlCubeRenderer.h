@@ -4,38 +4,114 @@
 #include <array>
 #include <memory>
 #include <span>
+#include <vector>
 
 namespace grapho {
 namespace gl3 {
 struct Vao;
 class ShaderProgram;
 class Vbo;
+class Ibo;
+class StreamBuffer;
 struct Ubo;
+struct Ssbo;
 }
 }
 
 namespace cuber {
 namespace gl3 {
 
+struct CullingStats
+{
+  uint32_t Visible = 0;
+  uint32_t Culled = 0;
+};
+
 class GlCubeRenderer
 {
-  std::shared_ptr<grapho::gl3::Vao> m_vao;
+  InstanceFormat m_format;
   std::shared_ptr<grapho::gl3::ShaderProgram> m_shader;
-  std::shared_ptr<grapho::gl3::Vbo> m_instance_vbo;
+  std::shared_ptr<grapho::gl3::Vbo> m_vbo;
+  std::shared_ptr<grapho::gl3::Ibo> m_ibo;
+  std::vector<grapho::VertexLayout> m_layouts;
+
+  // triple buffered. one vao per slice, instance attributes point into it
+  std::shared_ptr<grapho::gl3::StreamBuffer> m_instances;
+  std::vector<std::shared_ptr<grapho::gl3::Vao>> m_vaos;
+  uint32_t m_instanceCount = 0;
 
   std::shared_ptr<grapho::gl3::Ubo> m_ubo;
 
+  // gpu culling. compute shader compacts visible instances into m_visible
+  std::shared_ptr<grapho::gl3::ShaderProgram> m_cull;
+  bool m_cullUnsupported = false;
+  std::shared_ptr<grapho::gl3::Vbo> m_visible;
+  std::shared_ptr<grapho::gl3::Vao> m_visibleVao;
+  // DrawElementsIndirectCommand for each slice
+  std::vector<std::shared_ptr<grapho::gl3::Ssbo>> m_commands;
+  std::vector<uint32_t> m_cullSubmitted;
+  bool m_culled = false;
+  CullingStats m_cullingStats;
+
+  // GL_OVR_multiview2
+  std::shared_ptr<grapho::gl3::ShaderProgram> m_stereoShader;
+  bool m_stereoUnsupported = false;
+  std::shared_ptr<grapho::gl3::Ubo> m_stereoUbo;
+
+  void ReserveInstances(uint32_t instanceCount);
+  void ReadCullingStats();
+  bool Cull(const DirectX::XMFLOAT4* planes, uint32_t planeCount);
+  void* MapInstances(InstanceFormat format, uint32_t instanceCount);
+  void Draw(grapho::gl3::ShaderProgram& shader);
+
 public:
   Pallete Pallete = {};
   GlCubeRenderer(const GlCubeRenderer&) = delete;
   GlCubeRenderer& operator=(const GlCubeRenderer&) = delete;
-  GlCubeRenderer();
+  GlCubeRenderer(InstanceFormat format = InstanceFormat::Matrix);
   ~GlCubeRenderer();
   void UploadPallete();
+
+  // write instances straight into the mapped slice of the instance ring.
+  // may wait for the gpu to release the slice used SliceCount frames before.
+  // an empty span for 0 instances. nothing is drawn
+  std::span<Instance> BeginInstances(uint32_t instanceCount);
+  // InstanceFormat::Compact
+  std::span<CompactInstance> BeginCompactInstances(uint32_t instanceCount);
+  void EndInstances();
+  // optional. compact the instances visible from the frustum and draw them
+  // with glDrawElementsIndirect. call after EndInstances.
+  // return false if compute shader is not supported.
+  bool Cull(const float projection[16], const float view[16]);
+  // cull once against the union of both eye frusta
+  bool Cull(const float leftProjection[16],
+            const float leftView[16],
+            const float rightProjection[16],
+            const float rightView[16]);
+  // result of the slice that the gpu has finished. SliceCount frames behind
+  const CullingStats& GetCullingStats() const { return m_cullingStats; }
+  // draw the instances of the last BeginInstances/EndInstances.
+  // can be called more than once, for each eye.
+  void Render(const float projection[16], const float view[16]);
+  // compile the GL_OVR_multiview2 shader up front.
+  // return false if multiview is not supported or the shader fails.
+  bool InitStereo();
+  // draw both eyes in one pass into a 2 layer framebuffer
+  // (glFramebufferTextureMultiviewOVR).
+  // return false if InitStereo fails.
+  bool RenderStereo(const float leftProjection[16],
+                    const float leftView[16],
+                    const float rightProjection[16],
+                    const float rightView[16]);
+  // BeginInstances, copy, EndInstances and Render
   void Render(const float projection[16],
               const float view[16],
               const Instance* data,
               uint32_t instanceCount);
+  void Render(const float projection[16],
+              const float view[16],
+              const CompactInstance* data,
+              uint32_t instanceCount);
 };
 
 }
@@ -7,6 +7,7 @@ namespace grapho::gl3 {
 class Vbo;
 struct Vao;
 class ShaderProgram;
+struct Ubo;
 } // namespace grapho::gl3
 
 namespace cuber::gl3 {
@@ -16,6 +17,10 @@ class GlLineRenderer
   std::shared_ptr<grapho::gl3::Vbo> vbo_;
   std::shared_ptr<grapho::gl3::Vao> vao_;
   std::shared_ptr<grapho::gl3::ShaderProgram> shader_;
+  // GL_OVR_multiview2
+  std::shared_ptr<grapho::gl3::ShaderProgram> stereoShader_;
+  bool stereoUnsupported_ = false;
+  std::shared_ptr<grapho::gl3::Ubo> stereoUbo_;
 
 public:
   GlLineRenderer(const GlLineRenderer&) = delete;
@@ -25,6 +30,14 @@ public:
   void Render(const float projection[16],
               const float view[16],
               std::span<const LineVertex> data);
+  // see GlCubeRenderer::InitStereo
+  bool InitStereo();
+  // see GlCubeRenderer::RenderStereo
+  bool RenderStereo(const float leftProjection[16],
+                    const float leftView[16],
+                    const float rightProjection[16],
+                    const float rightView[16],
+                    std::span<const LineVertex> data);
 };
 
 } // namespace cuber::gl3
@@ -1,4 +1,5 @@
 #pragma once
+#include "quat_packer.h"
 #include <DirectXMath.h>
 #include <grapho/vertexlayout.h>
 #include <string>
@@ -20,8 +21,21 @@ struct Mesh
   std::vector<grapho::VertexLayout> Layouts;
 };
 
+enum class InstanceFormat
+{
+  // Instance. float4x4 and float face flags. 96 bytes
+  Matrix,
+  // CompactInstance. position, Quat32 and half scale. 32 bytes
+  Compact,
+};
+
+uint32_t
+InstanceStride(InstanceFormat format);
+
 Mesh
-Cube(bool isCCW, bool isStereo);
+Cube(bool isCCW,
+     bool isStereo,
+     InstanceFormat format = InstanceFormat::Matrix);
 
 enum class ColorName : uint8_t
 {
@@ -93,6 +107,25 @@ struct Instance
 };
 static_assert(sizeof(Instance) == 96, "sizeof Instance");
 
+struct CompactInstance
+{
+  DirectX::XMFLOAT3 Position = { 0, 0, 0 };
+  // quat_packer::Pack(x, y, z, w)
+  uint32_t Rotation = quat_packer::Pack(0, 0, 0, 1);
+  // half float xyz. w is unused
+  uint16_t Scale[4] = { 0x3c00, 0x3c00, 0x3c00, 0x3c00 };
+  // palette index of x+, y+, z+ and flag. same as Instance
+  uint8_t PositiveFaceFlag[4] = { 1, 2, 3, 0 };
+  // palette index of x-, y-, z- and flag. same as Instance
+  uint8_t NegativeFaceFlag[4] = { 4, 5, 6, 0 };
+};
+static_assert(sizeof(CompactInstance) == 32, "sizeof CompactInstance");
+
+// decompose Matrix into translation, rotation and scale.
+// shear is lost.
+CompactInstance
+Compact(const Instance& instance);
+
 struct LineVertex
 {
   DirectX::XMFLOAT3 Position;
@@ -0,0 +1,63 @@
+#pragma once
+#include <cuber/mesh.h>
+#include <span>
+#include <vulkan/vulkan.h>
+
+namespace vuloxr::vk {
+struct PhysicalDevice;
+}
+
+namespace cuber {
+namespace vk {
+
+// texture units of Pallete.Textures. sampler0, sampler1, sampler2
+const uint32_t TEXTURE_UNITS = 3;
+
+// Vulkan counterpart of gl3::GlCubeRenderer.
+// instances are written into a persistently mapped ring with sliceCount
+// slices and drawn with one vkCmdDrawIndexed.
+//
+//   VkCubeRenderer renderer(physicalDevice, device, renderPass, frameCount);
+//   ... wait the fence of the frame that used the slice
+//   auto instances = renderer.BeginInstances(frameIndex, count);
+//   ... fill instances
+//   ... vkCmdBeginRenderPass
+//   renderer.Render(cmd, projection, view);
+//
+class VkCubeRenderer
+{
+  struct VkCubeRendererImpl* m_impl = nullptr;
+
+public:
+  Pallete Pallete = {};
+  VkCubeRenderer(const VkCubeRenderer&) = delete;
+  VkCubeRenderer& operator=(const VkCubeRenderer&) = delete;
+  // renderPass has a color and a depth attachment. it is not owned.
+  // sliceCount is the number of frames that may be in flight.
+  VkCubeRenderer(const vuloxr::vk::PhysicalDevice& physicalDevice,
+                 VkDevice device,
+                 VkRenderPass renderPass,
+                 uint32_t sliceCount,
+                 VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+  ~VkCubeRenderer();
+  // not synchronized with the frames in flight. call while the gpu is idle
+  void UploadPallete();
+  // bind a texture to unit (Pallete.Textures[i].x). the image is in
+  // SHADER_READ_ONLY_OPTIMAL. VK_NULL_HANDLE binds a white texel again.
+  // not synchronized with the frames in flight. call while the gpu is idle
+  void SetTexture(uint32_t unit, VkImageView imageView, VkSampler sampler);
+
+  // map instanceCount instances of the slice `slice % sliceCount`.
+  // the gpu must have finished the frame that used this slice.
+  // grows the ring with vkDeviceWaitIdle if instanceCount does not fit.
+  std::span<Instance> BeginInstances(uint32_t slice, uint32_t instanceCount);
+  // record the instances of the last BeginInstances in a render pass.
+  // can be recorded more than once per slice, for each eye.
+  void Render(VkCommandBuffer cmd,
+              const float projection[16],
+              const float view[16]);
+  void Render(VkCommandBuffer cmd, const float viewProjection[16]);
+};
+
+}
+} // namespace cuber::vk
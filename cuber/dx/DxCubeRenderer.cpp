@@ -5,8 +5,9 @@
 
 namespace cuber::dx11 {
 
-DxCubeRenderer::DxCubeRenderer(const winrt::com_ptr<ID3D11Device>& device)
-  : m_impl(new DxCubeRendererImpl(device, false))
+DxCubeRenderer::DxCubeRenderer(const winrt::com_ptr<ID3D11Device>& device,
+                               InstanceFormat format)
+  : m_impl(new DxCubeRendererImpl(device, false, format))
 {
   m_impl->UploadPallete(Pallete);
 }
@@ -33,4 +34,18 @@ DxCubeRenderer::Render(const float projection[16],
   m_impl->Render(instanceCount);
 }
 
+void
+DxCubeRenderer::Render(const float projection[16],
+                       const float view[16],
+                       const CompactInstance* data,
+                       uint32_t instanceCount)
+{
+  if (m_impl->format_ != InstanceFormat::Compact) {
+    throw std::invalid_argument("cuber::DxCubeRenderer: InstanceFormat");
+  }
+  m_impl->UploadView(projection, view, nullptr, nullptr);
+  m_impl->UploadInstance(data, instanceCount);
+  m_impl->Render(instanceCount);
+}
+
 }
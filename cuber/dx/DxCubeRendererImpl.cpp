@@ -1,6 +1,7 @@
 #include <DirectXMath.h>
 
 #include "DxCubeRendererImpl.h"
+#include "cuber_compact_shader.h"
 #include "cuber_shader.h"
 #include "cuber_stereo_shader.h"
 #include <grapho/dx11/buffer.h>
@@ -12,13 +13,22 @@ namespace dx11 {
 
 DxCubeRendererImpl::DxCubeRendererImpl(
   const winrt::com_ptr<ID3D11Device>& device,
-  bool stereo)
+  bool stereo,
+  InstanceFormat format)
   : device_(device)
   , stereo_(stereo)
+  , format_(format)
 {
+  if (stereo_ && format_ == InstanceFormat::Compact) {
+    throw std::invalid_argument("cuber::DxCubeRendererImpl: stereo compact");
+  }
+
   device_->GetImmediateContext(context_.put());
 
-  std::string_view shader = stereo_ ? STEREO_SHADER : SHADER;
+  std::string_view shader = stereo_ ? STEREO_SHADER
+                            : format_ == InstanceFormat::Compact
+                              ? COMPACT_SHADER
+                              : SHADER;
   auto vs = grapho::dx11::CompileShader(shader, "vs_main", "vs_5_0");
   if (!vs) {
     OutputDebugStringA(vs.error().c_str());
@@ -39,16 +49,16 @@ DxCubeRendererImpl::DxCubeRendererImpl(
                                   pixel_shader_.put());
   assert(SUCCEEDED(hr));
 
-  auto [vertices, indices, layouts] = Cube(false, stereo_);
+  auto [vertices, indices, layouts] = Cube(false, stereo_, format_);
 
   auto vertex_buffer = grapho::dx11::CreateVertexBuffer(device_, vertices);
   instance_buffer_ = grapho::dx11::CreateVertexBuffer(
-    device_, sizeof(Instance) * 65535, nullptr);
+    device_, InstanceStride(format_) * 65535, nullptr);
   auto index_buffer = grapho::dx11::CreateIndexBuffer(device_, indices);
 
   grapho::dx11::VertexSlot slots[]{
     { .VertexBuffer = vertex_buffer, .Stride = sizeof(Vertex) },
-    { .VertexBuffer = instance_buffer_, .Stride = sizeof(Instance) },
+    { .VertexBuffer = instance_buffer_, .Stride = InstanceStride(format_) },
   };
 
   drawable_ =
@@ -105,12 +115,12 @@ DxCubeRendererImpl::UploadInstance(const void* data, uint32_t instanceCount)
     .left = 0,
     .top = 0,
     .front = 0,
-    .right = static_cast<uint32_t>(sizeof(Instance) * instanceCount),
+    .right = InstanceStride(format_) * instanceCount,
     .bottom = 1,
     .back = 1,
   };
   context_->UpdateSubresource(
-    instance_buffer_.get(), 0, &box, data, sizeof(Instance), 0);
+    instance_buffer_.get(), 0, &box, data, InstanceStride(format_), 0);
 }
 
 void
@@ -16,6 +16,7 @@ struct DxCubeRendererImpl
 {
   winrt::com_ptr<ID3D11Device> device_;
   bool stereo_;
+  InstanceFormat format_;
   winrt::com_ptr<ID3D11DeviceContext> context_;
   winrt::com_ptr<ID3D11VertexShader> vertex_shader_;
   winrt::com_ptr<ID3D11PixelShader> pixel_shader_;
@@ -24,7 +25,9 @@ struct DxCubeRendererImpl
   winrt::com_ptr<ID3D11Buffer> constant_buffer_;
   winrt::com_ptr<ID3D11Buffer> pallete_buffer_;
 
-  DxCubeRendererImpl(const winrt::com_ptr<ID3D11Device>& device, bool stereo);
+  DxCubeRendererImpl(const winrt::com_ptr<ID3D11Device>& device,
+                     bool stereo,
+                     InstanceFormat format = InstanceFormat::Matrix);
 
   void UploadPallete(const Pallete& pallete);
   void UploadView(const float projection[16],
@@ -0,0 +1,118 @@
+// InstanceFormat::Compact
+static auto COMPACT_SHADER = R"(
+#pragma pack_matrix(row_major)
+cbuffer c0 : register(b0)
+{
+float4x4 VP;
+};
+struct vs_in {
+    float4 pos: POSITION;
+    float4 uv_barycentric: TEXCOORD;
+    float3 translation: TRANSLATION;
+    uint rotation: ROTATION;
+    float4 scale: SCALE;
+    uint4 positiveXyzFlag: FACE0;
+    uint4 negativeXyzFlag: FACE1;
+    uint instanceID : SV_InstanceID;
+};
+struct vs_out {
+    float4 position_clip: SV_POSITION;
+    float4 uv_barycentric: TEXCOORD;
+    uint3 paletteFlagFlag: COLOR;
+};
+
+// quat_packer::Unpack
+float4 unpack_quat(uint packed)
+{
+  uint3 bits = uint3(packed, packed >> 10, packed >> 20) & 0x3ff;
+  float3 a = ((float3)bits / 1023.0 * 2.0 - 1.0) * 0.70710678;
+  float iss = sqrt(max(0.0, 1.0 - dot(a, a)));
+  uint drop = packed >> 30;
+  if(drop==0)
+  {
+    return float4(iss, a.x, a.y, a.z);
+  }
+  else if(drop==1)
+  {
+    return float4(a.x, iss, a.y, a.z);
+  }
+  else if(drop==2)
+  {
+    return float4(a.x, a.y, iss, a.z);
+  }
+  else{
+    return float4(a.x, a.y, a.z, iss);
+  }
+}
+
+float3 rotate(float4 q, float3 v)
+{
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+vs_out vs_main(vs_in IN) {
+  vs_out OUT = (vs_out)0; // zero the memory first
+  float3 local = IN.scale.xyz * IN.pos.xyz;
+  float3 world = IN.translation + rotate(unpack_quat(IN.rotation), local);
+  OUT.position_clip = mul(float4(world, 1), VP);
+  OUT.uv_barycentric = IN.uv_barycentric;
+  uint face = (uint)IN.pos.w;
+  uint palette = 0;
+  if(face<3)
+  {
+    palette = IN.positiveXyzFlag[face];
+  }
+  else if(face<6)
+  {
+    palette = IN.negativeXyzFlag[face - 3];
+  }
+  OUT.paletteFlagFlag = uint3(palette, 
+    IN.positiveXyzFlag.w,
+    IN.negativeXyzFlag.w);
+
+  return OUT;
+}
+
+cbuffer c1 : register(b1)
+{
+  float4 colors[32];
+  float4 textures[32];
+};
+Texture2D texture0;
+SamplerState sampler0;
+Texture2D texture1;
+SamplerState sampler1;
+Texture2D texture2;
+SamplerState sampler2;
+
+float grid (float2 vBC, float width) {
+  float3 bary = float3(vBC.x, vBC.y, 1.0 - vBC.x - vBC.y);
+  float3 d = fwidth(bary);
+  float3 a3 = smoothstep(d * (width - 0.5), d * (width + 0.5), bary);
+  return min(a3.x, a3.y);
+}
+
+float4 ps_main(vs_out IN) : SV_TARGET {
+  float value = grid(IN.uv_barycentric.zw, 1.0);
+  float4 border = float4(value, value, value, 1.0);
+  float4 color = colors[IN.paletteFlagFlag.x];
+  float4 texel;
+  if(textures[IN.paletteFlagFlag.x].x==0.0)
+  {
+    texel = texture0.Sample(sampler0, IN.uv_barycentric.xy);
+  }
+  else if(textures[IN.paletteFlagFlag.x].x==1.0)
+  {
+    texel = texture1.Sample(sampler1, IN.uv_barycentric.xy);
+  }
+  else if(textures[IN.paletteFlagFlag.x].x==2.0)
+  {
+    texel = texture2.Sample(sampler2, IN.uv_barycentric.xy);
+  }
+  else{
+    texel = float4(1, 1, 1, 1);
+  }
+
+  return texel * color * border;
+}
+)";
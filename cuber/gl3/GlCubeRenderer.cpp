@@ -1,9 +1,14 @@
 #include <DirectXMath.h>
 #include <GL/glew.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
 #include <cuber/gl3/GlCubeRenderer.h>
 #include <cuber/mesh.h>
 #include <grapho/gl3/error_check.h>
 #include <grapho/gl3/shader.h>
+#include <grapho/gl3/ssbo.h>
+#include <grapho/gl3/streambuffer.h>
 #include <grapho/gl3/ubo.h>
 #include <grapho/gl3/vao.h>
 
@@ -11,8 +16,28 @@ using namespace grapho::gl3;
 
 namespace cuber::gl3 {
 
+// multiple of 256. slice offsets satisfy
+// GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+const uint32_t INSTANCE_CAPACITY = 65536;
+const uint32_t INSTANCE_SLICE_COUNT = 3;
+const uint32_t CULL_LOCAL_SIZE = 64;
+// uniform block binding points
+const uint32_t PALETTE_BINDING = 1;
+const uint32_t STEREO_BINDING = 2;
+
+struct DrawElementsIndirectCommand
+{
+  uint32_t Count;
+  uint32_t InstanceCount;
+  uint32_t FirstIndex;
+  int32_t BaseVertex;
+  uint32_t BaseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20,
+              "sizeof DrawElementsIndirectCommand");
+
+// VP is declared by view_m_shadertext or multiview_m_shadertext
 static auto vertex_m_shadertext = u8R"(
-uniform mat4 VP;
 in vec4 vPosFace;
 in vec4 vUvBarycentric;
 in vec4 iRow0;
@@ -82,6 +107,235 @@ void main()
 }
 )";
 
+static auto view_m_shadertext = u8R"(
+uniform mat4 VP;
+)";
+
+// GL_OVR_multiview2. both eyes in one draw call
+static auto multiview_m_shadertext = u8R"(
+layout (num_views = 2) in;
+layout (std140) uniform stereo {
+  mat4 StereoVP[2];
+};
+#define VP StereoVP[gl_ViewID_OVR]
+)";
+
+// InstanceFormat::Compact
+static auto compact_vertex_m_shadertext = u8R"(
+layout (location = 0) in vec4 vPosFace;
+layout (location = 1) in vec4 vUvBarycentric;
+layout (location = 2) in vec3 iTranslation;
+layout (location = 3) in uint iRotation;
+layout (location = 4) in vec4 iScale;
+layout (location = 5) in uvec4 iPositive_xyz_flag;
+layout (location = 6) in uvec4 iNegative_xyz_flag;
+out vec4 oUvBarycentric;
+flat out uvec3 o_Palette_Flag_Flag;
+
+// quat_packer::Unpack
+vec4 unpack_quat(uint packed)
+{
+  uvec3 bits = uvec3(packed, packed >> 10, packed >> 20) & uvec3(0x3ffu);
+  vec3 a = (vec3(bits) / 1023.0 * 2.0 - 1.0) * 0.70710678;
+  float iss = sqrt(max(0.0, 1.0 - dot(a, a)));
+  uint drop = packed >> 30;
+  if(drop==0u)
+  {
+    return vec4(iss, a.x, a.y, a.z);
+  }
+  else if(drop==1u)
+  {
+    return vec4(a.x, iss, a.y, a.z);
+  }
+  else if(drop==2u)
+  {
+    return vec4(a.x, a.y, iss, a.z);
+  }
+  else{
+    return vec4(a.x, a.y, a.z, iss);
+  }
+}
+
+vec3 rotate(vec4 q, vec3 v)
+{
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    vec3 local = iScale.xyz * vPosFace.xyz;
+    vec3 world = iTranslation + rotate(unpack_quat(iRotation), local);
+    gl_Position = VP * vec4(world, 1);
+    oUvBarycentric = vUvBarycentric;
+    uint face = uint(vPosFace.w);
+    uint palette = 0u;
+    if(face<3u)
+    {
+      palette = iPositive_xyz_flag[face];
+    }
+    else if(face<6u)
+    {
+      palette = iNegative_xyz_flag[face - 3u];
+    }
+    o_Palette_Flag_Flag = uvec3(palette, 
+      iPositive_xyz_flag.w,
+      iNegative_xyz_flag.w);
+}
+)";
+
+// test the aabb of each unit cube against the frusta (left, right).
+// copy visible instances to Dst and count them in Command.instanceCount.
+static auto cull_m_shadertext = u8R"(
+layout (local_size_x = 64) in;
+
+struct DrawElementsIndirectCommand
+{
+  uint count;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Src { uint src[]; };
+layout (std430, binding = 1) writeonly buffer Dst { uint dst[]; };
+layout (std430, binding = 2) buffer Command { DrawElementsIndirectCommand command; };
+
+uniform uint InstanceCount;
+// 6 for mono, 12 for stereo
+uniform uint PlaneCount;
+uniform vec4 Planes[12];
+
+#ifdef COMPACT
+const uint STRIDE = 8u;
+
+vec4 unpack_quat(uint packed)
+{
+  uvec3 bits = uvec3(packed, packed >> 10, packed >> 20) & uvec3(0x3ffu);
+  vec3 a = (vec3(bits) / 1023.0 * 2.0 - 1.0) * 0.70710678;
+  float iss = sqrt(max(0.0, 1.0 - dot(a, a)));
+  uint drop = packed >> 30;
+  if(drop==0u)
+  {
+    return vec4(iss, a.x, a.y, a.z);
+  }
+  else if(drop==1u)
+  {
+    return vec4(a.x, iss, a.y, a.z);
+  }
+  else if(drop==2u)
+  {
+    return vec4(a.x, a.y, iss, a.z);
+  }
+  else{
+    return vec4(a.x, a.y, a.z, iss);
+  }
+}
+
+vec3 rotate(vec4 q, vec3 v)
+{
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void aabb(uint base, out vec3 center, out vec3 extent)
+{
+  center = uintBitsToFloat(uvec3(src[base], src[base + 1u], src[base + 2u]));
+  vec4 q = unpack_quat(src[base + 3u]);
+  vec3 s = vec3(unpackHalf2x16(src[base + 4u]), unpackHalf2x16(src[base + 5u]).x);
+  extent = 0.5 * (abs(rotate(q, vec3(s.x, 0, 0)))
+                + abs(rotate(q, vec3(0, s.y, 0)))
+                + abs(rotate(q, vec3(0, 0, s.z))));
+}
+#else
+const uint STRIDE = 24u;
+
+vec3 row(uint base, uint i)
+{
+  return uintBitsToFloat(uvec3(src[base + i * 4u], src[base + i * 4u + 1u], src[base + i * 4u + 2u]));
+}
+
+void aabb(uint base, out vec3 center, out vec3 extent)
+{
+  center = row(base, 3u);
+  extent = 0.5 * (abs(row(base, 0u)) + abs(row(base, 1u)) + abs(row(base, 2u)));
+}
+#endif
+
+bool inside(uint first, vec3 center, vec3 extent)
+{
+  for(uint i=0u; i<6u; ++i)
+  {
+    vec4 plane = Planes[first + i];
+    if(dot(plane.xyz, center) + plane.w + dot(abs(plane.xyz), extent) < 0.0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void main()
+{
+  uint index = gl_GlobalInvocationID.x;
+  if(index>=InstanceCount)
+  {
+    return;
+  }
+  uint base = index * STRIDE;
+  vec3 center;
+  vec3 extent;
+  aabb(base, center, extent);
+
+  bool visible = false;
+  for(uint first=0u; first<PlaneCount; first+=6u)
+  {
+    if(inside(first, center, extent))
+    {
+      visible = true;
+      break;
+    }
+  }
+  if(!visible)
+  {
+    return;
+  }
+
+  uint dst_base = atomicAdd(command.instanceCount, 1u) * STRIDE;
+  for(uint i=0u; i<STRIDE; ++i)
+  {
+    dst[dst_base + i] = src[base + i];
+  }
+}
+)";
+
+// row vector. clip = world * view * projection.
+// normals point inside. not normalized.
+static void
+FrustumPlanes(const float projection[16],
+              const float view[16],
+              DirectX::XMFLOAT4 planes[6])
+{
+  auto v = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)view);
+  auto p = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)projection);
+  DirectX::XMFLOAT4X4 m;
+  DirectX::XMStoreFloat4x4(&m, v * p);
+  auto column = [&m](int j) {
+    return DirectX::XMVectorSet(m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j]);
+  };
+  auto w = column(3);
+  DirectX::XMVECTOR list[] = {
+    DirectX::XMVectorAdd(w, column(0)),      // left
+    DirectX::XMVectorSubtract(w, column(0)), // right
+    DirectX::XMVectorAdd(w, column(1)),      // bottom
+    DirectX::XMVectorSubtract(w, column(1)), // top
+    DirectX::XMVectorAdd(w, column(2)),      // near. -w < z (conservative)
+    DirectX::XMVectorSubtract(w, column(2)), // far
+  };
+  for (int i = 0; i < 6; ++i) {
+    DirectX::XMStoreFloat4(&planes[i], list[i]);
+  }
+}
+
 static auto fragment_m_shadertext = u8R"(
 in vec4 oUvBarycentric;
 flat in uvec3 o_Palette_Flag_Flag;
@@ -128,55 +382,55 @@ void main()
 }
 )";
 
-GlCubeRenderer::GlCubeRenderer()
+static std::shared_ptr<ShaderProgram>
+CreateShader(InstanceFormat format, bool multiview)
 {
-
   // auto glsl_version = "#version 150";
   auto glsl_version = u8"#version 310 es\nprecision highp float;";
+  // #extension must come before any non-preprocessor token
+  auto multiview_glsl_version = u8"#version 310 es\n"
+                                u8"#extension GL_OVR_multiview2 : require\n"
+                                u8"precision highp float;";
 
   std::u8string_view vs[] = {
-    glsl_version,
+    multiview ? multiview_glsl_version : glsl_version,
     u8"\n",
-    vertex_m_shadertext,
+    multiview ? multiview_m_shadertext : view_m_shadertext,
+    format == InstanceFormat::Compact ? compact_vertex_m_shadertext
+                                      : vertex_m_shadertext,
   };
   std::u8string_view fs[] = {
     glsl_version,
     u8"\n",
     fragment_m_shadertext,
   };
-  if (auto shader = ShaderProgram::Create(vs, fs)) {
+  return ShaderProgram::Create(vs, fs);
+}
+
+GlCubeRenderer::GlCubeRenderer(InstanceFormat format)
+  : m_format(format)
+{
+  if (auto shader = CreateShader(m_format, false)) {
     m_shader = shader;
   } else {
     throw std::runtime_error(::grapho::GetErrorString());
   }
 
-  auto [vertices, indices, layouts] = Cube(true, false);
+  auto [vertices, indices, layouts] = Cube(true, false, m_format);
+  m_layouts = layouts;
 
-  auto vbo = Vbo::Create(sizeof(Vertex) * vertices.size(), vertices.data());
-  if (!vbo) {
+  m_vbo = Vbo::Create(sizeof(Vertex) * vertices.size(), vertices.data());
+  if (!m_vbo) {
     throw std::runtime_error("cuber::Vbo::Create");
   }
 
-  m_instance_vbo = Vbo::Create(sizeof(float) * 16 * 65535, nullptr);
-  if (!m_instance_vbo) {
-    throw std::runtime_error("cuber::Vbo::Create: m_instance_vbo");
-  }
-
-  std::shared_ptr<grapho::gl3::Vbo> slots[] = {
-    vbo,            //
-    m_instance_vbo, //
-  };
-
-  auto ibo = Ibo::Create(
+  m_ibo = Ibo::Create(
     sizeof(uint32_t) * indices.size(), indices.data(), GL_UNSIGNED_INT);
-  if (!ibo) {
+  if (!m_ibo) {
     throw std::runtime_error("cuber::Vbo::Create");
   }
-  m_vao =
-    Vao::Create(grapho::make_span(layouts), grapho::make_span(slots), ibo);
-  if (!m_vao) {
-    throw std::runtime_error("cuber::Vao::Create");
-  }
+
+  ReserveInstances(INSTANCE_CAPACITY);
 
   m_ubo = Ubo::Create(sizeof(Pallete), &Pallete);
 }
@@ -190,12 +444,219 @@ GlCubeRenderer::UploadPallete()
 }
 
 void
-GlCubeRenderer::Render(const float projection[16],
-                       const float view[16],
-                       const Instance* data,
-                       uint32_t instanceCount)
+GlCubeRenderer::ReserveInstances(uint32_t instanceCount)
 {
+  if (m_instances && instanceCount <= m_instances->Capacity()) {
+    return;
+  }
+
+  auto capacity = INSTANCE_CAPACITY;
+  if (m_instances) {
+    capacity = std::max(instanceCount, m_instances->Capacity() * 2);
+    capacity = (capacity + 255) / 256 * 256;
+  }
+  auto stride = InstanceStride(m_format);
+  auto instances =
+    StreamBuffer::Create(stride, capacity, INSTANCE_SLICE_COUNT);
+  if (!instances) {
+    throw std::runtime_error("cuber::StreamBuffer::Create: m_instances");
+  }
+
+  std::shared_ptr<grapho::gl3::Vbo> slots[] = {
+    m_vbo,                 //
+    instances->GetVbo(),   //
+  };
+
+  std::vector<std::shared_ptr<Vao>> vaos;
+  for (uint32_t i = 0; i < instances->SliceCount(); ++i) {
+    auto layouts = m_layouts;
+    for (auto& layout : layouts) {
+      if (layout.Id.Slot == 1) {
+        layout.Offset += instances->SliceOffset(i);
+      }
+    }
+    auto vao =
+      Vao::Create(grapho::make_span(layouts), grapho::make_span(slots), m_ibo);
+    if (!vao) {
+      throw std::runtime_error("cuber::Vao::Create");
+    }
+    vaos.push_back(vao);
+  }
+
+  m_instances = instances;
+  m_vaos = vaos;
+  m_instanceCount = 0;
+
+  // culling output
+  m_visible = Vbo::Create(stride * capacity, nullptr);
+  if (!m_visible) {
+    throw std::runtime_error("cuber::Vbo::Create: m_visible");
+  }
+  std::shared_ptr<grapho::gl3::Vbo> visibleSlots[] = {
+    m_vbo,     //
+    m_visible, //
+  };
+  m_visibleVao = Vao::Create(
+    grapho::make_span(m_layouts), grapho::make_span(visibleSlots), m_ibo);
+  if (!m_visibleVao) {
+    throw std::runtime_error("cuber::Vao::Create");
+  }
+  if (m_commands.empty()) {
+    for (uint32_t i = 0; i < m_instances->SliceCount(); ++i) {
+      m_commands.push_back(
+        Ssbo::Create(sizeof(DrawElementsIndirectCommand), nullptr));
+    }
+  }
+  // fences of the old ring are gone
+  m_cullSubmitted.assign(m_instances->SliceCount(), 0);
+  m_culled = false;
+}
+
+void
+GlCubeRenderer::ReadCullingStats()
+{
+  auto slice = m_instances->Slice();
+  if (m_cullSubmitted[slice] == 0) {
+    return;
+  }
+  // the fence of this slice has been signaled. no stall
+  DrawElementsIndirectCommand command;
+  if (m_commands[slice]->Read(sizeof(command), &command)) {
+    m_cullingStats = {
+      .Visible = command.InstanceCount,
+      .Culled = m_cullSubmitted[slice] - command.InstanceCount,
+    };
+  }
+  m_cullSubmitted[slice] = 0;
+}
+
+void*
+GlCubeRenderer::MapInstances(InstanceFormat format, uint32_t instanceCount)
+{
+  if (format != m_format) {
+    throw std::invalid_argument("cuber::GlCubeRenderer: InstanceFormat");
+  }
   if (instanceCount == 0) {
+    // an empty scene. a zero length glMapBufferRange fails, so do not map
+    m_instanceCount = 0;
+    m_culled = false;
+    return nullptr;
+  }
+  ReserveInstances(instanceCount);
+  auto p = m_instances->Begin(instanceCount);
+  if (!p) {
+    throw std::runtime_error("cuber::StreamBuffer::Begin");
+  }
+  ReadCullingStats();
+  m_instanceCount = instanceCount;
+  m_culled = false;
+  return p;
+}
+
+std::span<Instance>
+GlCubeRenderer::BeginInstances(uint32_t instanceCount)
+{
+  return { static_cast<Instance*>(
+             MapInstances(InstanceFormat::Matrix, instanceCount)),
+           instanceCount };
+}
+
+std::span<CompactInstance>
+GlCubeRenderer::BeginCompactInstances(uint32_t instanceCount)
+{
+  return { static_cast<CompactInstance*>(
+             MapInstances(InstanceFormat::Compact, instanceCount)),
+           instanceCount };
+}
+
+void
+GlCubeRenderer::EndInstances()
+{
+  m_instances->End();
+}
+
+bool
+GlCubeRenderer::Cull(const DirectX::XMFLOAT4* planes, uint32_t planeCount)
+{
+  m_culled = false;
+  if (m_instanceCount == 0) {
+    return true;
+  }
+
+  if (!m_cull) {
+    if (m_cullUnsupported) {
+      return false;
+    }
+    auto glsl_version = u8"#version 310 es\nprecision highp float;";
+    std::u8string_view cs[] = {
+      glsl_version,
+      u8"\n",
+      m_format == InstanceFormat::Compact ? u8"#define COMPACT\n" : u8"",
+      cull_m_shadertext,
+    };
+    m_cull = ShaderProgram::CreateCompute(cs);
+    if (!m_cull) {
+      m_cullUnsupported = true;
+      return false;
+    }
+  }
+
+  auto slice = m_instances->Slice();
+  m_commands[slice]->Upload(DrawElementsIndirectCommand{
+    .Count = CUBE_INDEX_COUNT,
+    .InstanceCount = 0,
+    .FirstIndex = 0,
+    .BaseVertex = 0,
+    .BaseInstance = 0,
+  });
+
+  m_cull->Use();
+  m_cull->SetUniform("InstanceCount", m_instanceCount);
+  m_cull->SetUniform("PlaneCount", planeCount);
+  if (auto var = m_cull->Uniform("Planes")) {
+    glUniform4fv(var->Location, planeCount, &planes[0].x);
+  }
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+                    0,
+                    m_instances->GetVbo()->Handle(),
+                    m_instances->SliceOffset(),
+                    m_instances->Stride() * m_instanceCount);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_visible->Handle());
+  m_commands[slice]->SetBindingPoint(2);
+  glDispatchCompute(
+    (m_instanceCount + CULL_LOCAL_SIZE - 1) / CULL_LOCAL_SIZE, 1, 1);
+  glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+  m_cull->UnUse();
+
+  m_cullSubmitted[slice] = m_instanceCount;
+  m_culled = true;
+  return true;
+}
+
+bool
+GlCubeRenderer::Cull(const float projection[16], const float view[16])
+{
+  DirectX::XMFLOAT4 planes[6];
+  FrustumPlanes(projection, view, planes);
+  return Cull(planes, 6);
+}
+
+bool
+GlCubeRenderer::Cull(const float leftProjection[16],
+                     const float leftView[16],
+                     const float rightProjection[16],
+                     const float rightView[16])
+{
+  DirectX::XMFLOAT4 planes[12];
+  FrustumPlanes(leftProjection, leftView, planes);
+  FrustumPlanes(rightProjection, rightView, planes + 6);
+  return Cull(planes, 12);
+}
+
+void
+GlCubeRenderer::Render(const float projection[16], const float view[16])
+{
+  if (m_instanceCount == 0) {
     return;
   }
   glEnable(GL_DEPTH_TEST);
@@ -208,13 +669,114 @@ GlCubeRenderer::Render(const float projection[16],
 
   m_shader->Use();
   m_shader->SetUniform("VP", vp);
+  Draw(*m_shader);
+}
+
+bool
+GlCubeRenderer::InitStereo()
+{
+  if (m_stereoShader) {
+    return true;
+  }
+  if (m_stereoUnsupported) {
+    return false;
+  }
+  if (!GLEW_OVR_multiview2) {
+    m_stereoUnsupported = true;
+    return false;
+  }
+  m_stereoShader = CreateShader(m_format, true);
+  if (!m_stereoShader) {
+    m_stereoUnsupported = true;
+    return false;
+  }
+  m_stereoUbo = Ubo::Create(sizeof(DirectX::XMFLOAT4X4) * 2, nullptr);
+  return true;
+}
+
+bool
+GlCubeRenderer::RenderStereo(const float leftProjection[16],
+                             const float leftView[16],
+                             const float rightProjection[16],
+                             const float rightView[16])
+{
+  if (!InitStereo()) {
+    return false;
+  }
+
+  if (m_instanceCount == 0) {
+    return true;
+  }
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  DirectX::XMFLOAT4X4 vp[2];
+  auto lv = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)leftView);
+  auto lp =
+    DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)leftProjection);
+  DirectX::XMStoreFloat4x4(&vp[0], lv * lp);
+  auto rv = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)rightView);
+  auto rp =
+    DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)rightProjection);
+  DirectX::XMStoreFloat4x4(&vp[1], rv * rp);
+  m_stereoUbo->Upload(vp);
+
+  m_stereoShader->Use();
+  auto block_index = m_stereoShader->UboBlockIndex("stereo");
+  m_stereoShader->UboBind(*block_index, STEREO_BINDING);
+  m_stereoUbo->SetBindingPoint(STEREO_BINDING);
+  Draw(*m_stereoShader);
+  return true;
+}
+
+void
+GlCubeRenderer::Draw(ShaderProgram& shader)
+{
+  auto block_index = shader.UboBlockIndex("palette");
+  shader.UboBind(*block_index, PALETTE_BINDING);
+  m_ubo->SetBindingPoint(PALETTE_BINDING);
 
-  auto block_index = m_shader->UboBlockIndex("palette");
-  m_shader->UboBind(*block_index, 1);
-  m_ubo->SetBindingPoint(1);
+  if (m_culled) {
+    auto& command = m_commands[m_instances->Slice()];
+    command->BindIndirect();
+    m_visibleVao->DrawIndirect();
+    command->UnbindIndirect();
+  } else {
+    m_vaos[m_instances->Slice()]->DrawInstance(
+      m_instanceCount, CUBE_INDEX_COUNT, 0);
+  }
+}
+
+void
+GlCubeRenderer::Render(const float projection[16],
+                       const float view[16],
+                       const Instance* data,
+                       uint32_t instanceCount)
+{
+  if (instanceCount == 0) {
+    m_instanceCount = 0;
+    return;
+  }
+  auto instances = BeginInstances(instanceCount);
+  memcpy(instances.data(), data, sizeof(Instance) * instanceCount);
+  EndInstances();
+  Render(projection, view);
+}
 
-  m_instance_vbo->Upload(sizeof(Instance) * instanceCount, data);
-  m_vao->DrawInstance(instanceCount, CUBE_INDEX_COUNT, 0);
+void
+GlCubeRenderer::Render(const float projection[16],
+                       const float view[16],
+                       const CompactInstance* data,
+                       uint32_t instanceCount)
+{
+  if (instanceCount == 0) {
+    m_instanceCount = 0;
+    return;
+  }
+  auto instances = BeginCompactInstances(instanceCount);
+  memcpy(instances.data(), data, sizeof(CompactInstance) * instanceCount);
+  EndInstances();
+  Render(projection, view);
 }
 
 } // namespace cuber::gl3
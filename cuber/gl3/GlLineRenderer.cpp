@@ -4,14 +4,29 @@
 #include <cuber/mesh.h>
 #include <grapho/gl3/error_check.h>
 #include <grapho/gl3/shader.h>
+#include <grapho/gl3/ubo.h>
 #include <grapho/gl3/vao.h>
 
 using namespace grapho::gl3;
 
 namespace cuber::gl3 {
 
-static auto vertex_shader_text = u8R"(
+const uint32_t STEREO_BINDING = 2;
+
+static auto view_shader_text = u8R"(
 uniform mat4 VP;
+)";
+
+// GL_OVR_multiview2
+static auto multiview_shader_text = u8R"(
+layout (num_views = 2) in;
+layout (std140) uniform stereo {
+  mat4 StereoVP[2];
+};
+#define VP StereoVP[gl_ViewID_OVR]
+)";
+
+static auto vertex_shader_text = u8R"(
 in vec3 vPos;
 in vec4 vColor;
 out vec4 color;
@@ -33,15 +48,19 @@ void main()
 }
 )";
 
-GlLineRenderer::GlLineRenderer()
+static std::shared_ptr<ShaderProgram>
+CreateShader(bool multiview)
 {
-
   // auto glsl_version = "#version 150";
   auto glsl_version = u8"#version 310 es\nprecision highp float;";
+  auto multiview_glsl_version = u8"#version 310 es\n"
+                                u8"#extension GL_OVR_multiview2 : require\n"
+                                u8"precision highp float;";
 
   std::u8string_view vs[] = {
-    glsl_version,
+    multiview ? multiview_glsl_version : glsl_version,
     u8"\n",
+    multiview ? multiview_shader_text : view_shader_text,
     vertex_shader_text,
   };
   std::u8string_view fs[] = {
@@ -49,7 +68,12 @@ GlLineRenderer::GlLineRenderer()
     u8"\n",
     fragment_shader_text,
   };
-  if (auto shader = ShaderProgram::Create(vs, fs)) {
+  return ShaderProgram::Create(vs, fs);
+}
+
+GlLineRenderer::GlLineRenderer()
+{
+  if (auto shader = CreateShader(false)) {
     shader_ = shader;
   } else {
     throw std::runtime_error(grapho::GetErrorString());
@@ -119,4 +143,64 @@ GlLineRenderer::Render(const float projection[16],
   vao_->Draw(GL_LINES, lines.size(), 0);
 }
 
+bool
+GlLineRenderer::InitStereo()
+{
+  if (stereoShader_) {
+    return true;
+  }
+  if (stereoUnsupported_) {
+    return false;
+  }
+  if (!GLEW_OVR_multiview2) {
+    stereoUnsupported_ = true;
+    return false;
+  }
+  stereoShader_ = CreateShader(true);
+  if (!stereoShader_) {
+    stereoUnsupported_ = true;
+    return false;
+  }
+  stereoUbo_ = Ubo::Create(sizeof(DirectX::XMFLOAT4X4) * 2, nullptr);
+  return true;
+}
+
+bool
+GlLineRenderer::RenderStereo(const float leftProjection[16],
+                             const float leftView[16],
+                             const float rightProjection[16],
+                             const float rightView[16],
+                             std::span<const LineVertex> lines)
+{
+  if (!InitStereo()) {
+    return false;
+  }
+
+  if (lines.empty()) {
+    return true;
+  }
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  DirectX::XMFLOAT4X4 vp[2];
+  auto lv = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)leftView);
+  auto lp =
+    DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)leftProjection);
+  DirectX::XMStoreFloat4x4(&vp[0], lv * lp);
+  auto rv = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)rightView);
+  auto rp =
+    DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)rightProjection);
+  DirectX::XMStoreFloat4x4(&vp[1], rv * rp);
+  stereoUbo_->Upload(vp);
+
+  stereoShader_->Use();
+  auto block_index = stereoShader_->UboBlockIndex("stereo");
+  stereoShader_->UboBind(*block_index, STEREO_BINDING);
+  stereoUbo_->SetBindingPoint(STEREO_BINDING);
+
+  vbo_->Upload(sizeof(LineVertex) * lines.size(), lines.data());
+  vao_->Draw(GL_LINES, lines.size(), 0);
+  return true;
+}
+
 } // namespace cuber::gl3
@@ -21,6 +21,30 @@ DxgiFormat(const grapho::VertexLayout& layout)
         case 4:
           return DXGI_FORMAT_R32G32B32A32_FLOAT;
       }
+      break;
+
+    case grapho::ValueType::Half:
+      switch (layout.Count) {
+        case 2:
+          return DXGI_FORMAT_R16G16_FLOAT;
+        case 4:
+          return DXGI_FORMAT_R16G16B16A16_FLOAT;
+      }
+      break;
+
+    case grapho::ValueType::UInt8:
+      switch (layout.Count) {
+        case 4:
+          return DXGI_FORMAT_R8G8B8A8_UINT;
+      }
+      break;
+
+    case grapho::ValueType::UInt32:
+      switch (layout.Count) {
+        case 1:
+          return DXGI_FORMAT_R32_UINT;
+      }
+      break;
   }
   throw std::invalid_argument("not implemented");
 }
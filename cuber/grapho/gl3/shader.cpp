@@ -71,4 +71,27 @@ link(GLuint vs, GLuint fs, GLuint gs)
   return program;
 }
 
+std::optional<GLuint>
+link_compute(GLuint cs)
+{
+  GLuint program = glCreateProgram();
+  glAttachShader(program, cs);
+  glLinkProgram(program);
+
+  GLint isLinked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+  if (isLinked == GL_FALSE) {
+    GLint maxLength = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+
+    std::string infoLog;
+    infoLog.resize(maxLength);
+    glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
+
+    glDeleteProgram(program);
+    return {};
+  }
+  return program;
+}
+
 } // namespace
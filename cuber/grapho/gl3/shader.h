@@ -19,6 +19,9 @@ compile(GLenum shaderType, std::span<std::u8string_view> srcs);
 std::optional<GLuint>
 link(GLuint vs, GLuint fs, GLuint gs = 0);
 
+std::optional<GLuint>
+link_compute(GLuint cs);
+
 template<typename T>
 concept Float3 = sizeof(T) == sizeof(float) * 3;
 template<typename T>
@@ -42,6 +45,8 @@ struct UniformVariable
 
   void Set(float value) const { glUniform1f(Location, value); }
 
+  void Set(uint32_t value) const { glUniform1ui(Location, value); }
+
   // 12 byte
   template<Float3 T>
   void Set(const T& t) const
@@ -199,6 +204,24 @@ public:
     }
   }
 
+  // GLES 3.1 or GL 4.3
+  static std::shared_ptr<ShaderProgram> CreateCompute(
+    std::span<std::u8string_view> cs_srcs)
+  {
+    auto cs = compile(GL_COMPUTE_SHADER, cs_srcs);
+    if (!cs) {
+      DebugWrite("debug.comp", cs_srcs);
+      return {};
+    }
+
+    auto program = link_compute(*cs);
+    if (!program) {
+      return {};
+    }
+
+    return std::shared_ptr<ShaderProgram>(new ShaderProgram(*program));
+  }
+
   static std::shared_ptr<ShaderProgram> CreateFromPath(
     const std::string& vs_path,
     const std::string& fs_path,
@@ -257,6 +280,13 @@ public:
     }
   }
 
+  void SetUniform(const std::string& name, uint32_t value) const
+  {
+    if (auto var = Uniform(name)) {
+      var->Set(value);
+    }
+  }
+
   std::optional<uint32_t> UboBlockIndex(const char* name)
   {
     auto blockIndex = glGetUniformBlockIndex(program_, name);
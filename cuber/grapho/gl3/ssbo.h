@@ -0,0 +1,68 @@
+#pragma once
+#include <GL/glew.h>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+// GL_SHADER_STORAGE_BUFFER. also used as GL_DRAW_INDIRECT_BUFFER
+struct Ssbo
+{
+  uint32_t ssbo_ = 0;
+
+  Ssbo() = default;
+  Ssbo(const Ssbo&) = delete;
+  Ssbo& operator=(const Ssbo&) = delete;
+  ~Ssbo() { glDeleteBuffers(1, &ssbo_); }
+
+  static std::shared_ptr<Ssbo> Create(uint32_t size, const void* data)
+  {
+    auto ptr = std::make_shared<Ssbo>();
+
+    glGenBuffers(1, &ptr->ssbo_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ptr->ssbo_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return ptr;
+  }
+
+  void Bind() { glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_); }
+  void Unbind() { glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); }
+  void Upload(uint32_t size, const void* data)
+  {
+    Bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+    Unbind();
+  }
+  template<typename T>
+  void Upload(const T& data)
+  {
+    Upload(sizeof(T), &data);
+  }
+  // the caller must make sure that the gpu has finished writing.
+  // e.g. a fence has been signaled.
+  bool Read(uint32_t size, void* data)
+  {
+    Bind();
+    auto p =
+      glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (p) {
+      memcpy(data, p, size);
+      glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
+    Unbind();
+    return p != nullptr;
+  }
+  void SetBindingPoint(uint32_t binding_point)
+  {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_point, ssbo_);
+  }
+  void BindIndirect() { glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ssbo_); }
+  void UnbindIndirect() { glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0); }
+};
+
+}
+}
@@ -0,0 +1,93 @@
+#include <GL/glew.h>
+
+#include "streambuffer.h"
+
+namespace grapho {
+namespace gl3 {
+
+StreamBuffer::StreamBuffer(const std::shared_ptr<gl3::Vbo>& vbo,
+                           uint32_t stride,
+                           uint32_t capacity,
+                           uint32_t sliceCount)
+  : vbo_(vbo)
+  , stride_(stride)
+  , capacity_(capacity)
+  , fences_(sliceCount, nullptr)
+{
+}
+
+StreamBuffer::~StreamBuffer()
+{
+  if (writing_) {
+    vbo_->Unmap();
+  }
+  for (auto fence : fences_) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+}
+
+std::shared_ptr<StreamBuffer>
+StreamBuffer::Create(uint32_t stride, uint32_t capacity, uint32_t sliceCount)
+{
+  if (stride == 0 || capacity == 0 || sliceCount == 0) {
+    return {};
+  }
+  auto size = stride * capacity * sliceCount;
+  auto vbo = Vbo::CreatePersistent(size);
+  if (!vbo) {
+    // fallback to glMapBufferRange(GL_MAP_UNSYNCHRONIZED_BIT) every frame
+    vbo = Vbo::Create(size, nullptr);
+  }
+  if (!vbo) {
+    return {};
+  }
+  return std::shared_ptr<StreamBuffer>(
+    new StreamBuffer(vbo, stride, capacity, sliceCount));
+}
+
+void*
+StreamBuffer::Begin(uint32_t count)
+{
+  if (count > capacity_) {
+    return nullptr;
+  }
+
+  if (pending_) {
+    // all draw calls that read the current slice are already queued
+    fences_[slice_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slice_ = (slice_ + 1) % fences_.size();
+    pending_ = false;
+  }
+
+  if (auto fence = fences_[slice_]) {
+    while (true) {
+      auto result =
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED ||
+          result == GL_WAIT_FAILED) {
+        break;
+      }
+    }
+    glDeleteSync(fence);
+    fences_[slice_] = nullptr;
+  }
+
+  auto p = vbo_->Map(SliceOffset(), count * stride_);
+  writing_ = p != nullptr;
+  return p;
+}
+
+void
+StreamBuffer::End()
+{
+  if (writing_) {
+    vbo_->Unmap();
+    writing_ = false;
+  }
+  pending_ = true;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,65 @@
+#pragma once
+#include "vao.h"
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+struct __GLsync;
+
+namespace grapho {
+namespace gl3 {
+
+// Ring of SliceCount slices of Capacity elements in one Vbo.
+// Each slice is guarded by a fence, so the cpu never writes memory that the
+// gpu is still reading and the driver never has to orphan the buffer.
+//
+//   auto p = stream->Begin(count); // wait fence of the next slice
+//   memcpy(p, ...);
+//   stream->End();                 // unmap (if not persistent)
+//   draw with stream->SliceOffset() ...
+//   stream->Begin(count);          // fence previous slice and advance
+class StreamBuffer
+{
+  std::shared_ptr<Vbo> vbo_;
+  uint32_t stride_ = 0;
+  uint32_t capacity_ = 0;
+  std::vector<__GLsync*> fences_;
+  uint32_t slice_ = 0;
+  bool writing_ = false;
+  bool pending_ = false;
+
+  StreamBuffer(const std::shared_ptr<Vbo>& vbo,
+               uint32_t stride,
+               uint32_t capacity,
+               uint32_t sliceCount);
+
+public:
+  ~StreamBuffer();
+  StreamBuffer(const StreamBuffer&) = delete;
+  StreamBuffer& operator=(const StreamBuffer&) = delete;
+  static std::shared_ptr<StreamBuffer> Create(uint32_t stride,
+                                              uint32_t capacity,
+                                              uint32_t sliceCount = 3);
+
+  const std::shared_ptr<gl3::Vbo>& GetVbo() const { return vbo_; }
+  bool IsPersistent() const { return vbo_->Mapped() != nullptr; }
+  uint32_t Stride() const { return stride_; }
+  uint32_t Capacity() const { return capacity_; }
+  uint32_t SliceCount() const { return static_cast<uint32_t>(fences_.size()); }
+  uint32_t Slice() const { return slice_; }
+  uint32_t SliceOffset(uint32_t slice) const
+  {
+    return slice * capacity_ * stride_;
+  }
+  uint32_t SliceOffset() const { return SliceOffset(slice_); }
+
+  // fence the slice written by the last Begin/End, advance to the next slice
+  // and wait until the gpu has released it.
+  // return nullptr if count exceeds Capacity. count must not be 0: the map
+  // fallback of a non persistent buffer fails for an empty range.
+  void* Begin(uint32_t count);
+  void End();
+};
+
+} // namespace
+} // namespace
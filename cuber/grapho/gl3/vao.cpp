@@ -14,6 +14,8 @@ GLType(ValueType type)
       return GL_FLOAT;
     case ValueType::Double:
       return GL_DOUBLE;
+    case ValueType::Half:
+      return GL_HALF_FLOAT;
 
     case ValueType::Int8:
       return GL_BYTE;
@@ -33,6 +35,23 @@ GLType(ValueType type)
   return {};
 }
 
+bool
+IsIntegerType(ValueType type)
+{
+  switch (type) {
+    case ValueType::Int8:
+    case ValueType::Int16:
+    case ValueType::Int32:
+    case ValueType::UInt8:
+    case ValueType::UInt16:
+    case ValueType::UInt32:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 std::optional<uint32_t>
 GLIndexTypeFromStride(uint32_t stride)
 {
@@ -73,6 +92,11 @@ Vbo::Vbo(uint32_t vbo)
 
 Vbo::~Vbo()
 {
+  if (mapped_) {
+    Bind();
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    Unbind();
+  }
   glDeleteBuffers(1, &vbo_);
 }
 std::shared_ptr<Vbo>
@@ -91,6 +115,26 @@ Vbo::Create(uint32_t size, const void* data)
   return ptr;
 }
 
+std::shared_ptr<Vbo>
+Vbo::CreatePersistent(uint32_t size)
+{
+  if (!GLEW_ARB_buffer_storage) {
+    return {};
+  }
+  GLuint vbo;
+  glGenBuffers(1, &vbo);
+  auto ptr = std::shared_ptr<Vbo>(new Vbo(vbo));
+  ptr->Bind();
+  auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+  ptr->mapped_ = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+  ptr->Unbind();
+  if (!ptr->mapped_) {
+    return {};
+  }
+  return ptr;
+}
+
 void
 Vbo::Bind()
 {
@@ -108,6 +152,31 @@ Vbo::Upload(uint32_t size, const void* data)
   glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
   Unbind();
 }
+void*
+Vbo::Map(uint32_t offset, uint32_t size)
+{
+  if (mapped_) {
+    return static_cast<uint8_t*>(mapped_) + offset;
+  }
+  Bind();
+  auto p = glMapBufferRange(GL_ARRAY_BUFFER,
+                            offset,
+                            size,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                              GL_MAP_UNSYNCHRONIZED_BIT);
+  Unbind();
+  return p;
+}
+void
+Vbo::Unmap()
+{
+  if (mapped_) {
+    return;
+  }
+  Bind();
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  Unbind();
+}
 
 Ibo::Ibo(uint32_t ibo, uint32_t valuetype)
   : ibo_(ibo)
@@ -162,13 +231,22 @@ Vao::Vao(uint32_t vao,
     auto& layout = layouts[i];
     glEnableVertexAttribArray(layout.Id.AttributeLocation);
     slots[layout.Id.Slot]->Bind();
-    glVertexAttribPointer(
-      layout.Id.AttributeLocation,
-      layout.Count,
-      *GLType(layout.Type),
-      GL_FALSE,
-      layout.Stride,
-      reinterpret_cast<void*>(static_cast<uint64_t>(layout.Offset)));
+    if (IsIntegerType(layout.Type)) {
+      glVertexAttribIPointer(
+        layout.Id.AttributeLocation,
+        layout.Count,
+        *GLType(layout.Type),
+        layout.Stride,
+        reinterpret_cast<void*>(static_cast<uint64_t>(layout.Offset)));
+    } else {
+      glVertexAttribPointer(
+        layout.Id.AttributeLocation,
+        layout.Count,
+        *GLType(layout.Type),
+        GL_FALSE,
+        layout.Stride,
+        reinterpret_cast<void*>(static_cast<uint64_t>(layout.Offset)));
+    }
     if (layout.Divisor) {
       // auto a = glVertexAttribDivisor;
       glVertexAttribDivisor(layout.Id.AttributeLocation, layout.Divisor);
@@ -251,5 +329,20 @@ Vao::DrawInstance(uint32_t primcount, uint32_t count, uint32_t offsetBytes)
   Unbind();
 }
 
+void
+Vao::DrawIndirect(uint32_t indirectOffsetBytes)
+{
+  Bind();
+  if (ibo_) {
+    glDrawElementsIndirect(
+      GL_TRIANGLES,
+      ibo_->valuetype_,
+      reinterpret_cast<void*>(static_cast<uint64_t>(indirectOffsetBytes)));
+  } else {
+    throw std::runtime_error("not implemented");
+  }
+  Unbind();
+}
+
 } // namespace
 } // namespace
@@ -12,6 +12,10 @@ namespace gl3 {
 std::optional<uint32_t>
 GLType(ValueType type);
 
+// integer attributes are passed to glVertexAttribIPointer
+bool
+IsIntegerType(ValueType type);
+
 std::optional<uint32_t>
 GLIndexTypeFromStride(uint32_t stride);
 
@@ -21,12 +25,17 @@ GLMode(grapho::DrawMode mode);
 class Vbo
 {
   uint32_t vbo_ = 0;
+  // valid for the lifetime of a persistent buffer
+  void* mapped_ = nullptr;
 
   Vbo(uint32_t vbo);
 
 public:
   ~Vbo();
   static std::shared_ptr<Vbo> Create(uint32_t size, const void* data);
+  // immutable storage mapped once with GL_MAP_PERSISTENT_BIT.
+  // return nullptr if ARB_buffer_storage is not available.
+  static std::shared_ptr<Vbo> CreatePersistent(uint32_t size);
 
   template<typename T>
   static std::shared_ptr<Vbo> Create(const T& array)
@@ -43,6 +52,11 @@ public:
   void Bind();
   void Unbind();
   void Upload(uint32_t size, const void* data);
+  // write only, GL_MAP_UNSYNCHRONIZED_BIT. caller must fence the range.
+  void* Map(uint32_t offset, uint32_t size);
+  void Unmap();
+  void* Mapped() const { return mapped_; }
+  uint32_t Handle() const { return vbo_; }
 };
 
 class Ibo
@@ -102,6 +116,8 @@ struct Vao
   void DrawInstance(uint32_t primcount,
                     uint32_t count,
                     uint32_t offsetBytes = 0);
+  // DrawElementsIndirectCommand in the bound GL_DRAW_INDIRECT_BUFFER
+  void DrawIndirect(uint32_t indirectOffsetBytes = 0);
 };
 
 } // namespace
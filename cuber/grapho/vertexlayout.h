@@ -9,6 +9,7 @@ enum class ValueType
 {
   Float,
   Double,
+  Half,
   Int8,
   Int16,
   Int32,
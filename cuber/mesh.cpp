@@ -1,3 +1,4 @@
+#include <DirectXPackedVector.h>
 #include <cuber/mesh.h>
 
 using namespace grapho;
@@ -119,6 +120,81 @@ static VertexLayout layouts[] = {
     },
 };
 
+// replace slot 1 of layouts
+static VertexLayout compact_instance_layouts[] = {
+    {
+        .Id =
+            {
+                .AttributeLocation = 2,
+                .Slot = 1,
+                .SemanticName = "TRANSLATION",
+                .SemanticIndex = 0,
+            },
+        .Type = ValueType::Float,
+        .Count = 3,
+        .Offset = offsetof(CompactInstance, Position),
+        .Stride = sizeof(CompactInstance),
+        .Divisor = 1,
+    },
+    {
+        .Id =
+            {
+                .AttributeLocation = 3,
+                .Slot = 1,
+                .SemanticName = "ROTATION",
+                .SemanticIndex = 0,
+            },
+        .Type = ValueType::UInt32,
+        .Count = 1,
+        .Offset = offsetof(CompactInstance, Rotation),
+        .Stride = sizeof(CompactInstance),
+        .Divisor = 1,
+    },
+    {
+        .Id =
+            {
+                .AttributeLocation = 4,
+                .Slot = 1,
+                .SemanticName = "SCALE",
+                .SemanticIndex = 0,
+            },
+        .Type = ValueType::Half,
+        .Count = 4,
+        .Offset = offsetof(CompactInstance, Scale),
+        .Stride = sizeof(CompactInstance),
+        .Divisor = 1,
+    },
+    //
+    {
+        .Id =
+            {
+                .AttributeLocation = 5,
+                .Slot = 1,
+                .SemanticName = "FACE",
+                .SemanticIndex = 0,
+            },
+        .Type = ValueType::UInt8,
+        .Count = 4,
+        .Offset = offsetof(CompactInstance, PositiveFaceFlag),
+        .Stride = sizeof(CompactInstance),
+        .Divisor = 1,
+    },
+    {
+        .Id =
+            {
+                .AttributeLocation = 6,
+                .Slot = 1,
+                .SemanticName = "FACE",
+                .SemanticIndex = 1,
+            },
+        .Type = ValueType::UInt8,
+        .Count = 4,
+        .Offset = offsetof(CompactInstance, NegativeFaceFlag),
+        .Stride = sizeof(CompactInstance),
+        .Divisor = 1,
+    },
+};
+
 const float s = 0.5f;
 DirectX::XMFLOAT3 positions[8] = {
   { +s, -s, -s }, //
@@ -251,14 +327,34 @@ struct Builder
   }
 };
 
+uint32_t
+InstanceStride(InstanceFormat format)
+{
+  switch (format) {
+    case InstanceFormat::Compact:
+      return sizeof(CompactInstance);
+    default:
+      return sizeof(Instance);
+  }
+}
+
 Mesh
-Cube(bool isCCW, bool isStereo)
+Cube(bool isCCW, bool isStereo, InstanceFormat format)
 {
   Builder builder(isCCW);
   for (auto layout : layouts) {
+    if (format == InstanceFormat::Compact && layout.Id.Slot == 1) {
+      continue;
+    }
     layout.Divisor *= (isStereo ? 2 : 1);
     builder.Mesh.Layouts.push_back(layout);
   }
+  if (format == InstanceFormat::Compact) {
+    for (auto layout : compact_instance_layouts) {
+      layout.Divisor *= (isStereo ? 2 : 1);
+      builder.Mesh.Layouts.push_back(layout);
+    }
+  }
   int f = 0;
   for (auto face : cube_faces) {
     builder.Quad(f++,
@@ -274,6 +370,46 @@ Cube(bool isCCW, bool isStereo)
   return builder.Mesh;
 }
 
+CompactInstance
+Compact(const Instance& instance)
+{
+  DirectX::XMVECTOR s;
+  DirectX::XMVECTOR r;
+  DirectX::XMVECTOR t;
+  DirectX::XMMatrixDecompose(
+    &s, &r, &t, DirectX::XMLoadFloat4x4(&instance.Matrix));
+
+  DirectX::XMFLOAT3 scale;
+  DirectX::XMStoreFloat3(&scale, s);
+  DirectX::XMFLOAT4 rotation;
+  DirectX::XMStoreFloat4(&rotation, DirectX::XMQuaternionNormalize(r));
+
+  CompactInstance compact;
+  DirectX::XMStoreFloat3(&compact.Position, t);
+  compact.Rotation =
+    quat_packer::Pack(rotation.x, rotation.y, rotation.z, rotation.w);
+  compact.Scale[0] = DirectX::PackedVector::XMConvertFloatToHalf(scale.x);
+  compact.Scale[1] = DirectX::PackedVector::XMConvertFloatToHalf(scale.y);
+  compact.Scale[2] = DirectX::PackedVector::XMConvertFloatToHalf(scale.z);
+  compact.PositiveFaceFlag[0] =
+    static_cast<uint8_t>(instance.PositiveFaceFlag.x);
+  compact.PositiveFaceFlag[1] =
+    static_cast<uint8_t>(instance.PositiveFaceFlag.y);
+  compact.PositiveFaceFlag[2] =
+    static_cast<uint8_t>(instance.PositiveFaceFlag.z);
+  compact.PositiveFaceFlag[3] =
+    static_cast<uint8_t>(instance.PositiveFaceFlag.w);
+  compact.NegativeFaceFlag[0] =
+    static_cast<uint8_t>(instance.NegativeFaceFlag.x);
+  compact.NegativeFaceFlag[1] =
+    static_cast<uint8_t>(instance.NegativeFaceFlag.y);
+  compact.NegativeFaceFlag[2] =
+    static_cast<uint8_t>(instance.NegativeFaceFlag.z);
+  compact.NegativeFaceFlag[3] =
+    static_cast<uint8_t>(instance.NegativeFaceFlag.w);
+  return compact;
+}
+
 void
 PushGrid(std::vector<LineVertex>& lines, float interval, int half_count)
 {
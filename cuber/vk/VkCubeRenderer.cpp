@@ -0,0 +1,588 @@
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cuber/mesh.h>
+#include <cuber/vk/VkCubeRenderer.h>
+#include <stdexcept>
+#include <string.h>
+#include <vuloxr/vk/buffer.h>
+#include <vuloxr/vk/pipeline.h>
+#include <vuloxr/vk/shaderc.h>
+
+namespace cuber::vk {
+
+// instances per slice. grows on demand
+const uint32_t INSTANCE_CAPACITY = 4096;
+// Render calls per slice. left and right eye and some spare
+const uint32_t MAX_VIEWS = 4;
+// descriptor set 0
+const uint32_t VIEW_BINDING = 0;
+const uint32_t PALETTE_BINDING = 1;
+// sampler0, sampler1, sampler2. Pallete.Textures[i].x selects one
+const uint32_t TEXTURE_BINDING = 2;
+
+// same as gl3::GlCubeRenderer. explicit locations for spir-v
+static auto vertex_m_shadertext = R"(#version 450
+layout (set = 0, binding = 0) uniform view {
+  mat4 VP;
+};
+layout (location = 0) in vec4 vPosFace;
+layout (location = 1) in vec4 vUvBarycentric;
+layout (location = 2) in vec4 iRow0;
+layout (location = 3) in vec4 iRow1;
+layout (location = 4) in vec4 iRow2;
+layout (location = 5) in vec4 iRow3;
+layout (location = 6) in vec4 iPositive_xyz_flag;
+layout (location = 7) in vec4 iNegative_xyz_flag;
+layout (location = 0) out vec4 oUvBarycentric;
+layout (location = 1) flat out uvec3 o_Palette_Flag_Flag;
+
+mat4 transform(vec4 r0, vec4 r1, vec4 r2, vec4 r3)
+{
+  return mat4(
+    r0.x, r0.y, r0.z, r0.w,
+    r1.x, r1.y, r1.z, r1.w,
+    r2.x, r2.y, r2.z, r2.w,
+    r3.x, r3.y, r3.z, r3.w
+  );
+}
+
+void main()
+{
+    gl_Position = VP * transform(iRow0, iRow1, iRow2, iRow3) * vec4(vPosFace.xyz, 1);
+    oUvBarycentric = vUvBarycentric;
+    uint face = uint(vPosFace.w);
+    uint palette = 0u;
+    if(face<3u)
+    {
+      palette = uint(iPositive_xyz_flag[face]);
+    }
+    else if(face<6u)
+    {
+      palette = uint(iNegative_xyz_flag[face - 3u]);
+    }
+    o_Palette_Flag_Flag = uvec3(palette,
+      iPositive_xyz_flag.w,
+      iNegative_xyz_flag.w);
+}
+)";
+
+static auto fragment_m_shadertext = R"(#version 450
+layout (location = 0) in vec4 oUvBarycentric;
+layout (location = 1) flat in uvec3 o_Palette_Flag_Flag;
+layout (location = 0) out vec4 FragColor;
+layout (set = 0, binding = 1, std140) uniform palette {
+  vec4 colors[32];
+  vec4 textures[32];
+} Palette;
+layout (set = 0, binding = 2) uniform sampler2D sampler0;
+layout (set = 0, binding = 3) uniform sampler2D sampler1;
+layout (set = 0, binding = 4) uniform sampler2D sampler2;
+
+// https://github.com/rreusser/glsl-solid-wireframe
+float grid (vec2 vBC, float width) {
+  vec3 bary = vec3(vBC.x, vBC.y, 1.0 - vBC.x - vBC.y);
+  vec3 d = fwidth(bary);
+  vec3 a3 = smoothstep(d * (width - 0.5), d * (width + 0.5), bary);
+  return min(a3.x, a3.y);
+}
+
+void main()
+{
+    vec4 border = vec4(vec3(grid(oUvBarycentric.zw, 1.0)), 1);
+    uint index = o_Palette_Flag_Flag.x;
+    vec4 color = Palette.colors[index];
+    vec4 texel;
+    if(Palette.textures[index].x==0.0)
+    {
+      texel = texture(sampler0, oUvBarycentric.xy);
+    }
+    else if(Palette.textures[index].x==1.0)
+    {
+      texel = texture(sampler1, oUvBarycentric.xy);
+    }
+    else if(Palette.textures[index].x==2.0)
+    {
+      texel = texture(sampler2, oUvBarycentric.xy);
+    }
+    else{
+      texel = vec4(1, 1, 1, 1);
+    }
+    FragColor = texel * color * border;
+}
+)";
+
+struct VkCubeRendererImpl
+{
+  const vuloxr::vk::PhysicalDevice& physicalDevice_;
+  VkDevice device_;
+  uint32_t sliceCount_;
+
+  vuloxr::vk::VertexBuffer vertices_;
+  vuloxr::vk::IndexBuffer indices_;
+
+  // sliceCount_ slices of capacity_ instances. persistently mapped
+  uint32_t capacity_ = 0;
+  vuloxr::vk::Buffer instanceBuffer_;
+  vuloxr::vk::Memory instanceMemory_;
+  uint8_t* instanceMapped_ = nullptr;
+  uint32_t slice_ = 0;
+  uint32_t instanceCount_ = 0;
+
+  // MAX_VIEWS view projections for each slice
+  vuloxr::vk::UniformRing<DirectX::XMFLOAT4X4> viewRing_;
+  uint32_t viewCount_ = 0;
+
+  vuloxr::vk::Buffer palleteBuffer_;
+  vuloxr::vk::Memory palleteMemory_;
+  VkDescriptorBufferInfo palleteInfo_;
+
+  // 1x1 white. bound to the units without SetTexture
+  vuloxr::vk::Texture white_;
+  VkDescriptorImageInfo textureInfos_[TEXTURE_UNITS];
+
+  vuloxr::vk::DescriptorSet descriptor_;
+  vuloxr::vk::Pipeline pipeline_;
+
+  VkCubeRendererImpl(const vuloxr::vk::PhysicalDevice& physicalDevice,
+                     VkDevice device,
+                     VkRenderPass renderPass,
+                     uint32_t sliceCount,
+                     VkPipelineCache pipelineCache)
+    : physicalDevice_(physicalDevice)
+    , device_(device)
+    , sliceCount_(std::max(sliceCount, 1u))
+    , viewRing_(physicalDevice, device, sliceCount_ * MAX_VIEWS)
+    , palleteBuffer_(device, sizeof(Pallete), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+    , white_(device, 1, 1)
+    , descriptor_(device,
+                  1,
+                  {
+                    {
+                      .binding = VIEW_BINDING,
+                      .descriptorType =
+                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                      .descriptorCount = 1,
+                      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                    },
+                    {
+                      .binding = PALETTE_BINDING,
+                      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                      .descriptorCount = 1,
+                      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    },
+                    {
+                      .binding = TEXTURE_BINDING,
+                      .descriptorType =
+                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                      .descriptorCount = 1,
+                      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    },
+                    {
+                      .binding = TEXTURE_BINDING + 1,
+                      .descriptorType =
+                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                      .descriptorCount = 1,
+                      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    },
+                    {
+                      .binding = TEXTURE_BINDING + 2,
+                      .descriptorType =
+                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                      .descriptorCount = 1,
+                      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    },
+                  })
+  {
+    auto [vertices, indices, layouts] =
+      Cube(true, false, InstanceFormat::Matrix);
+
+    vertices_.bindings = {
+      {
+        .binding = 0,
+        .stride = sizeof(Vertex),
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+      },
+      {
+        .binding = 1,
+        .stride = sizeof(Instance),
+        .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+      },
+    };
+    for (auto& layout : layouts) {
+      if (layout.Type != grapho::ValueType::Float) {
+        throw std::invalid_argument("cuber::VkCubeRenderer: ValueType");
+      }
+      vertices_.attributes.push_back({
+        .location = layout.Id.AttributeLocation,
+        .binding = layout.Id.Slot,
+        .format = vuloxr::vk::getFloatFormat(layout.Count),
+        .offset = layout.Offset,
+      });
+    }
+    vertices_.allocate(
+      physicalDevice, device, std::span<const Vertex>(vertices));
+    indices_.allocate(
+      physicalDevice, device, std::span<const uint32_t>(indices));
+
+    ReserveInstances(INSTANCE_CAPACITY);
+
+    palleteMemory_ = physicalDevice.allocForMap(device, palleteBuffer_);
+    palleteInfo_ = {
+      .buffer = palleteBuffer_,
+      .offset = 0,
+      .range = sizeof(Pallete),
+    };
+
+    white_.setMemory(physicalDevice.allocForTransfer(device, white_.image));
+    ClearWhite();
+    for (auto& info : textureInfos_) {
+      info = white_.descriptorInfo;
+    }
+    UpdateDescriptor();
+
+    CreatePipeline(renderPass, pipelineCache);
+  }
+
+  ~VkCubeRendererImpl() { ReleaseInstances(); }
+
+  // one time submit at construction. no UploadService for a single texel
+  void ClearWhite()
+  {
+    VkQueue queue;
+    vkGetDeviceQueue(device_, physicalDevice_.graphicsFamilyIndex, 0, &queue);
+
+    VkCommandPoolCreateInfo poolInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+      .queueFamilyIndex = physicalDevice_.graphicsFamilyIndex,
+    };
+    VkCommandPool pool;
+    vuloxr::vk::CheckVkResult(
+      vkCreateCommandPool(device_, &poolInfo, nullptr, &pool));
+
+    VkCommandBufferAllocateInfo allocateInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+    };
+    VkCommandBuffer cmd;
+    vuloxr::vk::CheckVkResult(
+      vkAllocateCommandBuffers(device_, &allocateInfo, &cmd));
+
+    VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vuloxr::vk::CheckVkResult(vkBeginCommandBuffer(cmd, &beginInfo));
+    VkImageSubresourceRange range{
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = 1,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+    };
+    VkImageMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = 0,
+      .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = white_.image,
+      .subresourceRange = range,
+    };
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier);
+    VkClearColorValue white = { .float32 = { 1, 1, 1, 1 } };
+    vkCmdClearColorImage(cmd,
+                         white_.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         &white,
+                         1,
+                         &range);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier);
+    vuloxr::vk::CheckVkResult(vkEndCommandBuffer(cmd));
+
+    VkSubmitInfo submitInfo{
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &cmd,
+    };
+    vuloxr::vk::Fence fence(device_, false);
+    vuloxr::vk::CheckVkResult(vkQueueSubmit(queue, 1, &submitInfo, fence));
+    fence.wait();
+    vkDestroyCommandPool(device_, pool, nullptr);
+  }
+
+  void UpdateDescriptor()
+  {
+    std::vector<vuloxr::vk::DescriptorUpdateInfo> infos{
+      {
+        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pBufferInfo = &viewRing_.info,
+      },
+      {
+        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .pBufferInfo = &palleteInfo_,
+      },
+    };
+    for (auto& info : textureInfos_) {
+      infos.push_back({
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &info,
+      });
+    }
+    descriptor_.update(0, infos);
+  }
+
+  void SetTexture(uint32_t unit, VkImageView imageView, VkSampler sampler)
+  {
+    if (unit >= TEXTURE_UNITS) {
+      throw std::out_of_range("cuber::VkCubeRenderer: texture unit");
+    }
+    textureInfos_[unit] =
+      imageView != VK_NULL_HANDLE
+        ? VkDescriptorImageInfo{
+            .sampler = sampler,
+            .imageView = imageView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+          }
+        : white_.descriptorInfo;
+    UpdateDescriptor();
+  }
+
+  void CreatePipeline(VkRenderPass renderPass, VkPipelineCache pipelineCache)
+  {
+    auto vertexSPIRV = vuloxr::vk::glsl_vs_to_spv(vertex_m_shadertext);
+    if (vertexSPIRV.empty()) {
+      throw std::runtime_error("cuber::VkCubeRenderer: vertex shader");
+    }
+    auto vs = vuloxr::vk::ShaderModule::createVertexShader(
+      device_, vertexSPIRV, "main");
+
+    auto fragmentSPIRV = vuloxr::vk::glsl_fs_to_spv(fragment_m_shadertext);
+    if (fragmentSPIRV.empty()) {
+      throw std::runtime_error("cuber::VkCubeRenderer: fragment shader");
+    }
+    auto fs = vuloxr::vk::ShaderModule::createFragmentShader(
+      device_, fragmentSPIRV, "main");
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &descriptor_.descriptorSetLayout,
+    };
+    VkPipelineLayout pipelineLayout;
+    vuloxr::vk::CheckVkResult(vkCreatePipelineLayout(
+      device_, &pipelineLayoutInfo, nullptr, &pipelineLayout));
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+      .depthTestEnable = VK_TRUE,
+      .depthWriteEnable = VK_TRUE,
+      .depthCompareOp = VK_COMPARE_OP_LESS,
+      .depthBoundsTestEnable = VK_FALSE,
+      .stencilTestEnable = VK_FALSE,
+      .minDepthBounds = 0.0f,
+      .maxDepthBounds = 1.0f,
+    };
+
+    vuloxr::vk::PipelineBuilder builder;
+    builder.pipelineCache = pipelineCache;
+    // the vulkan projection flips y. the ccw cube stays ccw
+    builder.rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    pipeline_ = builder.create(
+      device_,
+      renderPass,
+      depthStencil,
+      pipelineLayout,
+      { vs.pipelineShaderStageCreateInfo, fs.pipelineShaderStageCreateInfo },
+      vertices_.bindings,
+      vertices_.attributes,
+      {},
+      {},
+      { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
+    // the render pass belongs to the caller
+    pipeline_.renderPass = VK_NULL_HANDLE;
+  }
+
+  void ReleaseInstances()
+  {
+    if (instanceMapped_ && !instanceMemory_.allocation.mapped) {
+      vkUnmapMemory(device_, instanceMemory_.memory);
+    }
+    instanceMapped_ = nullptr;
+    instanceMemory_ = {};
+    instanceBuffer_ = {};
+    capacity_ = 0;
+  }
+
+  void ReserveInstances(uint32_t instanceCount)
+  {
+    if (instanceMapped_ && instanceCount <= capacity_) {
+      return;
+    }
+
+    auto capacity = std::max(instanceCount, INSTANCE_CAPACITY);
+    if (instanceMapped_) {
+      capacity = std::max(instanceCount, capacity_ * 2);
+      // rare. wait the slices in flight instead of deferring the release
+      vuloxr::vk::CheckVkResult(vkDeviceWaitIdle(device_));
+      ReleaseInstances();
+    }
+
+    instanceBuffer_ = vuloxr::vk::Buffer(device_,
+                                         sizeof(Instance) * capacity *
+                                           sliceCount_,
+                                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    instanceMemory_ = physicalDevice_.allocForMap(device_, instanceBuffer_);
+    if (instanceMemory_.allocation.mapped) {
+      instanceMapped_ = (uint8_t*)instanceMemory_.allocation.mapped;
+    } else {
+      vuloxr::vk::CheckVkResult(vkMapMemory(device_,
+                                            instanceMemory_.memory,
+                                            instanceMemory_.offset(),
+                                            VK_WHOLE_SIZE,
+                                            0,
+                                            (void**)&instanceMapped_));
+    }
+    capacity_ = capacity;
+  }
+
+  VkDeviceSize SliceOffset(uint32_t slice) const
+  {
+    return VkDeviceSize(sizeof(Instance)) * capacity_ * slice;
+  }
+
+  void UploadPallete(const Pallete& pallete)
+  {
+    palleteMemory_.mapWrite(&pallete, sizeof(pallete));
+  }
+
+  std::span<Instance> BeginInstances(uint32_t slice, uint32_t instanceCount)
+  {
+    ReserveInstances(instanceCount);
+    slice_ = slice % sliceCount_;
+    instanceCount_ = instanceCount;
+    viewCount_ = 0;
+    return { (Instance*)(instanceMapped_ + SliceOffset(slice_)),
+             instanceCount };
+  }
+
+  void Render(VkCommandBuffer cmd, const DirectX::XMFLOAT4X4& viewProjection)
+  {
+    if (instanceCount_ == 0) {
+      return;
+    }
+    if (viewCount_ >= MAX_VIEWS) {
+      throw std::runtime_error("cuber::VkCubeRenderer: MAX_VIEWS");
+    }
+    uint32_t offset =
+      viewRing_.write(slice_ * MAX_VIEWS + viewCount_++, viewProjection);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_);
+    vkCmdBindDescriptorSets(cmd,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipeline_.pipelineLayout,
+                            0,
+                            1,
+                            &descriptor_.descriptorSets[0],
+                            1,
+                            &offset);
+
+    VkBuffer buffers[] = {
+      vertices_.buffer,
+      instanceBuffer_,
+    };
+    VkDeviceSize offsets[] = {
+      0,
+      SliceOffset(slice_),
+    };
+    vkCmdBindVertexBuffers(cmd, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(cmd, indices_.buffer, 0, indices_.indexType);
+    vkCmdDrawIndexed(cmd, CUBE_INDEX_COUNT, instanceCount_, 0, 0, 0);
+  }
+};
+
+VkCubeRenderer::VkCubeRenderer(
+  const vuloxr::vk::PhysicalDevice& physicalDevice,
+  VkDevice device,
+  VkRenderPass renderPass,
+  uint32_t sliceCount,
+  VkPipelineCache pipelineCache)
+  : m_impl(new VkCubeRendererImpl(physicalDevice,
+                                  device,
+                                  renderPass,
+                                  sliceCount,
+                                  pipelineCache))
+{
+  m_impl->UploadPallete(Pallete);
+}
+
+VkCubeRenderer::~VkCubeRenderer()
+{
+  delete m_impl;
+}
+
+void
+VkCubeRenderer::UploadPallete()
+{
+  m_impl->UploadPallete(Pallete);
+}
+
+void
+VkCubeRenderer::SetTexture(uint32_t unit,
+                           VkImageView imageView,
+                           VkSampler sampler)
+{
+  m_impl->SetTexture(unit, imageView, sampler);
+}
+
+std::span<Instance>
+VkCubeRenderer::BeginInstances(uint32_t slice, uint32_t instanceCount)
+{
+  return m_impl->BeginInstances(slice, instanceCount);
+}
+
+void
+VkCubeRenderer::Render(VkCommandBuffer cmd,
+                       const float projection[16],
+                       const float view[16])
+{
+  auto v = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)view);
+  auto p = DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*)projection);
+  DirectX::XMFLOAT4X4 vp;
+  DirectX::XMStoreFloat4x4(&vp, v * p);
+  m_impl->Render(cmd, vp);
+}
+
+void
+VkCubeRenderer::Render(VkCommandBuffer cmd, const float viewProjection[16])
+{
+  m_impl->Render(cmd, *(const DirectX::XMFLOAT4X4*)viewProjection);
+}
+
+} // namespace cuber::vk
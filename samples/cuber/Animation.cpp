@@ -12,6 +12,7 @@ struct AnimationImpl {
   std::chrono::steady_clock::time_point startTime_;
   std::shared_ptr<Bvh> bvh_;
   std::list<Animation::OnFrameFunc> onFrameCallbacks_;
+  std::list<Animation::OnTimeFunc> onTimeCallbacks_;
 
   AnimationImpl(asio::io_context &io) : io_(io) {}
 
@@ -32,10 +33,15 @@ struct AnimationImpl {
     if (auto timer = timer_) {
       try {
         timer->expires_after(interval);
-        timer->async_wait([self = this, interval](const std::error_code &) {
-          self->Update();
-          self->AsyncWait(interval);
-        });
+        timer->async_wait(
+            [self = this, timer, interval](const std::error_code &ec) {
+              // Stop or SetBvh replaced the timer. do not re-arm the new one
+              if (ec || timer != self->timer_) {
+                return;
+              }
+              self->Update();
+              self->AsyncWait(interval);
+            });
       } catch (std::exception const &e) {
         std::cout << "AsyncWait catch: " << e.what() << std::endl;
       }
@@ -49,23 +55,34 @@ struct AnimationImpl {
     for (auto &callback : onFrameCallbacks_) {
       callback(frame);
     }
+    auto time = std::chrono::duration_cast<BvhTime>(elapsed);
+    for (auto &callback : onTimeCallbacks_) {
+      callback(time);
+    }
   }
 
-  void SetBvh(const std::shared_ptr<Bvh> &bvh) {
+  void SetBvh(const std::shared_ptr<Bvh> &bvh, float rate) {
+    Stop();
     bvh_ = bvh;
     if (!bvh_) {
       return;
     }
 
-    BeginTimer(
-        std::chrono::duration_cast<std::chrono::nanoseconds>(bvh_->frame_time));
+    // display rate (72/90/120Hz) is decoupled from the frame rate of the bvh
+    BeginTimer(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        rate > 0 ? BvhTime(1.0f / rate) : bvh_->frame_time));
   }
 };
 
 Animation::Animation(asio::io_context &io) : impl_(new AnimationImpl(io)) {}
 Animation::~Animation() { delete (impl_); }
-void Animation::SetBvh(const std::shared_ptr<Bvh> &bvh) { impl_->SetBvh(bvh); }
+void Animation::SetBvh(const std::shared_ptr<Bvh> &bvh, float rate) {
+  impl_->SetBvh(bvh, rate);
+}
 void Animation::OnFrame(const OnFrameFunc &onFrame) {
   impl_->onFrameCallbacks_.push_back(onFrame);
 }
+void Animation::OnTime(const OnTimeFunc &onTime) {
+  impl_->onTimeCallbacks_.push_back(onTime);
+}
 void Animation::Stop() { impl_->Stop(); }
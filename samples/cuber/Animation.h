@@ -15,10 +15,14 @@ class Animation {
 
 public:
   using OnFrameFunc = std::function<void(const BvhFrame &frame)>;
+  // elapsed time of the clip. for interpolated sampling
+  using OnTimeFunc = std::function<void(BvhTime time)>;
 
   Animation(asio::io_context &io);
   ~Animation();
-  void SetBvh(const std::shared_ptr<Bvh> &bvh);
+  // rate: updates per second. 0 for the frame rate of the bvh
+  void SetBvh(const std::shared_ptr<Bvh> &bvh, float rate = 0);
   void OnFrame(const OnFrameFunc &onFrame);
+  void OnTime(const OnTimeFunc &onTime);
   void Stop();
 };
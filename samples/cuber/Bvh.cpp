@@ -1,34 +1,35 @@
 #include "Bvh.h"
-#include "ReadAllBytes.h"
+#include "MappedFile.h"
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <cctype>
 #include <charconv>
 #include <cmath>
-#include <functional>
+#include <filesystem>
 #include <iostream>
 #include <optional>
 #include <stack>
 #include <stdlib.h>
+#include <thread>
 
 template<typename T>
 std::optional<T>
 to_num(std::string_view view)
 {
-#ifdef _MSC_VER
+  auto begin = view.data();
+  auto end = view.data() + view.size();
+  // from_chars does not accept '+'
+  if (begin != end && *begin == '+') {
+    ++begin;
+  }
   T value;
-  auto [ptr, ec] =
-    std::from_chars(view.data(), view.data() + view.size(), value);
+  auto [ptr, ec] = std::from_chars(begin, end, value);
   if (ec == std::errc{}) {
     return value;
   } else {
     return {};
   }
-#else
-  // slow !
-  // return std::stof(view.data());
-  auto end = (char*)view.data() + view.size();
-  return (float)strtod(view.data(), &end);
-#endif
 }
 
 using It = std::string_view::iterator;
@@ -37,7 +38,6 @@ struct Result
   It end;
   It next;
 };
-using Delimiter = std::function<std::optional<Result>(It, It)>;
 
 class Tokenizer
 {
@@ -51,7 +51,12 @@ public:
     m_pos = m_data.begin();
   }
 
-  std::optional<std::string_view> token(const Delimiter& delimiter)
+  // rest of data
+  std::string_view remain() const { return { m_pos, m_data.end() }; }
+
+  // Delimiter: std::optional<Result>(It, It). inlined, not std::function
+  template<typename Delimiter>
+  std::optional<std::string_view> token(Delimiter delimiter)
   {
     auto begin = m_pos;
 
@@ -68,7 +73,8 @@ public:
     return {};
   }
 
-  bool expect(std::string_view expected, const Delimiter& delimiter)
+  template<typename Delimiter>
+  bool expect(std::string_view expected, Delimiter delimiter)
   {
     if (auto line = token(delimiter)) {
       if (*line == expected) {
@@ -78,8 +84,8 @@ public:
     return false;
   }
 
-  template<typename T>
-  std::optional<T> number(const Delimiter& delimiter)
+  template<typename T, typename Delimiter>
+  std::optional<T> number(Delimiter delimiter)
   {
     auto n = token(delimiter);
     if (!n) {
@@ -93,9 +99,144 @@ public:
   }
 };
 
-static std::optional<Result>
-is_space(It it, It end)
+static bool
+is_blank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// MOTION section. one frame per line
+struct MotionChunk
 {
+  std::string_view src;
+  uint32_t frame_begin = 0;
+  uint32_t frame_count = 0;
+
+  // lines with a value
+  uint32_t CountFrames() const
+  {
+    uint32_t count = 0;
+    bool value = false;
+    for (auto c : src) {
+      if (c == '\n') {
+        if (value) {
+          ++count;
+        }
+        value = false;
+      } else if (!is_blank(c)) {
+        value = true;
+      }
+    }
+    if (value) {
+      ++count;
+    }
+    return count;
+  }
+
+  bool Parse(float* dst, uint32_t channel_count) const
+  {
+    auto p = src.data();
+    auto end = src.data() + src.size();
+    for (uint32_t i = 0; i < frame_count; ++i) {
+      // skip blank lines
+      while (p != end && (is_blank(*p) || *p == '\n')) {
+        ++p;
+      }
+      for (uint32_t j = 0; j < channel_count; ++j, ++dst) {
+        while (p != end && is_blank(*p)) {
+          ++p;
+        }
+        if (p != end && *p == '+') {
+          ++p;
+        }
+        auto [ptr, ec] = std::from_chars(p, end, *dst);
+        if (ec != std::errc{}) {
+          return false;
+        }
+        p = ptr;
+      }
+      // rest of line
+      while (p != end && *p != '\n') {
+        ++p;
+      }
+    }
+    return true;
+  }
+};
+
+// split at line boundaries and parse in parallel straight into dst
+static bool
+ParseMotion(std::string_view src,
+            uint32_t frame_count,
+            uint32_t channel_count,
+            float* dst)
+{
+  // 1MB or more per thread
+  const size_t MIN_CHUNK = 1024 * 1024;
+  size_t chunk_count = std::max<size_t>(
+    1,
+    std::min<size_t>(std::thread::hardware_concurrency(),
+                     src.size() / MIN_CHUNK));
+
+  std::vector<MotionChunk> chunks;
+  size_t begin = 0;
+  for (size_t i = 1; i <= chunk_count && begin < src.size(); ++i) {
+    size_t end = src.size();
+    if (i < chunk_count) {
+      end = src.find('\n', src.size() * i / chunk_count);
+      end = end == std::string_view::npos ? src.size() : end + 1;
+    }
+    if (end > begin) {
+      chunks.push_back({ .src = src.substr(begin, end - begin) });
+    }
+    begin = end;
+  }
+
+  auto run = [&chunks](auto&& f) {
+    if (chunks.size() == 1) {
+      f(chunks[0]);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (auto& chunk : chunks) {
+      threads.push_back(std::thread([&f, &chunk]() { f(chunk); }));
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  };
+
+  // 1. frames in each chunk
+  run([](MotionChunk& chunk) { chunk.frame_count = chunk.CountFrames(); });
+  uint32_t total = 0;
+  for (auto& chunk : chunks) {
+    chunk.frame_begin = total;
+    total += chunk.frame_count;
+  }
+  if (total < frame_count) {
+    return false;
+  }
+  // ignore trailing lines
+  for (auto& chunk : chunks) {
+    if (chunk.frame_begin + chunk.frame_count > frame_count) {
+      chunk.frame_count =
+        std::max(chunk.frame_begin, frame_count) - chunk.frame_begin;
+    }
+  }
+
+  // 2. parse
+  std::atomic<bool> ok = true;
+  run([dst, channel_count, &ok](MotionChunk& chunk) {
+    if (!chunk.Parse(dst + chunk.frame_begin * channel_count,
+                     channel_count)) {
+      ok = false;
+    }
+  });
+  return ok;
+}
+
+// lambda. inlined into Tokenizer::token
+static constexpr auto is_space = [](It it, It end) -> std::optional<Result> {
   if (!std::isspace(*it)) {
     return {};
   }
@@ -107,22 +248,9 @@ is_space(It it, It end)
     }
   }
   return Result{ tail, it };
-}
-
-static std::optional<Result>
-get_eol(It it, It end)
-{
-  if (*it != '\n') {
-    return {};
-  }
-  auto tail = it;
-  ++it;
-  return Result{ tail, it };
-}
+};
 
-static std::optional<Result>
-get_name(It it, It end)
-{
+static constexpr auto get_name = [](It it, It end) -> std::optional<Result> {
   if (*it != '\n') {
     return {};
   }
@@ -135,7 +263,7 @@ get_name(It it, It end)
     }
   }
   return Result{ tail, it };
-}
+};
 
 struct BvhImpl
 {
@@ -197,23 +325,11 @@ struct BvhImpl
     for (auto& joint : joints_) {
       channel_count_ += joint.channels.size();
     }
-    frames_.reserve(frame_count_ * channel_count_);
-    for (int i = 0; i < frame_count_; ++i) {
-      auto line = token_.token(get_eol);
-      if (!line) {
-        return false;
-      }
-
-      Tokenizer line_token(*line);
-      for (int j = 0; j < channel_count_; ++j) {
-        if (auto value = line_token.number<float>(is_space)) {
-          frames_.push_back(*value);
-        } else {
-          return false;
-        }
-      }
+    frames_.resize(frame_count_ * channel_count_);
+    if (!ParseMotion(
+          token_.remain(), frame_count_, channel_count_, frames_.data())) {
+      return false;
     }
-    assert(frames_.size() == frame_count_ * channel_count_);
 
     return true;
   }
@@ -386,10 +502,11 @@ Bvh::~Bvh() {}
 bool
 Bvh::Parse(std::string_view src)
 {
-  BvhImpl parser(joints, endsites, frames, src);
+  BvhImpl parser(joints, endsites, frame_storage, src);
   if (!parser.Parse()) {
     return false;
   }
+  frames = frame_storage;
   frame_time = parser.frame_time_;
   frame_channel_count = parser.channel_count_;
   max_height = parser.max_height_;
@@ -397,19 +514,38 @@ Bvh::Parse(std::string_view src)
 }
 
 std::shared_ptr<Bvh>
-Bvh::ParseFile(std::string_view file)
+Bvh::ParseFile(std::string_view file, bool useCache)
 {
-  auto bytes = ReadAllBytes<char>(std::string(file.begin(), file.end()));
-  if (bytes.empty()) {
+  std::string cache;
+  if (useCache) {
+    cache = CachePath(file);
+    std::error_code srcEc;
+    auto src = std::filesystem::last_write_time(file, srcEc);
+    std::error_code binEc;
+    auto bin = std::filesystem::last_write_time(cache, binEc);
+    if (!srcEc && !binEc && bin > src) {
+      if (auto bvh = LoadBinary(cache)) {
+        std::cout << "load: " << cache << std::endl;
+        return bvh;
+      }
+    }
+  }
+
+  auto mapped = MappedFile::Open(std::string(file.begin(), file.end()));
+  if (!mapped || mapped->View().empty()) {
     return {};
   }
-  std::cout << "load: " << file << " " << bytes.size() << "bytes" << std::endl;
+  std::cout << "load: " << file << " " << mapped->View().size() << "bytes"
+            << std::endl;
 
   auto bvh = std::make_shared<Bvh>();
-  if (!bvh->Parse({ bytes.begin(), bytes.end() })) {
+  if (!bvh->Parse(mapped->View())) {
     return {};
   }
 
   std::cout << *bvh << std::endl;
+  if (useCache && !bvh->WriteBinary(cache)) {
+    std::cout << "fail to write: " << cache << std::endl;
+  }
   return bvh;
 }
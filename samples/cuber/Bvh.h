@@ -6,6 +6,7 @@
 #include <memory>
 #include <ostream>
 #include <span>
+#include <tuple>
 #include <vector>
 
 struct BvhJoint {
@@ -18,6 +19,14 @@ struct BvhJoint {
   srht::HumanoidBones bone_ = {};
 };
 
+class MappedFile;
+
+enum class BvhFrameEncoding : uint32_t {
+  Float32,
+  // int16 per channel with per channel scale / offset. lossy
+  Int16,
+};
+
 // inline std::ostream &operator<<(std::ostream &os, const BvhJoint &joint) {
 //   os << joint.name << ": " << joint.worldOffset << " " << joint.channels;
 //   return os;
@@ -27,14 +36,30 @@ struct Bvh {
   std::vector<BvhJoint> joints;
   std::vector<BvhJoint> endsites;
   BvhTime frame_time = {};
-  std::vector<float> frames;
+  // frame_storage or the float32 frames of a mapped binary cache (no copy)
+  std::span<const float> frames;
+  std::vector<float> frame_storage;
+  std::shared_ptr<MappedFile> mapped;
   uint32_t frame_channel_count = 0;
   float max_height = 0;
   Bvh();
   ~Bvh();
-  static std::shared_ptr<Bvh> ParseFile(std::string_view file);
+  // frames points into this object's frame_storage
+  Bvh(const Bvh &) = delete;
+  Bvh &operator=(const Bvh &) = delete;
+  // use the sidecar cache (file + ".bin") when it is newer than file.
+  // otherwise parse the text and write the cache.
+  static std::shared_ptr<Bvh> ParseFile(std::string_view file,
+                                        bool useCache = true);
   bool Parse(std::string_view src);
-  uint32_t FrameCount() const { return frames.size() / frame_channel_count; }
+  // BvhBinary.cpp
+  static std::string CachePath(std::string_view file);
+  static std::shared_ptr<Bvh> LoadBinary(std::string_view file);
+  bool WriteBinary(std::string_view file,
+                   BvhFrameEncoding encoding = BvhFrameEncoding::Float32) const;
+  uint32_t FrameCount() const {
+    return frame_channel_count ? frames.size() / frame_channel_count : 0;
+  }
   const BvhJoint *GetParent(int parent) const {
     for (auto &joint : joints) {
       if (joint.parent == parent) {
@@ -44,6 +69,9 @@ struct Bvh {
     return nullptr;
   }
   int TimeToIndex(BvhTime time) const {
+    if (FrameCount() == 0) {
+      return 0;
+    }
     auto div = time / frame_time;
     auto index = (int)div;
     if (index >= FrameCount()) {
@@ -51,6 +79,18 @@ struct Bvh {
     }
     return index;
   }
+  // the two frames around time and the weight of the second. loops.
+  std::tuple<int, int, float> TimeToFrames(BvhTime time) const {
+    auto count = FrameCount();
+    if (count == 0) {
+      return {0, 0, 0.0f};
+    }
+    auto div = time / frame_time;
+    auto index = static_cast<uint64_t>(div);
+    auto t = div - static_cast<float>(index);
+    auto a = static_cast<int>(index % count);
+    return {a, static_cast<int>((a + 1) % count), t};
+  }
   BvhFrame GetFrame(int index) const {
     auto begin = frames.data() + index * frame_channel_count;
     return {
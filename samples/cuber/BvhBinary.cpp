@@ -0,0 +1,279 @@
+// binary cache of Bvh
+//
+// [BvhBinaryHeader]
+// [BvhBinaryJoint x joint_count][BvhBinaryJoint x endsite_count]
+// [names. name_size bytes]
+// Int16: [float scale x channel_count][float offset x channel_count]
+// (pad to 16)
+// Float32: [float x frame_count x channel_count]
+// Int16: [int16 x frame_count x channel_count]
+//
+// little endian. Float32 frames are used in place from the mapped file.
+#include "Bvh.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string.h>
+
+static const char BVH_BINARY_MAGIC[4] = {'B', 'V', 'H', 'B'};
+static const uint32_t BVH_BINARY_VERSION = 1;
+
+struct BvhBinaryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t joint_count;
+  uint32_t endsite_count;
+  uint32_t frame_count;
+  uint32_t channel_count;
+  float frame_time;
+  float max_height;
+  BvhFrameEncoding encoding;
+  uint32_t name_size;
+  uint64_t frames_offset;
+};
+static_assert(sizeof(BvhBinaryHeader) == 48, "BvhBinaryHeader");
+
+struct BvhBinaryJoint {
+  uint16_t index;
+  uint16_t parent;
+  uint16_t bone;
+  uint16_t name_length;
+  BvhOffset localOffset;
+  BvhOffset worldOffset;
+  BvhOffset init;
+  uint32_t startIndex;
+  BvhChannelTypes types[6];
+};
+
+static BvhBinaryJoint ToBinary(const BvhJoint &joint) {
+  BvhBinaryJoint b{
+      .index = joint.index,
+      .parent = joint.parent,
+      .bone = static_cast<uint16_t>(joint.bone_),
+      .name_length = static_cast<uint16_t>(joint.name.size()),
+      .localOffset = joint.localOffset,
+      .worldOffset = joint.worldOffset,
+      .init = joint.channels.init,
+      .startIndex = static_cast<uint32_t>(joint.channels.startIndex),
+  };
+  std::copy(std::begin(joint.channels.types), std::end(joint.channels.types),
+            b.types);
+  return b;
+}
+
+static BvhJoint FromBinary(const BvhBinaryJoint &b, std::string_view name) {
+  BvhJoint joint{
+      .name = {name.begin(), name.end()},
+      .index = b.index,
+      .parent = b.parent,
+      .localOffset = b.localOffset,
+      .worldOffset = b.worldOffset,
+      .channels =
+          {
+              .init = b.init,
+              .startIndex = b.startIndex,
+          },
+      .bone_ = static_cast<srht::HumanoidBones>(b.bone),
+  };
+  std::copy(std::begin(b.types), std::end(b.types), joint.channels.types);
+  return joint;
+}
+
+static uint64_t Align16(uint64_t n) { return (n + 15) & ~15ull; }
+
+static const uint16_t NO_PARENT = static_cast<uint16_t>(-1);
+
+// a stale or truncated cache must not index out of the joints or frames.
+// joint parents come before the joint. endsite parents are joints.
+static bool IsValid(const BvhBinaryJoint &b, uint64_t i,
+                    const BvhBinaryHeader &header) {
+  if (i < header.joint_count) {
+    if (b.parent != NO_PARENT && b.parent >= i) {
+      return false;
+    }
+  } else if (b.parent != NO_PARENT && b.parent >= header.joint_count) {
+    return false;
+  }
+  uint64_t count = 0;
+  for (; count < 6 && b.types[count] != BvhChannelTypes::None; ++count) {
+    if (b.types[count] > BvhChannelTypes::Zrotation) {
+      return false;
+    }
+  }
+  return count == 0 ||
+         static_cast<uint64_t>(b.startIndex) + count <= header.channel_count;
+}
+
+std::string Bvh::CachePath(std::string_view file) {
+  return std::string(file.begin(), file.end()) + ".bin";
+}
+
+bool Bvh::WriteBinary(std::string_view file, BvhFrameEncoding encoding) const {
+  auto channel_count = frame_channel_count;
+  auto frame_count = channel_count ? FrameCount() : 0;
+
+  std::vector<BvhBinaryJoint> table;
+  std::string names;
+  for (auto &joint : joints) {
+    table.push_back(ToBinary(joint));
+    names += joint.name;
+  }
+  for (auto &joint : endsites) {
+    table.push_back(ToBinary(joint));
+    names += joint.name;
+  }
+
+  // int16
+  std::vector<float> scale;
+  std::vector<float> offset;
+  if (encoding == BvhFrameEncoding::Int16) {
+    scale.resize(channel_count, 1.0f);
+    offset.resize(channel_count, 0.0f);
+    for (uint32_t ch = 0; ch < channel_count; ++ch) {
+      float min = INFINITY;
+      float max = -INFINITY;
+      for (uint32_t i = 0; i < frame_count; ++i) {
+        auto value = frames[i * channel_count + ch];
+        min = std::min(min, value);
+        max = std::max(max, value);
+      }
+      if (frame_count) {
+        offset[ch] = (max + min) * 0.5f;
+        if (max > min) {
+          scale[ch] = (max - min) * 0.5f / 32767.0f;
+        }
+      }
+    }
+  }
+
+  uint64_t pos = sizeof(BvhBinaryHeader) +
+                 sizeof(BvhBinaryJoint) * table.size() + names.size() +
+                 sizeof(float) * (scale.size() + offset.size());
+  BvhBinaryHeader header{
+      .version = BVH_BINARY_VERSION,
+      .joint_count = static_cast<uint32_t>(joints.size()),
+      .endsite_count = static_cast<uint32_t>(endsites.size()),
+      .frame_count = frame_count,
+      .channel_count = channel_count,
+      .frame_time = frame_time.count(),
+      .max_height = max_height,
+      .encoding = encoding,
+      .name_size = static_cast<uint32_t>(names.size()),
+      .frames_offset = Align16(pos),
+  };
+  memcpy(header.magic, BVH_BINARY_MAGIC, sizeof(header.magic));
+
+  std::ofstream os(std::string(file.begin(), file.end()), std::ios::binary);
+  if (!os) {
+    return false;
+  }
+  os.write((const char *)&header, sizeof(header));
+  os.write((const char *)table.data(), sizeof(BvhBinaryJoint) * table.size());
+  os.write(names.data(), names.size());
+  os.write((const char *)scale.data(), sizeof(float) * scale.size());
+  os.write((const char *)offset.data(), sizeof(float) * offset.size());
+  char pad[16] = {};
+  os.write(pad, header.frames_offset - pos);
+
+  if (encoding == BvhFrameEncoding::Int16) {
+    std::vector<int16_t> quantized(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      auto ch = i % channel_count;
+      quantized[i] = static_cast<int16_t>(
+          std::lround((frames[i] - offset[ch]) / scale[ch]));
+    }
+    os.write((const char *)quantized.data(),
+             sizeof(int16_t) * quantized.size());
+  } else {
+    os.write((const char *)frames.data(), sizeof(float) * frames.size());
+  }
+  return static_cast<bool>(os);
+}
+
+std::shared_ptr<Bvh> Bvh::LoadBinary(std::string_view file) {
+  auto mapped = MappedFile::Open(std::string(file.begin(), file.end()));
+  if (!mapped) {
+    return {};
+  }
+  auto bytes = mapped->Bytes();
+  if (bytes.size() < sizeof(BvhBinaryHeader)) {
+    return {};
+  }
+  BvhBinaryHeader header;
+  memcpy(&header, bytes.data(), sizeof(header));
+  if (memcmp(header.magic, BVH_BINARY_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != BVH_BINARY_VERSION) {
+    return {};
+  }
+  if ((header.encoding != BvhFrameEncoding::Float32 &&
+       header.encoding != BvhFrameEncoding::Int16) ||
+      !(header.frame_time > 0) ||
+      uint64_t(header.joint_count) + header.endsite_count > NO_PARENT) {
+    return {};
+  }
+
+  uint64_t value_size =
+      header.encoding == BvhFrameEncoding::Int16 ? sizeof(int16_t)
+                                                 : sizeof(float);
+  uint64_t joint_count = header.joint_count + header.endsite_count;
+  uint64_t params_size = header.encoding == BvhFrameEncoding::Int16
+                             ? sizeof(float) * header.channel_count * 2
+                             : 0;
+  uint64_t frames_size = value_size * header.frame_count * header.channel_count;
+  uint64_t names_offset =
+      sizeof(BvhBinaryHeader) + sizeof(BvhBinaryJoint) * joint_count;
+  if (header.frames_offset <
+          names_offset + header.name_size + params_size ||
+      header.frames_offset > bytes.size() ||
+      frames_size > bytes.size() - header.frames_offset) {
+    return {};
+  }
+
+  auto bvh = std::make_shared<Bvh>();
+  bvh->frame_time = BvhTime(header.frame_time);
+  bvh->frame_channel_count = header.channel_count;
+  bvh->max_height = header.max_height;
+
+  auto table =
+      (const BvhBinaryJoint *)(bytes.data() + sizeof(BvhBinaryHeader));
+  std::string_view names(bytes.data() + names_offset, header.name_size);
+  size_t name_pos = 0;
+  for (uint64_t i = 0; i < joint_count; ++i) {
+    BvhBinaryJoint b;
+    memcpy(&b, table + i, sizeof(b));
+    if (!IsValid(b, i, header) || name_pos + b.name_length > names.size()) {
+      return {};
+    }
+    auto joint = FromBinary(b, names.substr(name_pos, b.name_length));
+    name_pos += b.name_length;
+    if (i < header.joint_count) {
+      bvh->joints.push_back(joint);
+    } else {
+      bvh->endsites.push_back(joint);
+    }
+  }
+
+  auto values = bytes.data() + header.frames_offset;
+  auto value_count = uint64_t(header.frame_count) * header.channel_count;
+  if (header.encoding == BvhFrameEncoding::Int16) {
+    std::vector<float> scale(header.channel_count);
+    std::vector<float> offset(header.channel_count);
+    auto params = bytes.data() + names_offset + header.name_size;
+    memcpy(scale.data(), params, sizeof(float) * scale.size());
+    memcpy(offset.data(), params + sizeof(float) * scale.size(),
+           sizeof(float) * offset.size());
+    bvh->frame_storage.resize(value_count);
+    auto src = (const int16_t *)values;
+    for (size_t i = 0; i < value_count; ++i) {
+      auto ch = i % header.channel_count;
+      bvh->frame_storage[i] = offset[ch] + scale[ch] * src[i];
+    }
+    bvh->frames = bvh->frame_storage;
+  } else {
+    // zero copy. keep the mapping alive with the Bvh
+    bvh->frames = {(const float *)values, value_count};
+    bvh->mapped = mapped;
+  }
+  return bvh;
+}
@@ -81,25 +81,3 @@ BvhNode::CalcShape(float scaling)
     child->CalcShape(scaling);
   }
 }
-
-// [x, y, z][c6][c5][c4][c3][c2][c1][parent][root]
-void
-BvhNode::ResolveFrame(const BvhFrame& frame,
-                      DirectX::XMMATRIX m,
-                      float scaling,
-                      std::span<DirectX::XMFLOAT4X4>::iterator& out)
-{
-  auto [pos, rot] = frame.Resolve(joint_.channels);
-
-  auto t = DirectX::XMMatrixTranslation(
-    pos.x * scaling, pos.y * scaling, pos.z * scaling);
-  auto local = rot * t;
-
-  m = local * m;
-  auto shape = DirectX::XMLoadFloat4x4(&shape_);
-  DirectX::XMStoreFloat4x4(&*out, shape * m);
-  ++out;
-  for (auto& child : children_) {
-    child->ResolveFrame(frame, m, scaling, out);
-  }
-}
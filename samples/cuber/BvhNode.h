@@ -13,6 +13,4 @@ struct BvhNode {
     children_.push_back(node);
   }
   void CalcShape(float scaling);
-  void ResolveFrame(const BvhFrame &frame, DirectX::XMMATRIX m, float scaling,
-                    std::span<DirectX::XMFLOAT4X4>::iterator &out);
 };
@@ -3,8 +3,11 @@
 #include "Bvh.h"
 #include "BvhNode.h"
 #include "BvhSolver.h"
+#include "Crowd.h"
+#include "JobSystem.h"
 #include "UdpSender.h"
 #include <algorithm>
+#include <atomic>
 #include <asio.hpp>
 #include <asio/ip/address.hpp>
 #include <imgui.h>
@@ -18,7 +21,9 @@ struct BvhPanelImpl
   UdpSender m_sender;
   std::thread m_thread;
   std::shared_ptr<Bvh> m_bvh;
-  asio::ip::udp::endpoint m_ep;
+  // receivers. accessed on the asio thread
+  std::vector<asio::ip::udp::endpoint> m_eps;
+  int m_addPort = 54346;
   bool m_enablePackQuat = false;
   std::vector<int> m_parentMap;
 
@@ -26,15 +31,28 @@ struct BvhPanelImpl
   std::mutex m_mutex;
   BvhSolver m_bvhSolver;
 
+  // crowd mode. Initialize and Update run on the asio thread
+  JobSystem m_jobs;
+  Crowd m_crowd;
+  int m_crowdCount = 0;
+  std::vector<cuber::Instance> m_back;
+
+  // sample between frames at the update rate instead of snapping
+  std::atomic<bool> m_interpolate = false;
+  int m_rate = 0;
+
   BvhPanelImpl()
     : m_work(asio::make_work_guard(io_))
     , m_animation(io_)
     , m_sender(io_)
-    , m_ep(asio::ip::make_address("127.0.0.1"), 54345)
+    , m_eps{ { asio::ip::make_address("127.0.0.1"), 54345 } }
   {
     m_animation.OnFrame([self = this](const BvhFrame& frame) {
+      if (self->m_interpolate) {
+        return;
+      }
       self->m_sender.SendFrame(
-        self->m_ep, self->m_bvh, frame, self->m_enablePackQuat);
+        self->m_eps, self->m_bvh, frame, self->m_enablePackQuat);
     });
     m_thread = std::thread([self = this]() {
       try {
@@ -46,13 +64,22 @@ struct BvhPanelImpl
     });
 
     // bind bvh animation to renderer
-    m_animation.OnFrame(
-      [self = this](const BvhFrame& frame) { self->SyncFrame(frame); });
+    m_animation.OnFrame([self = this](const BvhFrame& frame) {
+      if (!self->m_interpolate) {
+        self->SyncFrame(frame);
+      }
+    });
+    m_animation.OnTime([self = this](BvhTime time) {
+      if (self->m_interpolate) {
+        self->SyncTime(time);
+      }
+    });
   }
 
   ~BvhPanelImpl()
   {
-    m_animation.Stop();
+    // the timer belongs to the asio thread
+    asio::post(io_, [self = this]() { self->m_animation.Stop(); });
     m_work.reset();
     m_thread.join();
   }
@@ -63,14 +90,45 @@ struct BvhPanelImpl
     if (!m_bvh) {
       return;
     }
-    m_animation.SetBvh(bvh);
+    SetRate(m_rate);
     for (auto& joint : m_bvh->joints) {
       m_parentMap.push_back(joint.parent);
     }
-    m_sender.SendSkeleton(m_ep, m_bvh);
+    SendSkeleton();
 
     m_bvhSolver.Initialize(bvh);
     m_instances.resize(m_bvh->joints.size());
+    SetCrowd(m_crowdCount);
+  }
+
+  void SendSkeleton()
+  {
+    asio::post(io_, [self = this, bvh = m_bvh]() {
+      self->m_sender.SendSkeleton(self->m_eps, bvh);
+    });
+  }
+
+  void AddReceiver(int port)
+  {
+    asio::post(io_, [self = this, port]() {
+      self->m_eps.push_back(
+        { asio::ip::make_address("127.0.0.1"), static_cast<uint16_t>(port) });
+    });
+  }
+
+  // the timer and the bvh of the animation are used on the asio thread
+  void SetRate(int rate)
+  {
+    asio::post(io_, [self = this, bvh = m_bvh, rate]() {
+      self->m_animation.SetBvh(bvh, static_cast<float>(rate));
+    });
+  }
+
+  void SetCrowd(int count)
+  {
+    asio::post(io_, [self = this, bvh = m_bvh, count]() {
+      self->m_crowd.Initialize(bvh, count);
+    });
   }
 
   void SelectBone(const std::shared_ptr<BvhNode>& node)
@@ -142,7 +200,26 @@ struct BvhPanelImpl
     ImGui::Checkbox("use quaternion pack32", &m_enablePackQuat);
 
     if (ImGui::Button("send skeleton")) {
-      m_sender.SendSkeleton(m_ep, m_bvh);
+      SendSkeleton();
+    }
+    ImGui::InputInt("port", &m_addPort);
+    ImGui::SameLine();
+    if (ImGui::Button("add receiver")) {
+      AddReceiver(m_addPort);
+    }
+    ImGui::LabelText("dropped", "%llu", (unsigned long long)m_sender.DroppedCount());
+
+    bool interpolate = m_interpolate;
+    if (ImGui::Checkbox("interpolate", &interpolate)) {
+      m_interpolate = interpolate;
+    }
+    // 0: the frame rate of the bvh. 72/90/120 for headsets
+    if (ImGui::InputInt("rate(Hz)", &m_rate, 0) && m_rate >= 0) {
+      SetRate(m_rate);
+    }
+
+    if (ImGui::SliderInt("crowd", &m_crowdCount, 0, 1024)) {
+      SetCrowd(m_crowdCount);
     }
 
     // TREE
@@ -166,6 +243,15 @@ struct BvhPanelImpl
 
   void SyncFrame(const BvhFrame& frame)
   {
+    if (m_crowd.AgentCount() > 0) {
+      // solve into the back buffer in parallel, then swap
+      m_back.resize(m_crowd.InstanceCount());
+      m_crowd.Update(m_jobs, frame.time, m_back);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_instances.swap(m_back);
+      return;
+    }
+
     auto instances = m_bvhSolver.ResolveFrame(frame);
     {
       std::lock_guard<std::mutex> lock(m_mutex);
@@ -176,14 +262,32 @@ struct BvhPanelImpl
     }
   }
 
-  std::span<const cuber::Instance> GetCubes()
+  void SyncTime(BvhTime time)
   {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_instances;
+    if (m_crowd.AgentCount() > 0) {
+      m_back.resize(m_crowd.InstanceCount());
+      m_crowd.Update(m_jobs, time, m_back, true);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_instances.swap(m_back);
+      return;
+    }
+
+    auto& pose = m_bvhSolver.Sample(*m_bvh, time);
+    auto instances = m_bvhSolver.ResolvePose(pose);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_instances.resize(instances.size());
+      for (size_t i = 0; i < m_instances.size(); ++i) {
+        m_instances[i] = { .Matrix = instances[i] };
+      }
+    }
+    m_sender.SendPose(m_eps, pose, m_enablePackQuat);
   }
 
+  // copy under the lock. the asio thread swaps and resizes m_instances
   void GetCubes(std::vector<cuber::Instance>& cubes)
   {
+    std::lock_guard<std::mutex> lock(m_mutex);
     cubes.assign(m_instances.begin(), m_instances.end());
   }
 };
@@ -206,12 +310,6 @@ BvhPanel::UpdateGui()
 {
   m_impl->UpdateGui();
 }
-std::span<const cuber::Instance>
-BvhPanel::GetCubes()
-{
-  return m_impl->GetCubes();
-}
-
 void
 BvhPanel::GetCubes(std::vector<cuber::Instance>& cubes)
 {
@@ -4,7 +4,7 @@
 #include <chrono>
 #include <cuber/mesh.h>
 #include <functional>
-#include <span>
+#include <vector>
 #include <string_view>
 
 using RenderTime = std::chrono::duration<float, std::ratio<1, 1>>;
@@ -18,6 +18,5 @@ public:
   ~BvhPanel();
   void SetBvh(const std::shared_ptr<Bvh>& bvh);
   void UpdateGui();
-  std::span<const cuber::Instance> GetCubes();
   void GetCubes(std::vector<cuber::Instance> &cubes);
 };
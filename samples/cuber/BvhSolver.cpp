@@ -5,16 +5,40 @@
 #include <assert.h>
 #include <iostream>
 
+const uint16_t NO_PARENT = 0xFFFF;
+
 void BvhSolver::Initialize(const std::shared_ptr<Bvh> &bvh) {
   nodes_.clear();
   root_.reset();
   instances_.clear();
+  parents_.clear();
+  offsets_.clear();
+  shapes_.clear();
+  opBegin_.clear();
+  ops_.clear();
+  rotationValues_.clear();
 
   scaling_ = bvh->GuessScaling();
   for (auto &joint : bvh->joints) {
     PushJoint(joint);
   };
   CalcShape();
+
+  for (auto &joint : bvh->joints) {
+    Compile(joint);
+  }
+  opBegin_.push_back(ops_.size());
+  // XMVectorSinCos 4 angles at once
+  while (!rotationValues_.empty() && rotationValues_.size() % 4) {
+    rotationValues_.push_back(rotationValues_.back());
+  }
+  Prepare(scratch_);
+}
+
+void BvhSolver::Prepare(BvhSolverScratch &scratch) const {
+  scratch.sin.resize(rotationValues_.size());
+  scratch.cos.resize(rotationValues_.size());
+  scratch.worlds.resize(parents_.size());
 }
 
 void BvhSolver::PushJoint(BvhJoint &joint) {
@@ -30,12 +54,217 @@ void BvhSolver::PushJoint(BvhJoint &joint) {
   }
 }
 
-void BvhSolver::CalcShape() { root_->CalcShape(scaling_); }
+void BvhSolver::CalcShape() {
+  root_->CalcShape(scaling_);
+  for (auto &node : nodes_) {
+    shapes_.push_back(DirectX::XMLoadFloat4x4(&node->shape_));
+  }
+}
+
+void BvhSolver::Compile(const BvhJoint &joint) {
+  auto parent = joint.index == 0 ? NO_PARENT : joint.parent;
+  // the linear pass needs the parent solved before the child
+  assert(parent == NO_PARENT || parent < joint.index);
+  parents_.push_back(parent);
+  offsets_.push_back(joint.channels.init);
+
+  opBegin_.push_back(ops_.size());
+  auto index = static_cast<uint32_t>(joint.channels.startIndex);
+  for (size_t ch = 0; ch < joint.channels.size(); ++ch, ++index) {
+    BvhChannelOp op{
+        .type = joint.channels.types[ch],
+        .value = index,
+        .rotation = 0,
+    };
+    switch (op.type) {
+    case BvhChannelTypes::Xrotation:
+    case BvhChannelTypes::Yrotation:
+    case BvhChannelTypes::Zrotation:
+      op.rotation = static_cast<uint32_t>(rotationValues_.size());
+      rotationValues_.push_back(index);
+      break;
+    default:
+      break;
+    }
+    ops_.push_back(op);
+  }
+}
+
+// sin / cos of all rotation channels
+void BvhSolver::SinCos(std::span<const float> values,
+                       BvhSolverScratch &scratch) const {
+  for (size_t i = 0; i < rotationValues_.size(); i += 4) {
+    auto degrees = DirectX::XMVectorSet(
+        values[rotationValues_[i]], values[rotationValues_[i + 1]],
+        values[rotationValues_[i + 2]], values[rotationValues_[i + 3]]);
+    DirectX::XMVECTOR s, c;
+    DirectX::XMVectorSinCos(
+        &s, &c,
+        DirectX::XMVectorScale(degrees, DirectX::XM_PI / 180.0f));
+    DirectX::XMStoreFloat4((DirectX::XMFLOAT4 *)&scratch.sin[i], s);
+    DirectX::XMStoreFloat4((DirectX::XMFLOAT4 *)&scratch.cos[i], c);
+  }
+}
 
 std::span<DirectX::XMFLOAT4X4> BvhSolver::ResolveFrame(const BvhFrame &frame) {
-  auto span = std::span(instances_);
-  auto it = span.begin();
-  root_->ResolveFrame(frame, DirectX::XMMatrixIdentity(), scaling_, it);
-  assert(it == span.end());
+  Solve(frame, DirectX::XMMatrixIdentity(), scratch_, instances_.data(),
+        sizeof(DirectX::XMFLOAT4X4));
   return instances_;
 }
+
+void BvhSolver::ResolveFrame(const BvhFrame &frame, DirectX::FXMMATRIX root,
+                             BvhSolverScratch &scratch,
+                             std::span<cuber::Instance> out) const {
+  assert(out.size() == parents_.size());
+  Solve(frame, root, scratch, &out.data()->Matrix, sizeof(cuber::Instance));
+}
+
+// same as BvhFrame::Resolve. local rotation and translation (scaled)
+DirectX::XMMATRIX BvhSolver::Local(size_t i, const BvhFrame &frame,
+                                   const BvhSolverScratch &scratch) const {
+  auto pos = offsets_[i];
+  auto rot = DirectX::XMMatrixIdentity();
+  for (auto j = opBegin_[i]; j < opBegin_[i + 1]; ++j) {
+    auto &op = ops_[j];
+    float s, c;
+    switch (op.type) {
+    case BvhChannelTypes::Xposition:
+      pos.x = frame.values[op.value];
+      break;
+    case BvhChannelTypes::Yposition:
+      pos.y = frame.values[op.value];
+      break;
+    case BvhChannelTypes::Zposition:
+      pos.z = frame.values[op.value];
+      break;
+    case BvhChannelTypes::Xrotation:
+      // XMMatrixRotationX
+      s = scratch.sin[op.rotation];
+      c = scratch.cos[op.rotation];
+      rot = DirectX::XMMATRIX(1, 0, 0, 0,  //
+                              0, c, s, 0,  //
+                              0, -s, c, 0, //
+                              0, 0, 0, 1) *
+            rot;
+      break;
+    case BvhChannelTypes::Yrotation:
+      // XMMatrixRotationY
+      s = scratch.sin[op.rotation];
+      c = scratch.cos[op.rotation];
+      rot = DirectX::XMMATRIX(c, 0, -s, 0, //
+                              0, 1, 0, 0,  //
+                              s, 0, c, 0,  //
+                              0, 0, 0, 1) *
+            rot;
+      break;
+    case BvhChannelTypes::Zrotation:
+      // XMMatrixRotationZ
+      s = scratch.sin[op.rotation];
+      c = scratch.cos[op.rotation];
+      rot = DirectX::XMMATRIX(c, s, 0, 0,  //
+                              -s, c, 0, 0, //
+                              0, 0, 1, 0,  //
+                              0, 0, 0, 1) *
+            rot;
+      break;
+    case BvhChannelTypes::None:
+      break;
+    }
+  }
+  rot.r[3] = DirectX::XMVectorSet(pos.x * scaling_, pos.y * scaling_,
+                                  pos.z * scaling_, 1);
+  return rot;
+}
+
+void BvhSolver::Chain(size_t i, DirectX::FXMMATRIX local,
+                      DirectX::CXMMATRIX root, BvhSolverScratch &scratch,
+                      DirectX::XMFLOAT4X4 *out, size_t stride) const {
+  auto &worlds = scratch.worlds;
+  auto parent = parents_[i];
+  worlds[i] = local * (parent == NO_PARENT ? root : worlds[parent]);
+  DirectX::XMStoreFloat4x4(
+      (DirectX::XMFLOAT4X4 *)((uint8_t *)out + stride * i),
+      shapes_[i] * worlds[i]);
+}
+
+// [x, y, z][c6][c5][c4][c3][c2][c1][parent][root]
+void BvhSolver::Solve(const BvhFrame &frame, DirectX::FXMMATRIX root,
+                      BvhSolverScratch &scratch, DirectX::XMFLOAT4X4 *out,
+                      size_t stride) const {
+  SinCos(frame.values, scratch);
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    Chain(i, Local(i, frame, scratch), root, scratch, out, stride);
+  }
+}
+
+// local rotation quaternions and translations of a frame
+void BvhSolver::LocalPose(const BvhFrame &frame, BvhSolverScratch &scratch,
+                          BvhPose &pose) const {
+  SinCos(frame.values, scratch);
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    auto local = Local(i, frame, scratch);
+    DirectX::XMStoreFloat4(&pose.rotations[i],
+                           DirectX::XMQuaternionRotationMatrix(local));
+    DirectX::XMStoreFloat3(&pose.translations[i], local.r[3]);
+  }
+}
+
+void BvhSolver::Sample(const Bvh &bvh, BvhTime time, BvhSolverScratch &scratch,
+                       BvhPose &pose) const {
+  pose.time = time;
+  pose.rotations.resize(parents_.size());
+  pose.translations.resize(parents_.size());
+  scratch.pose.rotations.resize(parents_.size());
+  scratch.pose.translations.resize(parents_.size());
+
+  auto [a, b, t] = bvh.TimeToFrames(time);
+  LocalPose(bvh.GetFrame(a), scratch, pose);
+  if (a == b || t <= 0) {
+    return;
+  }
+  LocalPose(bvh.GetFrame(b), scratch, scratch.pose);
+
+  // slerp rotations, lerp translations
+  auto &next = scratch.pose;
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    auto q = DirectX::XMQuaternionSlerp(
+        DirectX::XMLoadFloat4(&pose.rotations[i]),
+        DirectX::XMLoadFloat4(&next.rotations[i]), t);
+    DirectX::XMStoreFloat4(&pose.rotations[i], q);
+    auto p = DirectX::XMVectorLerp(
+        DirectX::XMLoadFloat3(&pose.translations[i]),
+        DirectX::XMLoadFloat3(&next.translations[i]), t);
+    DirectX::XMStoreFloat3(&pose.translations[i], p);
+  }
+}
+
+void BvhSolver::SolvePose(const BvhPose &pose, DirectX::FXMMATRIX root,
+                          BvhSolverScratch &scratch, DirectX::XMFLOAT4X4 *out,
+                          size_t stride) const {
+  assert(pose.rotations.size() == parents_.size());
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    auto local = DirectX::XMMatrixRotationQuaternion(
+        DirectX::XMLoadFloat4(&pose.rotations[i]));
+    local.r[3] = DirectX::XMVectorSetW(
+        DirectX::XMLoadFloat3(&pose.translations[i]), 1);
+    Chain(i, local, root, scratch, out, stride);
+  }
+}
+
+const BvhPose &BvhSolver::Sample(const Bvh &bvh, BvhTime time) {
+  Sample(bvh, time, scratch_, pose_);
+  return pose_;
+}
+
+std::span<DirectX::XMFLOAT4X4> BvhSolver::ResolvePose(const BvhPose &pose) {
+  SolvePose(pose, DirectX::XMMatrixIdentity(), scratch_, instances_.data(),
+            sizeof(DirectX::XMFLOAT4X4));
+  return instances_;
+}
+
+void BvhSolver::ResolvePose(const BvhPose &pose, DirectX::FXMMATRIX root,
+                            BvhSolverScratch &scratch,
+                            std::span<cuber::Instance> out) const {
+  assert(out.size() == parents_.size());
+  SolvePose(pose, root, scratch, &out.data()->Matrix, sizeof(cuber::Instance));
+}
@@ -1,23 +1,100 @@
 #pragma once
 #include "Bvh.h"
 #include <DirectXMath.h>
+#include <cuber/mesh.h>
 #include <list>
 #include <memory>
 #include <stack>
 #include <vector>
 
 struct BvhNode;
+
+// one channel of the precompiled channel program
+struct BvhChannelOp {
+  BvhChannelTypes type;
+  // index in BvhFrame::values
+  uint32_t value;
+  // index in sin_ / cos_. rotation only
+  uint32_t rotation;
+};
+
+// local transform of each joint at a time between frames
+struct BvhPose {
+  BvhTime time;
+  std::vector<DirectX::XMFLOAT4> rotations;
+  // scaled
+  std::vector<DirectX::XMFLOAT3> translations;
+};
+
+// work buffers of ResolveFrame. one for each thread
+struct BvhSolverScratch {
+  std::vector<float> sin;
+  std::vector<float> cos;
+  std::vector<DirectX::XMMATRIX> worlds;
+  // the next frame of Sample
+  BvhPose pose;
+};
+
+// Joints are stored flat in parent before child order (Bvh::joints is
+// depth first). ResolveFrame is a single linear pass without recursion.
 class BvhSolver {
-  std::vector<std::shared_ptr<BvhNode>> nodes_;
+  // SoA. index is BvhJoint::index
+  std::vector<uint16_t> parents_;
+  std::vector<BvhOffset> offsets_;
+  std::vector<DirectX::XMMATRIX> shapes_;
+  // ops of joint i are [opBegin_[i], opBegin_[i + 1])
+  std::vector<uint32_t> opBegin_;
+  std::vector<BvhChannelOp> ops_;
+  // BvhFrame::values index of each rotation channel. padded to 4
+  std::vector<uint32_t> rotationValues_;
+
+  BvhSolverScratch scratch_;
+  BvhPose pose_;
   std::vector<DirectX::XMFLOAT4X4> instances_;
 
+  // tree for gui and CalcShape
+  std::vector<std::shared_ptr<BvhNode>> nodes_;
+
 public:
   float scaling_ = 1.0f;
   std::shared_ptr<BvhNode> root_;
   void Initialize(const std::shared_ptr<Bvh> &bvh);
+  size_t JointCount() const { return parents_.size(); }
   std::span<DirectX::XMFLOAT4X4> ResolveFrame(const BvhFrame &frame);
 
+  // const. many threads can share one solver, each with its own scratch.
+  // out[i].Matrix = shape * world of joint i. other members are kept.
+  void Prepare(BvhSolverScratch &scratch) const;
+  void ResolveFrame(const BvhFrame &frame, DirectX::FXMMATRIX root,
+                    BvhSolverScratch &scratch,
+                    std::span<cuber::Instance> out) const;
+
+  // time accurate. blend the two frames around time.
+  // slerp for rotations, lerp for translations.
+  const BvhPose &Sample(const Bvh &bvh, BvhTime time);
+  std::span<DirectX::XMFLOAT4X4> ResolvePose(const BvhPose &pose);
+  void Sample(const Bvh &bvh, BvhTime time, BvhSolverScratch &scratch,
+              BvhPose &pose) const;
+  void ResolvePose(const BvhPose &pose, DirectX::FXMMATRIX root,
+                   BvhSolverScratch &scratch,
+                   std::span<cuber::Instance> out) const;
+
 private:
   void PushJoint(BvhJoint &joint);
   void CalcShape();
+  void Compile(const BvhJoint &joint);
+  void SinCos(std::span<const float> values, BvhSolverScratch &scratch) const;
+  DirectX::XMMATRIX Local(size_t i, const BvhFrame &frame,
+                          const BvhSolverScratch &scratch) const;
+  void Chain(size_t i, DirectX::FXMMATRIX local, DirectX::CXMMATRIX root,
+             BvhSolverScratch &scratch, DirectX::XMFLOAT4X4 *out,
+             size_t stride) const;
+  void Solve(const BvhFrame &frame, DirectX::FXMMATRIX root,
+             BvhSolverScratch &scratch, DirectX::XMFLOAT4X4 *out,
+             size_t stride) const;
+  void LocalPose(const BvhFrame &frame, BvhSolverScratch &scratch,
+                 BvhPose &pose) const;
+  void SolvePose(const BvhPose &pose, DirectX::FXMMATRIX root,
+                 BvhSolverScratch &scratch, DirectX::XMFLOAT4X4 *out,
+                 size_t stride) const;
 };
@@ -0,0 +1,70 @@
+#include "Crowd.h"
+#include "JobSystem.h"
+#include <assert.h>
+#include <cmath>
+
+void Crowd::Initialize(const std::shared_ptr<Bvh> &bvh, uint32_t agentCount,
+                       float spacing) {
+  bvh_ = bvh;
+  agents_.clear();
+  // sized for the previous bvh. Update prepares them again
+  scratch_.clear();
+  poses_.clear();
+  if (!bvh_ || agentCount == 0) {
+    return;
+  }
+  solver_.Initialize(bvh_);
+
+  auto columns = static_cast<uint32_t>(std::ceil(std::sqrt(agentCount)));
+  auto center = (columns - 1) * spacing * 0.5f;
+  auto frameCount = bvh_->FrameCount();
+  for (uint32_t i = 0; i < agentCount; ++i) {
+    auto x = (i % columns) * spacing - center;
+    auto z = (i / columns) * spacing - center;
+    CrowdAgent agent{
+        // scatter start frames. 7919 is prime
+        .offset = bvh_->frame_time * static_cast<float>(
+                                         (i * 7919u) % std::max(frameCount, 1u)),
+    };
+    DirectX::XMStoreFloat4x4(&agent.root,
+                             DirectX::XMMatrixTranslation(x, 0, z));
+    agents_.push_back(agent);
+  }
+}
+
+void Crowd::Update(JobSystem &jobs, BvhTime time,
+                   std::span<cuber::Instance> out, bool interpolate) {
+  assert(out.size() >= InstanceCount());
+  if (scratch_.size() < jobs.WorkerCount()) {
+    scratch_.resize(jobs.WorkerCount());
+    for (auto &scratch : scratch_) {
+      solver_.Prepare(scratch);
+    }
+    poses_.resize(jobs.WorkerCount());
+  }
+
+  auto jointCount = JointCount();
+  jobs.ParallelFor(
+      AgentCount(), 4,
+      [self = this, time, jointCount, out, interpolate](
+          uint32_t begin, uint32_t end, uint32_t worker) {
+        auto &scratch = self->scratch_[worker];
+        for (auto i = begin; i < end; ++i) {
+          auto &agent = self->agents_[i];
+          if (interpolate) {
+            auto &pose = self->poses_[worker];
+            self->solver_.Sample(*self->bvh_, time + agent.offset, scratch,
+                                 pose);
+            self->solver_.ResolvePose(
+                pose, DirectX::XMLoadFloat4x4(&agent.root), scratch,
+                out.subspan(i * jointCount, jointCount));
+            continue;
+          }
+          auto frame =
+              self->bvh_->GetFrame(self->bvh_->TimeToIndex(time + agent.offset));
+          self->solver_.ResolveFrame(
+              frame, DirectX::XMLoadFloat4x4(&agent.root), scratch,
+              out.subspan(i * jointCount, jointCount));
+        }
+      });
+}
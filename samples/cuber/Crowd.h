@@ -0,0 +1,39 @@
+#pragma once
+#include "BvhSolver.h"
+#include <DirectXMath.h>
+#include <cuber/mesh.h>
+#include <memory>
+#include <span>
+#include <vector>
+
+class JobSystem;
+
+struct CrowdAgent {
+  BvhTime offset;
+  DirectX::XMFLOAT4X4 root;
+};
+
+// N independent players of one Bvh.
+// Agent i writes joints to out[i * JointCount(), (i + 1) * JointCount()).
+class Crowd {
+  std::shared_ptr<Bvh> bvh_;
+  BvhSolver solver_;
+  std::vector<CrowdAgent> agents_;
+  // one for each JobSystem worker
+  std::vector<BvhSolverScratch> scratch_;
+  std::vector<BvhPose> poses_;
+
+public:
+  // place agents on a grid on the floor with a spread of time offsets
+  void Initialize(const std::shared_ptr<Bvh> &bvh, uint32_t agentCount,
+                  float spacing = 1.5f);
+  std::span<CrowdAgent> Agents() { return agents_; }
+  uint32_t AgentCount() const { return static_cast<uint32_t>(agents_.size()); }
+  uint32_t JointCount() const {
+    return static_cast<uint32_t>(solver_.JointCount());
+  }
+  uint32_t InstanceCount() const { return AgentCount() * JointCount(); }
+  // interpolate: blend the frames around time instead of the nearest frame
+  void Update(JobSystem &jobs, BvhTime time, std::span<cuber::Instance> out,
+              bool interpolate = false);
+};
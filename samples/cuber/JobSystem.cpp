@@ -0,0 +1,155 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct Job {
+  uint32_t begin;
+  uint32_t end;
+};
+
+struct JobQueue {
+  std::mutex mutex_;
+  std::deque<Job> jobs_;
+
+  void Push(const Job &job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(job);
+  }
+  // owner. LIFO
+  bool Pop(Job *job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jobs_.empty()) {
+      return false;
+    }
+    *job = jobs_.back();
+    jobs_.pop_back();
+    return true;
+  }
+  // thief. FIFO
+  bool Steal(Job *job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jobs_.empty()) {
+      return false;
+    }
+    *job = jobs_.front();
+    jobs_.pop_front();
+    return true;
+  }
+};
+
+struct JobSystemImpl {
+  std::vector<JobQueue> queues_;
+  std::vector<std::thread> threads_;
+
+  // one ParallelFor at a time
+  std::mutex submit_;
+  const JobSystem::RangeFunc *func_ = nullptr;
+  std::atomic<uint32_t> pending_ = 0;
+
+  std::mutex wakeMutex_;
+  std::condition_variable wake_;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+
+  JobSystemImpl(uint32_t workerCount) : queues_(std::max(workerCount, 1u)) {
+    for (uint32_t i = 1; i < queues_.size(); ++i) {
+      threads_.push_back(std::thread([self = this, i]() { self->Loop(i); }));
+    }
+  }
+
+  ~JobSystemImpl() {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : threads_) {
+      t.join();
+    }
+  }
+
+  void Loop(uint32_t worker) {
+    uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wake_.wait(lock,
+                   [&]() { return stop_ || generation_ != generation; });
+        if (stop_) {
+          return;
+        }
+        generation = generation_;
+      }
+      Run(worker);
+    }
+  }
+
+  bool Take(uint32_t worker, Job *job) {
+    if (queues_[worker].Pop(job)) {
+      return true;
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      if (queues_[(worker + i) % queues_.size()].Steal(job)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // run until no job is left in any queue
+  void Run(uint32_t worker) {
+    Job job;
+    while (Take(worker, &job)) {
+      (*func_)(job.begin, job.end, worker);
+      pending_.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  void ParallelFor(uint32_t count, uint32_t grain,
+                   const JobSystem::RangeFunc &func) {
+    if (count == 0) {
+      return;
+    }
+    grain = std::max(grain, 1u);
+    if (queues_.size() == 1 || count <= grain) {
+      func(0, count, 0);
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(submit_);
+    func_ = &func;
+    uint32_t jobCount = (count + grain - 1) / grain;
+    pending_.store(jobCount, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < jobCount; ++i) {
+      queues_[i % queues_.size()].Push(
+          {i * grain, std::min(count, (i + 1) * grain)});
+    }
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    Run(0);
+    // the last jobs may still run on other workers
+    while (pending_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    func_ = nullptr;
+  }
+};
+
+JobSystem::JobSystem(uint32_t workerCount)
+    : impl_(new JobSystemImpl(workerCount)) {}
+JobSystem::~JobSystem() { delete impl_; }
+uint32_t JobSystem::WorkerCount() const {
+  return static_cast<uint32_t>(impl_->queues_.size());
+}
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain,
+                            const RangeFunc &func) {
+  impl_->ParallelFor(count, grain, func);
+}
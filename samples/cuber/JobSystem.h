@@ -0,0 +1,24 @@
+#pragma once
+#include <functional>
+#include <stdint.h>
+#include <thread>
+
+// Fixed size work-stealing thread pool.
+// Each worker owns a deque of [begin, end) ranges. It pops its own jobs from
+// the back and steals from the front of the other workers when it runs dry.
+// The thread that calls ParallelFor works as worker 0.
+class JobSystem {
+  struct JobSystemImpl *impl_ = nullptr;
+
+public:
+  // begin, end, worker index in [0, WorkerCount())
+  using RangeFunc = std::function<void(uint32_t, uint32_t, uint32_t)>;
+
+  JobSystem(uint32_t workerCount = std::thread::hardware_concurrency());
+  ~JobSystem();
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  uint32_t WorkerCount() const;
+  // split [0, count) into ranges of grain and block until all are done.
+  void ParallelFor(uint32_t count, uint32_t grain, const RangeFunc &func);
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// read only memory mapped file
+class MappedFile {
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+#ifdef _WIN32
+    if (data_) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+      CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+    }
+#else
+    if (data_) {
+      munmap((void *)data_, size_);
+    }
+    if (fd_ != -1) {
+      close(fd_);
+    }
+#endif
+  }
+
+  static std::shared_ptr<MappedFile> Open(const std::string &path) {
+    auto ptr = std::make_shared<MappedFile>();
+#ifdef _WIN32
+    ptr->file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if (ptr->file_ == INVALID_HANDLE_VALUE) {
+      return {};
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(ptr->file_, &size)) {
+      return {};
+    }
+    ptr->size_ = static_cast<size_t>(size.QuadPart);
+    if (ptr->size_ == 0) {
+      return ptr;
+    }
+    ptr->mapping_ =
+        CreateFileMappingA(ptr->file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!ptr->mapping_) {
+      return {};
+    }
+    ptr->data_ =
+        (const char *)MapViewOfFile(ptr->mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr->data_) {
+      return {};
+    }
+#else
+    ptr->fd_ = open(path.c_str(), O_RDONLY);
+    if (ptr->fd_ == -1) {
+      return {};
+    }
+    struct stat st;
+    if (fstat(ptr->fd_, &st) != 0) {
+      return {};
+    }
+    ptr->size_ = static_cast<size_t>(st.st_size);
+    if (ptr->size_ == 0) {
+      return ptr;
+    }
+    auto p = mmap(nullptr, ptr->size_, PROT_READ, MAP_PRIVATE, ptr->fd_, 0);
+    if (p == MAP_FAILED) {
+      return {};
+    }
+    // parsed front to back
+    madvise(p, ptr->size_, MADV_SEQUENTIAL);
+    ptr->data_ = (const char *)p;
+#endif
+    return ptr;
+  }
+
+  std::span<const char> Bytes() const { return {data_, size_}; }
+  std::string_view View() const { return {data_, size_}; }
+};
@@ -1,18 +1,23 @@
 #include "Payload.h"
-#include <iostream>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
 
-Payload::Payload() { std::cout << "Payload::Payload" << std::endl; }
-Payload::~Payload() { std::cout << "Payload::~Payload" << std::endl; }
+Payload::Payload(size_t capacity) : buffer(capacity) {}
+Payload::~Payload() {}
 
 void Payload::Push(const void *begin, const void *end) {
-  auto dst = buffer.size();
-  auto size = std::distance((const char *)begin, (const char *)end);
-  buffer.resize(dst + size);
-  std::copy((const char *)begin, (const char *)end, buffer.data() + dst);
+  auto src_size = std::distance((const char *)begin, (const char *)end);
+  if (size + src_size > buffer.size()) {
+    // not sized by the skeleton. fallback
+    buffer.resize(size + src_size);
+  }
+  memcpy(buffer.data() + size, begin, src_size);
+  size += src_size;
 }
 
 void Payload::SetSkeleton(std::span<srht::JointDefinition> joints) {
-  buffer.clear();
+  size = 0;
 
   srht::SkeletonHeader header{
       // .magic = {},
@@ -26,7 +31,7 @@ void Payload::SetSkeleton(std::span<srht::JointDefinition> joints) {
 
 void Payload::SetFrame(std::chrono::nanoseconds time, float x, float y, float z,
                        bool usePack) {
-  buffer.clear();
+  size = 0;
 
   srht::FrameHeader header{
       // .magic = {},
@@ -39,3 +44,56 @@ void Payload::SetFrame(std::chrono::nanoseconds time, float x, float y, float z,
   };
   Push((const char *)&header, (const char *)&header + sizeof(header));
 }
+
+size_t Payload::MaxSize(size_t jointCount) {
+  return std::max(sizeof(srht::SkeletonHeader) +
+                      sizeof(srht::JointDefinition) * jointCount,
+                  // float4 rotation (USE_QUAT32 is smaller)
+                  sizeof(srht::FrameHeader) + sizeof(float) * 4 * jointCount);
+}
+
+const uint32_t EMPTY = 0xFFFFFFFF;
+
+PayloadPool::PayloadPool(uint32_t count, size_t capacity)
+    : next_(new std::atomic<uint32_t>[count]) {
+  assert(count > 0);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto payload = std::make_unique<Payload>(capacity);
+    payload->index = i;
+    payloads_.push_back(std::move(payload));
+    next_[i] = i + 1 < count ? i + 1 : EMPTY;
+  }
+  head_ = 0;
+}
+
+Payload *PayloadPool::Acquire() {
+  auto head = head_.load(std::memory_order_acquire);
+  for (;;) {
+    auto index = static_cast<uint32_t>(head);
+    if (index == EMPTY) {
+      return nullptr;
+    }
+    auto next = next_[index].load(std::memory_order_relaxed);
+    auto tag = (head >> 32) + 1;
+    if (head_.compare_exchange_weak(head, (tag << 32) | next,
+                                    std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      return payloads_[index].get();
+    }
+  }
+}
+
+void PayloadPool::Release(Payload *payload) {
+  assert(payloads_[payload->index].get() == payload);
+  auto head = head_.load(std::memory_order_relaxed);
+  for (;;) {
+    next_[payload->index].store(static_cast<uint32_t>(head),
+                                std::memory_order_relaxed);
+    auto tag = (head >> 32) + 1;
+    if (head_.compare_exchange_weak(head, (tag << 32) | payload->index,
+                                    std::memory_order_release,
+                                    std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
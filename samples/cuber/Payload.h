@@ -1,16 +1,25 @@
 #pragma once
 #include "srht.h"
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <span>
 #include <vector>
 
 struct Payload {
+  // allocated once. [0, size) is the datagram
   std::vector<uint8_t> buffer;
+  size_t size = 0;
+  // index in PayloadPool
+  uint32_t index = 0;
+  // sends in flight. released to the pool when it reaches 0
+  std::atomic<uint32_t> pending = 0;
 
   Payload(const Payload &) = delete;
   Payload &operator=(const Payload &) = delete;
-  Payload();
+  Payload(size_t capacity = 0);
   ~Payload();
+  std::span<const uint8_t> Bytes() const { return {buffer.data(), size}; }
   void Push(const void *begin, const void *end);
   template <typename T> void Push(const T &t) {
     Push((const char *)&t, (const char *)&t + sizeof(T));
@@ -18,4 +27,26 @@ struct Payload {
   void SetSkeleton(std::span<srht::JointDefinition> joints);
   void SetFrame(std::chrono::nanoseconds time, float x, float y, float z,
                 bool usePack);
+
+  // largest datagram of the skeleton. SetSkeleton or SetFrame + rotations
+  static size_t MaxSize(size_t jointCount);
+};
+
+// Fixed number of preallocated payloads.
+// Acquire / Release are lock free (tagged index stack), so the animation
+// thread and the socket completions never contend on a mutex.
+class PayloadPool {
+  std::vector<std::unique_ptr<Payload>> payloads_;
+  std::unique_ptr<std::atomic<uint32_t>[]> next_;
+  // [tag:32][index:32]. the tag is bumped by every push/pop against ABA
+  std::atomic<uint64_t> head_;
+
+public:
+  PayloadPool(uint32_t count, size_t capacity);
+  PayloadPool(const PayloadPool &) = delete;
+  PayloadPool &operator=(const PayloadPool &) = delete;
+  size_t Capacity() const { return payloads_.front()->buffer.size(); }
+  // nullptr if all payloads are in flight
+  Payload *Acquire();
+  void Release(Payload *payload);
 };
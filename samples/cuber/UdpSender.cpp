@@ -6,30 +6,95 @@
 #include "Bvh.h"
 #include "Payload.h"
 #include <DirectXMath.h>
+#include <algorithm>
 #include <iostream>
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
 
 UdpSender::UdpSender(asio::io_context &io)
     : socket_(io, asio::ip::udp::endpoint(asio::ip::udp::v4(), 0)) {}
 
-std::shared_ptr<Payload> UdpSender::GetOrCreatePayload() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if (payloads_.empty()) {
-    return std::make_shared<Payload>();
-  } else {
-    auto payload = payloads_.front();
-    payloads_.pop_front();
-    return payload;
+void UdpSender::Reserve(size_t jointCount) {
+  auto capacity = Payload::MaxSize(jointCount);
+  auto pool = std::atomic_load(&pool_);
+  if (pool && pool->Capacity() >= capacity) {
+    return;
   }
+  // in flight payloads keep the old pool alive
+  std::atomic_store(&pool_,
+                    std::make_shared<PayloadPool>(POOL_SIZE, capacity));
 }
 
-void UdpSender::ReleasePayload(const std::shared_ptr<Payload> &payload) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  payloads_.push_back(payload);
+Payload *UdpSender::Acquire(std::shared_ptr<PayloadPool> &pool) {
+  pool = std::atomic_load(&pool_);
+  if (!pool) {
+    return nullptr;
+  }
+  auto payload = pool->Acquire();
+  if (!payload) {
+    ++dropped_;
+  }
+  return payload;
+}
+
+void UdpSender::Send(const std::shared_ptr<PayloadPool> &pool,
+                     Payload *payload,
+                     std::span<const asio::ip::udp::endpoint> eps) {
+  // guard. released after the last send
+  payload->pending = 1;
+
+#ifdef __linux__
+  // batch. sendmmsg copies to the socket buffer before returning
+  const size_t BATCH = 64;
+  iovec iov{
+      .iov_base = payload->buffer.data(),
+      .iov_len = payload->size,
+  };
+  mmsghdr msgs[BATCH];
+  while (!eps.empty()) {
+    auto count = std::min(eps.size(), BATCH);
+    for (size_t i = 0; i < count; ++i) {
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_name = (void *)eps[i].data();
+      msgs[i].msg_hdr.msg_namelen = eps[i].size();
+      msgs[i].msg_hdr.msg_iov = &iov;
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    auto sent = ::sendmmsg(socket_.native_handle(), msgs, count, MSG_DONTWAIT);
+    if (sent <= 0) {
+      // EAGAIN etc. the rest goes async
+      break;
+    }
+    eps = eps.subspan(sent);
+  }
+#endif
+
+  for (auto &ep : eps) {
+    ++payload->pending;
+    socket_.async_send_to(
+        asio::buffer(payload->buffer.data(), payload->size), ep,
+        [pool, payload](asio::error_code ec, std::size_t bytes_transferred) {
+          if (--payload->pending == 0) {
+            pool->Release(payload);
+          }
+        });
+  }
+
+  if (--payload->pending == 0) {
+    pool->Release(payload);
+  }
 }
 
-void UdpSender::SendSkeleton(asio::ip::udp::endpoint ep,
+void UdpSender::SendSkeleton(std::span<const asio::ip::udp::endpoint> eps,
                              const std::shared_ptr<Bvh> &bvh) {
-  auto payload = GetOrCreatePayload();
+  Reserve(bvh->joints.size());
+  std::shared_ptr<PayloadPool> pool;
+  auto payload = Acquire(pool);
+  if (!payload) {
+    return;
+  }
+
   joints_.clear();
   auto scaling = bvh->GuessScaling();
   for (auto joint : bvh->joints) {
@@ -43,11 +108,7 @@ void UdpSender::SendSkeleton(asio::ip::udp::endpoint ep,
   }
   payload->SetSkeleton(joints_);
 
-  socket_.async_send_to(asio::buffer(payload->buffer), ep,
-                        [self = this, payload](asio::error_code ec,
-                                               std::size_t bytes_transferred) {
-                          self->ReleasePayload(payload);
-                        });
+  Send(pool, payload, eps);
 }
 
 static DirectX::XMFLOAT4X4 ToMat(const BvhMat3 &rot, const BvhOffset &pos,
@@ -71,11 +132,33 @@ static DirectX::XMFLOAT4 ToQuat(const BvhMat3 &rot) {
   return vec4;
 }
 
-void UdpSender::SendFrame(asio::ip::udp::endpoint ep,
+static void PushRotation(Payload *payload, const DirectX::XMFLOAT4 &rotation,
+                         bool pack) {
+  if (pack) {
+    auto packed =
+        quat_packer::Pack(rotation.x, rotation.y, rotation.z, rotation.w);
+#if _DEBUG
+    {
+      mu::quatf debug_q{rotation.x, rotation.y, rotation.z, rotation.w};
+      auto debug_packed = mu::quat32(debug_q);
+      assert(*(uint32_t *)&debug_packed.value == packed);
+    }
+#endif
+    payload->Push(packed);
+  } else {
+    payload->Push(rotation);
+  }
+}
+
+void UdpSender::SendFrame(std::span<const asio::ip::udp::endpoint> eps,
                           const std::shared_ptr<Bvh> &bvh,
                           const BvhFrame &frame, bool pack) {
-
-  auto payload = GetOrCreatePayload();
+  Reserve(bvh->joints.size());
+  std::shared_ptr<PayloadPool> pool;
+  auto payload = Acquire(pool);
+  if (!payload) {
+    return;
+  }
 
   auto scaling = bvh->GuessScaling();
   for (auto &joint : bvh->joints) {
@@ -88,25 +171,28 @@ void UdpSender::SendFrame(asio::ip::udp::endpoint ep,
           std::chrono::duration_cast<std::chrono::nanoseconds>(frame.time),
           pos.x * scaling, pos.y * scaling, pos.z * scaling, pack);
     }
-    if (pack) {
-      auto packed =
-          quat_packer::Pack(rotation.x, rotation.y, rotation.z, rotation.w);
-#if _DEBUG
-      {
-        mu::quatf debug_q{rotation.x, rotation.y, rotation.z, rotation.w};
-        auto debug_packed = mu::quat32(debug_q);
-        assert(*(uint32_t *)&debug_packed.value == packed);
-      }
-      payload->Push(packed);
-#endif
-    } else {
-      payload->Push(rotation);
-    }
+    PushRotation(payload, rotation, pack);
+  }
+
+  Send(pool, payload, eps);
+}
+
+void UdpSender::SendPose(std::span<const asio::ip::udp::endpoint> eps,
+                         const BvhPose &pose, bool pack) {
+  Reserve(pose.rotations.size());
+  std::shared_ptr<PayloadPool> pool;
+  auto payload = Acquire(pool);
+  if (!payload) {
+    return;
+  }
+
+  auto &root = pose.translations[0];
+  payload->SetFrame(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(pose.time), root.x,
+      root.y, root.z, pack);
+  for (auto &rotation : pose.rotations) {
+    PushRotation(payload, rotation, pack);
   }
 
-  socket_.async_send_to(asio::buffer(payload->buffer), ep,
-                        [self = this, payload](asio::error_code ec,
-                                               std::size_t bytes_transferred) {
-                          self->ReleasePayload(payload);
-                        });
+  Send(pool, payload, eps);
 }
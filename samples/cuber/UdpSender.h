@@ -1,25 +1,52 @@
 #pragma once
 #include "Bvh.h"
+#include "BvhSolver.h"
 #include "Payload.h"
 #include "srht.h"
 #include <asio.hpp>
-#include <list>
+#include <atomic>
 #include <memory>
-#include <mutex>
 #include <span>
 
+// Serialize a frame once into a pooled payload and send it to every endpoint.
+// On Linux the datagrams are batched with sendmmsg.
 class UdpSender {
   asio::ip::udp::socket socket_;
-  std::list<std::shared_ptr<Payload>> payloads_;
-  std::mutex mutex_;
+  std::shared_ptr<PayloadPool> pool_;
   std::vector<srht::JointDefinition> joints_;
+  std::atomic<uint64_t> dropped_ = 0;
+
+  Payload *Acquire(std::shared_ptr<PayloadPool> &pool);
+  void Send(const std::shared_ptr<PayloadPool> &pool, Payload *payload,
+            std::span<const asio::ip::udp::endpoint> eps);
 
 public:
+  // frames in flight
+  static const uint32_t POOL_SIZE = 64;
+
   UdpSender(asio::io_context &io);
-  std::shared_ptr<Payload> GetOrCreatePayload();
-  void ReleasePayload(const std::shared_ptr<Payload> &payload);
-  void SendSkeleton(asio::ip::udp::endpoint ep,
+  // frames skipped because the pool was exhausted
+  uint64_t DroppedCount() const { return dropped_; }
+  // (re)allocate the pool from the skeleton size
+  void Reserve(size_t jointCount);
+  void SendSkeleton(std::span<const asio::ip::udp::endpoint> eps,
                     const std::shared_ptr<Bvh> &bvh);
+  void SendFrame(std::span<const asio::ip::udp::endpoint> eps,
+                 const std::shared_ptr<Bvh> &bvh, const BvhFrame &frame,
+                 bool pack);
+  // interpolated. translations of the pose are already scaled
+  void SendPose(std::span<const asio::ip::udp::endpoint> eps,
+                const BvhPose &pose, bool pack);
+
+  void SendSkeleton(asio::ip::udp::endpoint ep,
+                    const std::shared_ptr<Bvh> &bvh) {
+    SendSkeleton({&ep, 1}, bvh);
+  }
   void SendFrame(asio::ip::udp::endpoint ep, const std::shared_ptr<Bvh> &bvh,
-                 const BvhFrame &frame, bool pack);
+                 const BvhFrame &frame, bool pack) {
+    SendFrame({&ep, 1}, bvh, frame, pack);
+  }
+  void SendPose(asio::ip::udp::endpoint ep, const BvhPose &pose, bool pack) {
+    SendPose({&ep, 1}, pose, pack);
+  }
 };
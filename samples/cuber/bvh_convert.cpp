@@ -0,0 +1,42 @@
+// convert text bvh to the binary cache format
+//
+// usage: bvh_convert input.bvh [output=input.bvh.bin] [--int16]
+#include "Bvh.h"
+#include <stdio.h>
+#include <string_view>
+
+int main(int argc, char **argv) {
+  std::string_view input;
+  std::string output;
+  auto encoding = BvhFrameEncoding::Float32;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--int16") {
+      encoding = BvhFrameEncoding::Int16;
+    } else if (input.empty()) {
+      input = arg;
+    } else {
+      output = arg;
+    }
+  }
+  if (input.empty()) {
+    printf("usage: %s input.bvh [output=input.bvh.bin] [--int16]\n", argv[0]);
+    return 1;
+  }
+  if (output.empty()) {
+    output = Bvh::CachePath(input);
+  }
+
+  auto bvh = Bvh::ParseFile(input, false);
+  if (!bvh) {
+    printf("fail to load: %s\n", std::string(input).c_str());
+    return 2;
+  }
+  if (!bvh->WriteBinary(output, encoding)) {
+    printf("fail to write: %s\n", output.c_str());
+    return 3;
+  }
+  printf("%s => %s (%s)\n", std::string(input).c_str(), output.c_str(),
+         encoding == BvhFrameEncoding::Int16 ? "int16" : "float32");
+  return 0;
+}
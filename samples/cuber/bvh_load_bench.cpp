@@ -0,0 +1,59 @@
+// compare text bvh load time against the binary cache
+//
+// usage: bvh_load_bench file.bvh [repeat=5]
+#include "Bvh.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+
+static double Measure(int repeat, const std::function<bool()> &load) {
+  auto best = 1e30;
+  for (int i = 0; i < repeat; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    if (!load()) {
+      return -1;
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("usage: %s file.bvh [repeat=5]\n", argv[0]);
+    return 1;
+  }
+  std::string_view file = argv[1];
+  int repeat = argc > 2 ? atoi(argv[2]) : 5;
+
+  auto bvh = Bvh::ParseFile(file, false);
+  if (!bvh) {
+    printf("fail to load: %s\n", argv[1]);
+    return 2;
+  }
+  auto f32 = std::string(file) + ".f32.bin";
+  auto i16 = std::string(file) + ".i16.bin";
+  if (!bvh->WriteBinary(f32, BvhFrameEncoding::Float32) ||
+      !bvh->WriteBinary(i16, BvhFrameEncoding::Int16)) {
+    printf("fail to write binary\n");
+    return 3;
+  }
+  printf("%u frames x %u channels\n", bvh->FrameCount(),
+         bvh->frame_channel_count);
+
+  auto text = Measure(repeat, [file]() { return !!Bvh::ParseFile(file, false); });
+  auto binary = Measure(repeat, [&f32]() { return !!Bvh::LoadBinary(f32); });
+  auto quantized =
+      Measure(repeat, [&i16]() { return !!Bvh::LoadBinary(i16); });
+  printf("text   : %10.3f ms\n", text);
+  printf("float32: %10.3f ms x%.1f\n", binary, text / binary);
+  printf("int16  : %10.3f ms x%.1f\n", quantized, text / quantized);
+
+  remove(f32.c_str());
+  remove(i16.c_str());
+  return 0;
+}
@@ -0,0 +1,55 @@
+// solve a crowd of bvh skeletons with 1, 2, 4, 8, 16 threads
+//
+// usage: crowd_bench file.bvh [agents=256] [frames=300]
+#include "Bvh.h"
+#include "Crowd.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("usage: %s file.bvh [agents=256] [frames=300]\n", argv[0]);
+    return 1;
+  }
+  auto bvh = Bvh::ParseFile(argv[1]);
+  if (!bvh) {
+    printf("fail to load: %s\n", argv[1]);
+    return 2;
+  }
+  uint32_t agents = argc > 2 ? atoi(argv[2]) : 256;
+  uint32_t frames = argc > 3 ? atoi(argv[3]) : 300;
+
+  Crowd crowd;
+  crowd.Initialize(bvh, agents);
+  std::vector<cuber::Instance> out(crowd.InstanceCount());
+  printf("%u agents x %u joints, %u frames\n", crowd.AgentCount(),
+         crowd.JointCount(), frames);
+
+  double base = 0;
+  for (uint32_t threads : {1, 2, 4, 8, 16}) {
+    JobSystem jobs(threads);
+    // warm up
+    crowd.Update(jobs, {}, out);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; ++i) {
+      crowd.Update(jobs, bvh->frame_time * static_cast<float>(i), out);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    auto jointsPerSecond =
+        static_cast<double>(crowd.InstanceCount()) * frames / elapsed.count();
+    if (threads == 1) {
+      base = jointsPerSecond;
+    }
+    printf("%2u threads: %8.3f ms/frame %14.0f joints/s x%.2f\n", threads,
+           elapsed.count() * 1000 / frames, jointsPerSecond,
+           jointsPerSecond / base);
+  }
+
+  return 0;
+}
@@ -143,6 +143,7 @@ main(int argc, char** argv)
   cubeRenderer.UploadPallete();
 
   grapho::imgui::PrintfBuffer buf;
+  std::vector<cuber::Instance> cubes;
 
   // main loop
   while (auto time = platform.NewFrame(app.clear_color)) {
@@ -154,7 +155,7 @@ main(int argc, char** argv)
 
     // scene
     {
-      auto cubes = bvhPanel.GetCubes();
+      bvhPanel.GetCubes(cubes);
       instances.resize(1 + cubes.size());
       std::copy(cubes.begin(), cubes.end(), instances.data() + 1);
 
@@ -4,6 +4,7 @@
 #include <cuber/gl3/GlLineRenderer.h>
 #include <grapho/gl3/texture.h>
 #include <grapho/imgui/printfbuffer.h>
+#include <algorithm>
 #include <thread>
 #include <vuloxr/xr/session.h>
 
@@ -28,6 +29,20 @@ struct ViewSwapchain {
   }
 };
 
+struct MultiviewSwapchain {
+  std::vector<std::shared_ptr<vuloxr::gl::MultiviewRenderTarget>> backbuffers;
+
+  MultiviewSwapchain(std::shared_ptr<GraphicsSwapchain> &swapchain) {
+    for (auto &image : swapchain->swapchainImages) {
+      this->backbuffers.push_back(
+          std::make_shared<vuloxr::gl::MultiviewRenderTarget>(
+              image.image, swapchain->swapchainCreateInfo.width,
+              swapchain->swapchainCreateInfo.height,
+              swapchain->swapchainCreateInfo.arraySize));
+    }
+  }
+};
+
 void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
                   XrSystemId systemId, XrSession session, XrSpace appSpace,
                   std::span<const int64_t> formats,
@@ -40,21 +55,35 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
   vuloxr::xr::Stereoscope stereoscope(instance, systemId,
                                       viewConfigurationType);
   auto format = Graphics::selectColorSwapchainFormat(formats);
-  std::vector<std::shared_ptr<GraphicsSwapchain>> swapchains;
-  std::vector<std::shared_ptr<ViewSwapchain>> views;
-  for (uint32_t i = 0; i < stereoscope.views.size(); i++) {
-    auto swapchain = std::make_shared<GraphicsSwapchain>(
-        session, i, stereoscope.viewConfigurations[i], format, SwapchainImage);
-    swapchains.push_back(swapchain);
-
-    views.push_back(std::make_shared<ViewSwapchain>(swapchain));
-  }
 
   // AppEngine engine(instance, systemId, session, appSpace);
   // cuber
   cuber::gl3::GlCubeRenderer cubeRenderer;
   cuber::gl3::GlLineRenderer lineRenderer;
 
+  std::vector<std::shared_ptr<GraphicsSwapchain>> swapchains;
+  std::vector<std::shared_ptr<ViewSwapchain>> views;
+  // single pass stereo. one swapchain with a layer for each eye.
+  // a swapchain for each eye if the multiview shaders are not available
+  std::shared_ptr<MultiviewSwapchain> multiview;
+  if (stereoscope.views.size() == 2 && cubeRenderer.InitStereo() &&
+      lineRenderer.InitStereo()) {
+    auto swapchain = std::make_shared<GraphicsSwapchain>(
+        session, 0, stereoscope.viewConfigurations[0], format, SwapchainImage,
+        2);
+    swapchains.push_back(swapchain);
+    multiview = std::make_shared<MultiviewSwapchain>(swapchain);
+  } else {
+    for (uint32_t i = 0; i < stereoscope.views.size(); i++) {
+      auto swapchain = std::make_shared<GraphicsSwapchain>(
+          session, i, stereoscope.viewConfigurations[i], format,
+          SwapchainImage);
+      swapchains.push_back(swapchain);
+
+      views.push_back(std::make_shared<ViewSwapchain>(swapchain));
+    }
+  }
+
   std::vector<cuber::LineVertex> lines;
   cuber::PushGrid(lines);
 
@@ -113,7 +142,64 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
       if (stereoscope.Locate(session, appSpace, frameState.predictedDisplayTime,
                              viewConfigurationType)) {
 
+        // upload once, draw for each eye
+        auto mapped = cubeRenderer.BeginInstances(instances.size());
+        std::copy(instances.begin(), instances.end(), mapped.begin());
+        cubeRenderer.EndInstances();
+
+        /* ------------------------------------------- *
+         *  Matrix Setup
+         *    (matPV)  = (proj) x (view)
+         * ------------------------------------------- */
+        std::vector<XrMatrix4x4f> matP(stereoscope.views.size());
+        std::vector<XrMatrix4x4f> matV(stereoscope.views.size());
         for (uint32_t i = 0; i < stereoscope.views.size(); ++i) {
+          const auto &view = stereoscope.views[i];
+
+          /* Projection Matrix */
+          XrMatrix4x4f_CreateProjectionFov(&matP[i], GRAPHICS_OPENGL_ES,
+                                           view.fov, 0.05f, 100.0f);
+
+          /* View Matrix (inverse of Camera matrix) */
+          XrMatrix4x4f matC;
+          XrVector3f scale = {1.0f, 1.0f, 1.0f};
+          XrMatrix4x4f_CreateTranslationRotationScale(
+              &matC, &view.pose.position, &view.pose.orientation, &scale);
+          XrMatrix4x4f_InvertRigidBody(&matV[i], &matC);
+        }
+
+        // cull once against the union of both eyes
+        if (stereoscope.views.size() == 2) {
+          cubeRenderer.Cull(matP[0].m, matV[0].m, matP[1].m, matV[1].m);
+        }
+
+        if (multiview) {
+          // both eyes in one pass
+          auto swapchain = swapchains[0];
+          auto [index, image] = swapchain->AcquireImage();
+          for (uint32_t i = 0; i < stereoscope.views.size(); ++i) {
+            composition.pushView(
+                swapchain->ProjectionView(stereoscope.views[i], i));
+          }
+
+          glBindFramebuffer(GL_FRAMEBUFFER,
+                            multiview->backbuffers[index]->fbo.id);
+          glViewport(0, 0, swapchain->swapchainCreateInfo.width,
+                     swapchain->swapchainCreateInfo.height);
+
+          glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+          glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+          texture->Activate(TextureBind);
+          cubeRenderer.RenderStereo(matP[0].m, matV[0].m, matP[1].m,
+                                    matV[1].m);
+          lineRenderer.RenderStereo(matP[0].m, matV[0].m, matP[1].m,
+                                    matV[1].m, lines);
+
+          swapchain->EndSwapchain();
+        }
+
+        for (uint32_t i = 0; i < views.size(); ++i) {
           // XrCompositionLayerProjectionView(left / right)
           auto swapchain = swapchains[i];
           auto [index, image, projectionLayer] =
@@ -134,28 +220,9 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
           glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
           glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-          /* ------------------------------------------- *
-           *  Matrix Setup
-           *    (matPV)  = (proj) x (view)
-           *    (matPVM) = (proj) x (view) x (model)
-           * ------------------------------------------- */
-          XrMatrix4x4f matP, matV, matC, matM, matPV, matPVM;
-
-          /* Projection Matrix */
-          XrMatrix4x4f_CreateProjectionFov(&matP, GRAPHICS_OPENGL_ES,
-                                           projectionLayer.fov, 0.05f, 100.0f);
-
-          /* View Matrix (inverse of Camera matrix) */
-          XrVector3f scale = {1.0f, 1.0f, 1.0f};
-          const auto &vewPose = projectionLayer.pose;
-          XrMatrix4x4f_CreateTranslationRotationScale(
-              &matC, &vewPose.position, &vewPose.orientation, &scale);
-          XrMatrix4x4f_InvertRigidBody(&matV, &matC);
-
           texture->Activate(TextureBind);
-          cubeRenderer.Render(matP.m, matV.m, instances.data(),
-                              instances.size());
-          lineRenderer.Render(matP.m, matV.m, lines);
+          cubeRenderer.Render(matP[i].m, matV[i].m);
+          lineRenderer.Render(matP[i].m, matV[i].m, lines);
 
           swapchain->EndSwapchain();
         }
@@ -78,6 +78,7 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
       device, vuloxr::vk::glsl_fs_to_spv(FS), "main");
 
   vuloxr::vk::PipelineBuilder builder;
+  builder.pipelineCache = device.pipelineCache;
   builder.rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
   auto pipeline =
       builder.create(device, renderPass, depthStencil, pipelineLayout,
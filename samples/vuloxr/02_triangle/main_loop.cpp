@@ -37,7 +37,9 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
   auto [renderPass, depthStencil] = vuloxr::vk::createColorRenderPass(
       device, swapchain.createInfo.imageFormat);
 
-  auto pipeline = vuloxr::vk::PipelineBuilder().create(
+  vuloxr::vk::PipelineBuilder builder;
+  builder.pipelineCache = device.pipelineCache;
+  auto pipeline = builder.create(
       device, renderPass, depthStencil, pipelineLayout,
       {
           vs.pipelineShaderStageCreateInfo,
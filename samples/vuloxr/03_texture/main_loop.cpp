@@ -2,8 +2,10 @@
 #include <vuloxr/vk.h>
 #include <vuloxr/vk/buffer.h>
 #include <vuloxr/vk/command.h>
+#include <vuloxr/vk/descriptor.h>
 #include <vuloxr/vk/pipeline.h>
 #include <vuloxr/vk/shaderc.h>
+#include <vuloxr/vk/upload.h>
 
 const char VS[] = {
 #embed "texture.vert"
@@ -75,39 +77,18 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
   vuloxr::vk::Texture texture(device, 2, 2);
   texture.setMemory(physicalDevice.allocForTransfer(device, texture.image));
 
+  // the texture is copied on the transfer queue while the loop is running
+  vuloxr::vk::UploadService upload(physicalDevice, device, 1024 * 1024);
+  uint64_t textureTicket;
   {
-    // upload image
     uint8_t pixels[] = {
         255, 0,   0,   255, // R
         0,   255, 0,   255, // G
         0,   0,   255, 255, // B
         255, 255, 255, 255, // WHITE
     };
-    VkDeviceSize imageSize = 2 * 2 * 4;
-
-    vuloxr::vk::Buffer stagingBuffer(device, imageSize,
-                                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-    auto stagingMemory = physicalDevice.allocForMap(device, stagingBuffer);
-    stagingMemory.mapWrite(pixels, imageSize);
-
-    vuloxr::vk::CommandBufferPool pool(device,
-                                       physicalDevice.graphicsFamilyIndex);
-    pool.reset(1);
-    auto cmd = pool.commandBuffers[0];
-
-    {
-      vuloxr::vk::CommandScope(physicalDevice.graphicsFamilyIndex, cmd)
-          .transitionImageLayout(texture.image, VK_FORMAT_R8G8B8_SRGB,
-                                 VK_IMAGE_LAYOUT_UNDEFINED,
-                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-          .copyBufferToImage(stagingBuffer, texture.image, 2, 2)
-          .transitionImageLayout(texture.image, VK_FORMAT_R8G8B8A8_SRGB,
-                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    }
-
-    device.submit(cmd);
-    vkQueueWaitIdle(device.queue);
+    upload.copyImage(texture.image, {2, 2}, pixels, sizeof(pixels));
+    textureTicket = upload.flush();
   }
 
   Vertex vertices[] = {
@@ -155,26 +136,25 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
   indexBuffer.allocate(physicalDevice, device,
                        std::span<const uint16_t>({0, 1, 2, 2, 3, 0}));
 
-  vuloxr::vk::DescriptorSet descriptorSets(
-      device, swapchain.images.size(),
+  vuloxr::vk::DescriptorLayoutCache layouts(device);
+  auto descriptorSetLayout = layouts.get({
       {
-          {
-              .binding = 0,
-              .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-              .descriptorCount = 1,
-              .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-              .pImmutableSamplers = nullptr,
-          },
-          {
-              .binding = 1,
-              .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-              .descriptorCount = 1,
-              // indicate that we want to use the combined image sampler
-              // descriptor in the fragment shader
-              .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-              .pImmutableSamplers = nullptr,
-          },
-      });
+          .binding = 0,
+          .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          .descriptorCount = 1,
+          .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+          .pImmutableSamplers = nullptr,
+      },
+      {
+          .binding = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          .descriptorCount = 1,
+          // indicate that we want to use the combined image sampler
+          // descriptor in the fragment shader
+          .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+          .pImmutableSamplers = nullptr,
+      },
+  });
 
   auto [renderPass, depthStencil] = vuloxr::vk::createColorRenderPass(
       device, swapchain.createInfo.imageFormat);
@@ -182,7 +162,7 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
       .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
       //
       .setLayoutCount = 1,
-      .pSetLayouts = &descriptorSets.descriptorSetLayout,
+      .pSetLayouts = &descriptorSetLayout,
       //
       .pushConstantRangeCount = 0,
       .pPushConstantRanges = nullptr,
@@ -197,6 +177,7 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
       device, vuloxr::vk::glsl_fs_to_spv(FS), "main");
 
   vuloxr::vk::PipelineBuilder builder;
+  builder.pipelineCache = device.pipelineCache;
   builder.rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
   auto pipeline = builder.create(
       device, renderPass, depthStencil, pipelineLayout,
@@ -210,6 +191,11 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
                                      physicalDevice.graphicsFamilyIndex);
   std::vector<std::shared_ptr<vuloxr::vk::UniformBuffer<UniformBufferObject>>>
       uniformBuffers(swapchain.images.size());
+  // transient sets. reset after the fence of the image
+  std::vector<vuloxr::vk::DescriptorAllocator> descriptorAllocators;
+  for (size_t i = 0; i < swapchain.images.size(); ++i) {
+    descriptorAllocators.emplace_back(device, 4);
+  }
 
   vuloxr::vk::AcquireSemaphorePool semaphorePool(device);
 
@@ -224,19 +210,6 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
             device);
         ubo->memory = physicalDevice.allocForMap(device, ubo->buffer);
         uniformBuffers[acquired.imageIndex] = ubo;
-
-        descriptorSets.update(
-            acquired.imageIndex,
-            std::span<const vuloxr::vk::DescriptorUpdateInfo>({
-                {
-                    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                    .pBufferInfo = &ubo->info,
-                },
-                {
-                    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    .pImageInfo = &texture.descriptorInfo,
-                },
-            }));
       }
       {
         // update ubo
@@ -260,14 +233,24 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
       auto cmd = &pool[acquired.imageIndex];
       semaphorePool.resetFenceAndMakePairSemaphore(cmd->submitFence,
                                                    acquireSemaphore);
-      auto descriptorSet = descriptorSets.descriptorSets[acquired.imageIndex];
+      auto &descriptorAllocator = descriptorAllocators[acquired.imageIndex];
+      descriptorAllocator.reset();
+      auto descriptorSet = descriptorAllocator.allocate(descriptorSetLayout);
+      vuloxr::vk::DescriptorWriter()
+          .buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ubo->buffer,
+                  sizeof(UniformBufferObject))
+          .image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                 texture.imageView, texture.sampler)
+          .update(device, descriptorSet);
       {
         vuloxr::vk::RenderPassRecording recording(
             cmd->commandBuffer, pipelineLayout, pipeline.renderPass,
             backbuffer->framebuffer, swapchain.createInfo.imageExtent, clear,
             descriptorSet, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
 
-        indexBuffer.draw(cmd->commandBuffer, pipeline, vertexBuffer.buffer);
+        if (upload.isComplete(textureTicket)) {
+          indexBuffer.draw(cmd->commandBuffer, pipeline, vertexBuffer.buffer);
+        }
       }
       vuloxr::vk::CheckVkResult(cmd->submit(acquireSemaphore));
       res = swapchain.present(acquired.imageIndex, cmd->submitSemaphore);
@@ -11,6 +11,7 @@
 #include <vuloxr/vk/buffer.h>
 #include <vuloxr/vk/command.h>
 #include <vuloxr/vk/pipeline.h>
+#include <vuloxr/vk/profiler.h>
 #include <vuloxr/vk/shaderc.h>
 
 VkClearValue clear_values[2] = {
@@ -94,15 +95,20 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
     view.calc();
   };
 
-  vuloxr::vk::UniformBuffer<DirectX::XMFLOAT4X4> ubo(device);
-  ubo.memory = physicalDevice.allocForMap(device, ubo.buffer);
+  // record the next frame while the gpu draws the previous one
+  const uint32_t FRAMES_IN_FLIGHT = 2;
+  vuloxr::vk::UniformRing<DirectX::XMFLOAT4X4> ubo(physicalDevice, device,
+                                                   FRAMES_IN_FLIGHT);
+  vuloxr::vk::GpuProfiler profiler(physicalDevice, device,
+                                   physicalDevice.graphicsFamilyIndex,
+                                   FRAMES_IN_FLIGHT, 8, true);
 
   vuloxr::vk::DescriptorSet descriptor(
       device, 1,
       {
           {
               .binding = 0,
-              .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+              .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
               .descriptorCount = 1,
               .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
               .pImmutableSamplers = NULL,
@@ -161,12 +167,14 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
 
   descriptor.update(0, std::span<const vuloxr::vk::DescriptorUpdateInfo>({
                            vuloxr::vk::DescriptorUpdateInfo{
-                               .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                               .type =
+                                   VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                                .pBufferInfo = &ubo.info,
                            },
                        }));
 
   vuloxr::vk::PipelineBuilder builder;
+  builder.pipelineCache = device.pipelineCache;
   auto pipeline = builder.create(
       device, render_pass, depthstencil, pipeline_layout,
       {vs.pipelineShaderStageCreateInfo, fs.pipelineShaderStageCreateInfo},
@@ -178,11 +186,9 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
       VK_SAMPLE_COUNT_1_BIT);
   framebuffers.reset(physicalDevice, render_pass,
                      swapchain.createInfo.imageExtent, swapchain.images);
-  vuloxr::vk::CommandBufferPool pool(device,
-                                     physicalDevice.graphicsFamilyIndex);
-  pool.reset(1);
-
-  vuloxr::vk::AcquireSemaphorePool semaphorePool(device);
+  vuloxr::vk::FrameContextRing frames(physicalDevice, device,
+                                      physicalDevice.graphicsFamilyIndex,
+                                      FRAMES_IN_FLIGHT);
 
   DirectX::XMFLOAT4X4 model = {
       1, 0, 0, 0, //
@@ -192,39 +198,53 @@ void main_loop(const vuloxr::gui::WindowLoopOnce &windowLoopOnce,
   };
 
   while (auto state = windowLoopOnce()) {
+    // wait the frame that used this context. then its ubo slice is free
+    auto &frame = frames.next();
+
     // acquire
-    auto acquireSemaphore = semaphorePool.getOrCreate();
-    auto [res, acquired] = swapchain.acquireNextImage(acquireSemaphore);
+    auto [res, acquired] = swapchain.acquireNextImage(frame.acquireSemaphore);
+    if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
+      // VK_ERROR_OUT_OF_DATE_KHR. nothing acquired, the semaphore is unsignaled
+      continue;
+    }
 
     // update animation
     drag.update(state->mouse);
     // model = rotate(std::chrono::nanoseconds(acquired.presentTimeNano));
-    ubo.value = vuloxr::camera::vulkanViewProjectionClip(view.matrix,
-                                                         projection.matrix);
-    ubo.mapWrite();
+    uint32_t offset = ubo.write(
+        frame.index, vuloxr::camera::vulkanViewProjectionClip(
+                         view.matrix, projection.matrix));
 
     // render
-    auto cmd = &pool[0];
-    semaphorePool.resetFenceAndMakePairSemaphore(cmd->submitFence,
-                                                 acquireSemaphore);
+    frames.begin(frame);
+    profiler.beginFrame(frame.commandBuffer, frame.index, frame.frameNumber);
     {
-      vuloxr::vk::RenderPassRecording recording(
-          cmd->commandBuffer, pipeline_layout, render_pass,
+      vuloxr::vk::GpuZone zone(profiler, frame.commandBuffer, "cube pass");
+      vuloxr::vk::RenderPassScope pass(
+          frame.commandBuffer, pipeline_layout, render_pass,
           framebuffers[acquired.imageIndex].framebuffer,
           swapchain.createInfo.imageExtent, clear_values,
-          descriptor.descriptorSets[0],
-          VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+          descriptor.descriptorSets[0], {&offset, 1});
 
-      vertex_buffer.draw(cmd->commandBuffer, pipeline);
+      vertex_buffer.draw(frame.commandBuffer, pipeline);
+    }
+    vuloxr::vk::CheckVkResult(frames.submit(frame));
+
+    // no fence wait. present waits the submit on the gpu
+    auto presented =
+        swapchain.present(acquired.imageIndex, frame.renderSemaphore);
+    if (presented != VK_SUBOPTIMAL_KHR &&
+        presented != VK_ERROR_OUT_OF_DATE_KHR) {
+      vuloxr::vk::CheckVkResult(presented);
     }
 
-    device.submit(cmd->commandBuffer, acquireSemaphore, {}, cmd->submitFence);
-
-    // Make sure command buffer is finished before presenting
-    vuloxr::vk::CheckVkResult(cmd->waitFence(device));
-
-    vuloxr::vk::CheckVkResult(
-        swapchain.present(acquired.imageIndex /*, cmd->submitSemaphore*/));
+    if (frame.frameNumber % 600 == 0) {
+      vuloxr::Logger::Verbose(
+          "[frame %llu] cpu wait %.3fms, gpu busy %.3fms",
+          (unsigned long long)frame.frameNumber, frame.cpuWait.count() / 1e6,
+          frame.gpuBusy.count() / 1e6);
+      profiler.logStats();
+    }
   }
 
   vkDeviceWaitIdle(device);
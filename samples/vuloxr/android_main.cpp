@@ -3,6 +3,8 @@
 
 #include "main_loop.h"
 #include "vuloxr/vk.h"
+#include <vuloxr/vk/pipeline_cache.h>
+#include <vuloxr/vk/shaderc.h>
 
 auto APP_NAME = "vuloxr";
 
@@ -40,6 +42,13 @@ static bool _main_loop(android_app *app, vuloxr::android::UserData *userdata) {
   vuloxr::vk::CheckVkResult(device.create(instance, *physicalDevice,
                                           physicalDevice->graphicsFamilyIndex));
 
+  // shader and pipeline compilation dominate the cold start on Quest
+  std::filesystem::path cacheDir = app->activity->internalDataPath;
+  vuloxr::vk::ShaderCache::get().directory = cacheDir / "shaders";
+  vuloxr::vk::PipelineCache pipelineCache(*physicalDevice, device,
+                                          cacheDir / "pipeline.bin");
+  device.pipelineCache = pipelineCache;
+
   vuloxr::vk::Swapchain swapchain(instance, surface, *physicalDevice,
                                   *presentFamily, device, device.queueFamily);
   swapchain.create();
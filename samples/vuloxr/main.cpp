@@ -1,5 +1,6 @@
 #include "main_loop.h"
 #include <vuloxr/gui/glfw.h>
+#include <vuloxr/vk/shaderc.h>
 
 auto NAME = "vuloxr";
 
@@ -21,9 +22,14 @@ int main(int argc, char **argv) {
 
   try {
     vuloxr::vk::Vulkan vulkan = glfw.createVulkan(useDebug);
+    auto &allocator = vulkan.enableAllocator();
+    // skip glsl compilation and pipeline compilation from the second run
+    vuloxr::vk::ShaderCache::get().directory = "vuloxr_cache/shaders";
+    vulkan.enablePipelineCache("vuloxr_cache/pipeline.bin");
 
     main_loop(glfw.makeWindowLoopOnce(), vulkan.instance, vulkan.swapchain,
               vulkan.physicalDevice, vulkan.device, window);
+    allocator.dumpStats();
   } catch (const std::exception &ex) {
     vuloxr::Logger::Error("%s", ex.what());
   } catch (...) {
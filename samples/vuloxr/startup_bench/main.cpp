@@ -0,0 +1,150 @@
+//
+// measure the startup cost of glsl => spv => VkPipeline
+//
+// cold: empty cache directory. every shader is compiled by shaderc and every
+//       pipeline by the driver
+// warm: spv from disk and pipelines from the saved VkPipelineCache
+//
+// note: some drivers keep their own disk cache (mesa, nvidia), so the cold
+// pipeline time may already be low on a desktop.
+//
+#include <vuloxr/gui/glfw.h>
+#include <vuloxr/vk/pipeline.h>
+#include <vuloxr/vk/pipeline_cache.h>
+#include <vuloxr/vk/shaderc.h>
+
+const char TRIANGLE_VS[] = {
+#embed "../02_triangle/shader.vert"
+    , 0};
+const char TRIANGLE_FS[] = {
+#embed "../02_triangle/shader.frag"
+    , 0};
+const char HELLO_VS[] = {
+#embed "../02_hellotriangle/triangle.vert"
+    , 0};
+const char HELLO_FS[] = {
+#embed "../02_hellotriangle/triangle.frag"
+    , 0};
+const char TEXTURE_VS[] = {
+#embed "../03_texture/texture.vert"
+    , 0};
+const char TEXTURE_FS[] = {
+#embed "../03_texture/texture.frag"
+    , 0};
+const char CUBE_VS[] = {
+#embed "../05_cube/15-draw_cube.vert"
+    , 0};
+const char CUBE_FS[] = {
+#embed "../05_cube/15-draw_cube.frag"
+    , 0};
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+struct Result {
+  double shaderMs = 0;
+  double pipelineMs = 0;
+  uint32_t shaderHits = 0;
+  bool pipelineCacheLoaded = false;
+};
+
+static Result run(const vuloxr::vk::PhysicalDevice &physicalDevice,
+                  const vuloxr::vk::Device &device, VkFormat format,
+                  const std::filesystem::path &cacheDir) {
+  Result result;
+  auto &shaderCache = vuloxr::vk::ShaderCache::get();
+  shaderCache.hits = 0;
+
+  auto start = Clock::now();
+  auto triangleVs = vuloxr::vk::glsl_vs_to_spv(TRIANGLE_VS);
+  auto triangleFs = vuloxr::vk::glsl_fs_to_spv(TRIANGLE_FS);
+  vuloxr::vk::glsl_vs_to_spv(HELLO_VS);
+  vuloxr::vk::glsl_fs_to_spv(HELLO_FS);
+  vuloxr::vk::glsl_vs_to_spv(TEXTURE_VS);
+  vuloxr::vk::glsl_fs_to_spv(TEXTURE_FS);
+  vuloxr::vk::glsl_vs_to_spv(CUBE_VS);
+  vuloxr::vk::glsl_fs_to_spv(CUBE_FS);
+  result.shaderMs = elapsedMs(start);
+  result.shaderHits = shaderCache.hits;
+
+  auto vs = vuloxr::vk::ShaderModule::createVertexShader(device, triangleVs,
+                                                         "main");
+  auto fs = vuloxr::vk::ShaderModule::createFragmentShader(device, triangleFs,
+                                                           "main");
+  auto pipelineLayout = vuloxr::vk::createEmptyPipelineLayout(device);
+  auto [renderPass, depthStencil] =
+      vuloxr::vk::createColorRenderPass(device, format);
+
+  start = Clock::now();
+  {
+    vuloxr::vk::PipelineCache pipelineCache(physicalDevice, device,
+                                            cacheDir / "pipeline.bin");
+    result.pipelineCacheLoaded = pipelineCache.loaded;
+
+    // a few variants. a real scene has tens to hundreds
+    std::vector<vuloxr::vk::Pipeline> pipelines;
+    for (auto cull : {VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT}) {
+      for (auto front :
+           {VK_FRONT_FACE_CLOCKWISE, VK_FRONT_FACE_COUNTER_CLOCKWISE}) {
+        vuloxr::vk::PipelineBuilder builder;
+        builder.pipelineCache = pipelineCache;
+        builder.rasterizer.cullMode = cull;
+        builder.rasterizer.frontFace = front;
+        auto pipeline = builder.create(
+            device, renderPass, depthStencil, pipelineLayout,
+            {vs.pipelineShaderStageCreateInfo,
+             fs.pipelineShaderStageCreateInfo},
+            {}, {}, {}, {},
+            {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR});
+        if (!pipelines.empty()) {
+          // the render pass and the layout are owned by the first Pipeline
+          pipeline.renderPass = VK_NULL_HANDLE;
+          pipeline.pipelineLayout = VK_NULL_HANDLE;
+        }
+        pipelines.push_back(std::move(pipeline));
+      }
+    }
+    result.pipelineMs = elapsedMs(start);
+  }
+
+  return result;
+}
+
+int main(int argc, char **argv) {
+  std::filesystem::path cacheDir =
+      argc > 1 ? argv[1] : "vuloxr_startup_bench_cache";
+
+  vuloxr::gui::Glfw glfw;
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfw.createWindow(64, 64, "startup_bench");
+
+  try {
+    auto vulkan = glfw.createVulkan(false);
+    auto format = vulkan.swapchain.createInfo.imageFormat;
+
+    std::error_code ec;
+    std::filesystem::remove_all(cacheDir, ec);
+    vuloxr::vk::ShaderCache::get().directory = cacheDir / "shaders";
+
+    auto cold = run(vulkan.physicalDevice, vulkan.device, format, cacheDir);
+    auto warm = run(vulkan.physicalDevice, vulkan.device, format, cacheDir);
+
+    printf("%-6s %12s %14s %s\n", "", "shader(ms)", "pipeline(ms)",
+           "cache");
+    printf("%-6s %12.2f %14.2f spv hits %u/8, pipeline cache %s\n", "cold",
+           cold.shaderMs, cold.pipelineMs, cold.shaderHits,
+           cold.pipelineCacheLoaded ? "loaded" : "empty");
+    printf("%-6s %12.2f %14.2f spv hits %u/8, pipeline cache %s\n", "warm",
+           warm.shaderMs, warm.pipelineMs, warm.shaderHits,
+           warm.pipelineCacheLoaded ? "loaded" : "empty");
+  } catch (const std::exception &ex) {
+    vuloxr::Logger::Error("%s", ex.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,428 @@
+//
+// headless frame benchmark. no window, no swapchain.
+//
+//   vuloxr_bench [--scene cube|cubes] [--frames N] [--size WxH]
+//                [--device NAME] [--golden FILE.ppm] [--update-golden]
+//                [--tolerance N] [--trace FILE.json] [--threads N]
+//
+// cube:  the 05_cube scene
+// cubes: a grid of cubes with one draw each, the cuber crowd workload
+//
+// --device picks a physical device by name, e.g. "llvmpipe" for lavapipe.
+// --golden compares the last frame with FILE.ppm (written if missing) and
+// exits with 1 if any channel differs by more than --tolerance.
+// --trace writes cpu and gpu zones as chrome trace json.
+// --threads records the draws into secondary command buffers on N threads.
+//
+#include "../05_cube/cube_data.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vuloxr/scene/camera.h>
+#include <vuloxr/vk.h>
+#include <vuloxr/vk/buffer.h>
+#include <vuloxr/vk/command.h>
+#include <vuloxr/vk/offscreen.h>
+#include <vuloxr/vk/parallel.h>
+#include <vuloxr/vk/pipeline.h>
+#include <vuloxr/vk/profiler.h>
+#include <vuloxr/vk/shaderc.h>
+
+const char VS[] = {
+#embed "../05_cube/15-draw_cube.vert"
+    , 0, 0, 0, 0,
+};
+const char FS[] = {
+#embed "../05_cube/15-draw_cube.frag"
+    , 0, 0, 0, 0,
+};
+
+VkClearValue clear_values[2] = {
+    {.color = {0.2f, 0.2f, 0.2f, 0.2f}},
+    {.depthStencil = {.depth = 1.0f, .stencil = 0}},
+};
+
+struct Options {
+  std::string scene = "cube";
+  uint32_t frames = 1000;
+  VkExtent2D extent = {1280, 720};
+  std::string device;
+  std::string golden;
+  bool updateGolden = false;
+  int tolerance = 2;
+  std::string trace;
+  // 1: inline recording on the main thread
+  uint32_t threads = 1;
+
+  bool parse(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto value = [&]() -> const char * {
+        return i + 1 < argc ? argv[++i] : "";
+      };
+      if (arg == "--scene") {
+        this->scene = value();
+      } else if (arg == "--frames") {
+        this->frames = std::max(1, atoi(value()));
+      } else if (arg == "--size") {
+        if (sscanf(value(), "%ux%u", &this->extent.width,
+                   &this->extent.height) != 2) {
+          return false;
+        }
+      } else if (arg == "--device") {
+        this->device = value();
+      } else if (arg == "--golden") {
+        this->golden = value();
+      } else if (arg == "--update-golden") {
+        this->updateGolden = true;
+      } else if (arg == "--tolerance") {
+        this->tolerance = atoi(value());
+      } else if (arg == "--trace") {
+        this->trace = value();
+      } else if (arg == "--threads") {
+        this->threads = std::max(1, atoi(value()));
+      } else {
+        return false;
+      }
+    }
+    return this->scene == "cube" || this->scene == "cubes";
+  }
+};
+
+// deterministic. the same frame number gives the same image
+static DirectX::XMFLOAT4X4 cubeMvp(const DirectX::XMFLOAT4X4 &viewProjection,
+                                   uint64_t frameNumber, float x, float z) {
+  auto angle = static_cast<float>(frameNumber % 360) / 180.0f *
+               std::numbers::pi_v<float>;
+  auto model = DirectX::XMMatrixRotationY(angle) *
+               DirectX::XMMatrixTranslation(x, 0, z);
+  DirectX::XMFLOAT4X4 m;
+  DirectX::XMStoreFloat4x4(
+      &m, model * DirectX::XMLoadFloat4x4(&viewProjection));
+  return m;
+}
+
+static double percentile(std::vector<double> values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  auto index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+  return values[index];
+}
+
+static void printStats(const char *label, const std::vector<double> &ms) {
+  double sum = 0;
+  for (auto v : ms) {
+    sum += v;
+  }
+  printf("%-10s avg %8.3f  p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f (ms)\n",
+         label, ms.empty() ? 0 : sum / ms.size(), percentile(ms, 0.5),
+         percentile(ms, 0.9), percentile(ms, 0.99), percentile(ms, 1.0));
+}
+
+// P6 rgb. alpha dropped
+static bool writePpm(const std::string &path, VkExtent2D extent,
+                     std::span<const uint8_t> rgba) {
+  std::ofstream os(path, std::ios::binary);
+  if (!os) {
+    return false;
+  }
+  os << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+  for (size_t i = 0; i < rgba.size(); i += 4) {
+    os.write((const char *)&rgba[i], 3);
+  }
+  return true;
+}
+
+static bool readPpm(const std::string &path, VkExtent2D extent,
+                    std::vector<uint8_t> &rgb) {
+  std::ifstream is(path, std::ios::binary);
+  std::string magic;
+  uint32_t w, h, maxValue;
+  if (!(is >> magic >> w >> h >> maxValue) || magic != "P6" ||
+      w != extent.width || h != extent.height || maxValue != 255) {
+    return false;
+  }
+  is.get();
+  rgb.resize(w * h * 3);
+  return static_cast<bool>(is.read((char *)rgb.data(), rgb.size()));
+}
+
+// 0: match, 1: mismatch
+static int compareGolden(const Options &options,
+                         std::span<const uint8_t> rgba) {
+  std::vector<uint8_t> golden;
+  if (options.updateGolden || !readPpm(options.golden, options.extent, golden)) {
+    if (!writePpm(options.golden, options.extent, rgba)) {
+      vuloxr::Logger::Error("fail to write %s", options.golden.c_str());
+      return 1;
+    }
+    printf("golden     written %s\n", options.golden.c_str());
+    return 0;
+  }
+
+  uint32_t mismatch = 0;
+  int maxDiff = 0;
+  for (size_t i = 0, j = 0; i < rgba.size(); i += 4, j += 3) {
+    bool bad = false;
+    for (int c = 0; c < 3; ++c) {
+      auto diff = abs((int)rgba[i + c] - (int)golden[j + c]);
+      maxDiff = std::max(maxDiff, diff);
+      bad = bad || diff > options.tolerance;
+    }
+    if (bad) {
+      ++mismatch;
+    }
+  }
+  printf("golden     %s: %u pixels differ (max diff %d, tolerance %d)\n",
+         mismatch ? "FAIL" : "ok", mismatch, maxDiff, options.tolerance);
+  if (mismatch) {
+    auto actual = options.golden + ".actual.ppm";
+    writePpm(actual, options.extent, rgba);
+    printf("golden     actual image %s\n", actual.c_str());
+  }
+  return mismatch ? 1 : 0;
+}
+
+static int bench(const Options &options) {
+  vuloxr::vk::Instance instance;
+  vuloxr::vk::CheckVkResult(instance.create());
+
+  auto physicalDevice =
+      instance.pickHeadlessPhysicalDevice(options.device.c_str());
+  if (!physicalDevice) {
+    vuloxr::Logger::Error("no physical device for '%s'",
+                          options.device.c_str());
+    return 1;
+  }
+
+  vuloxr::vk::Device device;
+  device.layers = instance.layers;
+  vuloxr::vk::CheckVkResult(device.create(
+      instance, *physicalDevice, physicalDevice->graphicsFamilyIndex));
+
+  // cube: 1, cubes: 32 x 32
+  const uint32_t GRID = options.scene == "cubes" ? 32 : 1;
+  const uint32_t CUBE_COUNT = GRID * GRID;
+  const uint32_t FRAMES_IN_FLIGHT = 2;
+
+  vuloxr::vk::UniformRing<DirectX::XMFLOAT4X4> ubo(
+      *physicalDevice, device, FRAMES_IN_FLIGHT * CUBE_COUNT);
+  vuloxr::vk::DescriptorSet descriptor(
+      device, 1,
+      {
+          {
+              .binding = 0,
+              .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+              .descriptorCount = 1,
+              .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+              .pImmutableSamplers = NULL,
+          },
+      });
+  descriptor.update(0, std::span<const vuloxr::vk::DescriptorUpdateInfo>({
+                           vuloxr::vk::DescriptorUpdateInfo{
+                               .type =
+                                   VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                               .pBufferInfo = &ubo.info,
+                           },
+                       }));
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &descriptor.descriptorSetLayout,
+  };
+  VkPipelineLayout pipelineLayout;
+  vuloxr::vk::CheckVkResult(vkCreatePipelineLayout(
+      device, &pipelineLayoutCreateInfo, NULL, &pipelineLayout));
+
+  // 8bit rgba for the readback. supported by every desktop and lavapipe
+  auto format = VK_FORMAT_R8G8B8A8_UNORM;
+  auto depthFormat = physicalDevice->depthFormat();
+  auto [renderPass, depthStencil] = vuloxr::vk::createColorDepthRenderPass(
+      device, format, depthFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+  auto vs = vuloxr::vk::ShaderModule::createVertexShader(
+      device, vuloxr::vk::glsl_vs_to_spv(VS), "main");
+  auto fs = vuloxr::vk::ShaderModule::createFragmentShader(
+      device, vuloxr::vk::glsl_fs_to_spv(FS), "main");
+
+  vuloxr::vk::VertexBuffer vertexBuffer{
+      .bindings =
+          {
+              {
+                  .binding = 0,
+                  .stride = sizeof(Vertex),
+                  .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+              },
+          },
+      .attributes = {
+          {
+              .location = 0,
+              .binding = 0,
+              .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+              .offset = 0,
+          },
+          {
+              .location = 1,
+              .binding = 0,
+              .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+              .offset = 16,
+          },
+      }};
+  vertexBuffer.allocate(*physicalDevice, device,
+                        std::span<const Vertex>(g_vb_solid_face_colors_Data));
+
+  auto pipeline = vuloxr::vk::PipelineBuilder().create(
+      device, renderPass, depthStencil, pipelineLayout,
+      {vs.pipelineShaderStageCreateInfo, fs.pipelineShaderStageCreateInfo},
+      vertexBuffer.bindings, vertexBuffer.attributes, {}, {},
+      {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR});
+
+  vuloxr::vk::OffscreenTarget target(device, format, depthFormat,
+                                     VK_SAMPLE_COUNT_1_BIT);
+  target.reset(*physicalDevice, renderPass, options.extent, FRAMES_IN_FLIGHT);
+
+  vuloxr::vk::FrameContextRing frames(*physicalDevice, device,
+                                      physicalDevice->graphicsFamilyIndex,
+                                      FRAMES_IN_FLIGHT);
+  // a statistics query active around vkCmdExecuteCommands needs the
+  // inheritedQueries feature. counted only for the inline recording
+  vuloxr::vk::GpuProfiler profiler(*physicalDevice, device,
+                                   physicalDevice->graphicsFamilyIndex,
+                                   FRAMES_IN_FLIGHT, 16, options.threads == 1);
+  profiler.capture = !options.trace.empty();
+
+  std::unique_ptr<vuloxr::vk::ParallelRecorder> recorder;
+  if (options.threads > 1) {
+    recorder = std::make_unique<vuloxr::vk::ParallelRecorder>(
+        device, physicalDevice->graphicsFamilyIndex, FRAMES_IN_FLIGHT,
+        options.threads);
+  }
+
+  vuloxr::camera::PerspectiveProjection projection;
+  projection.setViewSize(options.extent.width, options.extent.height);
+  projection.calc();
+  DirectX::XMFLOAT4X4 view;
+  DirectX::XMStoreFloat4x4(
+      &view, DirectX::XMMatrixTranslation(0, GRID * -0.5f, GRID * -3.0f - 7));
+  auto viewProjection =
+      vuloxr::camera::vulkanViewProjectionClip(view, projection.matrix);
+
+  std::vector<double> frameMs;
+  std::vector<double> cpuWaitMs;
+  std::vector<double> gpuMs;
+  frameMs.reserve(options.frames);
+  auto last = std::chrono::steady_clock::now();
+  std::vector<uint32_t> offsets(CUBE_COUNT);
+  for (uint32_t i = 0; i < options.frames; ++i) {
+    auto &frame = frames.next();
+    auto now = std::chrono::steady_clock::now();
+    if (i > 0) {
+      frameMs.push_back(
+          std::chrono::duration<double, std::milli>(now - last).count());
+      cpuWaitMs.push_back(frame.cpuWait.count() / 1e6);
+      if (frame.gpuBusy.count() > 0) {
+        gpuMs.push_back(frame.gpuBusy.count() / 1e6);
+      }
+    }
+    last = now;
+
+    vuloxr::vk::CpuZone cpuZone(profiler, "record");
+    for (uint32_t z = 0; z < GRID; ++z) {
+      for (uint32_t x = 0; x < GRID; ++x) {
+        auto cube = z * GRID + x;
+        offsets[cube] = ubo.write(
+            frame.index * CUBE_COUNT + cube,
+            cubeMvp(viewProjection, i, (x - (GRID - 1) * 0.5f) * 3.0f,
+                    (z - (GRID - 1) * 0.5f) * -3.0f));
+      }
+    }
+
+    // [begin, end) of the cubes. called on the recorder threads
+    auto drawCubes = [&](VkCommandBuffer cmd, uint32_t begin, uint32_t end) {
+      for (auto cube = begin; cube < end; ++cube) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipelineLayout, 0, 1,
+                                &descriptor.descriptorSets[0], 1,
+                                &offsets[cube]);
+        vertexBuffer.draw(cmd, pipeline);
+      }
+    };
+
+    if (recorder) {
+      recorder->beginFrame(frame.index);
+    }
+    frames.begin(frame);
+    profiler.beginFrame(frame.commandBuffer, frame.index, frame.frameNumber);
+    {
+      vuloxr::vk::GpuZone zone(profiler, frame.commandBuffer, "scene");
+      if (recorder) {
+        recorder->recordRenderPass(
+            frame.commandBuffer, renderPass, target[frame.index].framebuffer,
+            options.extent, clear_values, CUBE_COUNT, drawCubes);
+      } else {
+        vuloxr::vk::RenderPassScope pass(
+            frame.commandBuffer, pipelineLayout, renderPass,
+            target[frame.index].framebuffer, options.extent, clear_values);
+        drawCubes(frame.commandBuffer, 0, CUBE_COUNT);
+      }
+    }
+    if (i + 1 == options.frames) {
+      vuloxr::vk::GpuZone zone(profiler, frame.commandBuffer, "readback");
+      target.copyToReadback(frame.commandBuffer, frame.index);
+    }
+    vuloxr::vk::CheckVkResult(frames.submit(frame, 0));
+  }
+  vkDeviceWaitIdle(device);
+  profiler.flush();
+
+  printf("device     %s\n", physicalDevice->properties.deviceName);
+  printf("scene      %s, %u draws, %ux%u, %u frames, %u threads\n",
+         options.scene.c_str(), CUBE_COUNT, options.extent.width,
+         options.extent.height, options.frames, options.threads);
+  printStats("frame", frameMs);
+  printStats("cpu wait", cpuWaitMs);
+  printStats("gpu", gpuMs);
+  for (auto &[name, zone] : profiler.stats) {
+    printf("zone       %-10s %8.3f ms (last %zu frames)", name.c_str(),
+           zone.averageMs(), zone.samples.size());
+    if (profiler.statisticsPool != VK_NULL_HANDLE) {
+      printf(", %llu primitives, %llu fragments",
+             (unsigned long long)zone.statistics[0],
+             (unsigned long long)zone.statistics[3]);
+    }
+    printf("\n");
+  }
+  if (!options.trace.empty() && profiler.exportChromeTrace(options.trace)) {
+    printf("trace      %s\n", options.trace.c_str());
+  }
+
+  if (options.golden.empty()) {
+    return 0;
+  }
+  return compareGolden(options, target.readbackPixels());
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!options.parse(argc, argv)) {
+    printf("usage: %s [--scene cube|cubes] [--frames N] [--size WxH] "
+           "[--device NAME] [--golden FILE.ppm] [--update-golden] "
+           "[--tolerance N] [--trace FILE.json] [--threads N]\n",
+           argv[0]);
+    return 2;
+  }
+
+  try {
+    return bench(options);
+  } catch (const std::exception &ex) {
+    vuloxr::Logger::Error("%s", ex.what());
+    return 1;
+  }
+}
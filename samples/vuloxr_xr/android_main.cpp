@@ -54,6 +54,9 @@ void android_main(struct android_app *app) {
 #endif
 
   auto instanceCreateInfoAndroid = vuloxr::xr::androidLoader(app);
+  // positional reprojection with the depth buffer
+  auto depthLayer = xr_instance.enableIfSupported(
+      XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
   vuloxr::xr::CheckXrResult(xr_instance.create(&instanceCreateInfoAndroid));
 
   {
@@ -108,7 +111,7 @@ void android_main(struct android_app *app) {
       xr_main_loop(runLoop, xr_instance.instance, xr_instance.systemId, session,
                    appSpace, session.formats,
                    //
-                   graphics, clearColor);
+                   graphics, clearColor, depthLayer);
       // session scope
     }
     // vulkan scope
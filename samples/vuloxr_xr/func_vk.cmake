@@ -22,6 +22,8 @@ if(ANDROID)
     target_link_libraries(
       ${TARGET_NAME}
       PRIVATE ${XR_SAMPLE_COMMON_LIBS}
+              # func_gl.cmake reassigns XR_SAMPLE_COMMON_LIBS
+              cuber_vk
               # android
               vulkan
               android
@@ -46,6 +48,8 @@ else()
     target_link_libraries(
       ${TARGET_NAME}
       PRIVATE ${XR_SAMPLE_COMMON_LIBS}
+              # func_gl.cmake reassigns XR_SAMPLE_COMMON_LIBS
+              cuber_vk
               # windows
               Vulkan::Vulkan glfw)
     target_compile_definitions(
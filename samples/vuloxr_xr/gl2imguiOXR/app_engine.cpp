@@ -1,6 +1,7 @@
 // #include "util_egl.h"
 // #include "util_oxr.h"
 #include "app_engine.h"
+#include "../xr_linear.h"
 #include "render_scene.h"
 
 static XrSpace oxr_create_ref_space(XrSession session,
@@ -79,11 +80,9 @@ void AppEngine::RenderLayer(XrTime dpy_time, XrTime elapsed_us, uint32_t i,
 
   // layerViews.resize(viewCount);
 
-  /* Acquire Stage Location, View Location (rerative to the View Location) */
+  /* Acquire Stage Location */
   XrSpaceLocation stageLoc{XR_TYPE_SPACE_LOCATION};
-  XrSpaceLocation viewLoc{XR_TYPE_SPACE_LOCATION};
   xrLocateSpace(m_stageSpace, m_appSpace, dpy_time, &stageLoc);
-  xrLocateSpace(m_viewSpace, m_appSpace, dpy_time, &viewLoc);
 
   /* Render each view */
   // for (uint32_t i = 0; i < viewCount; i++)
@@ -104,8 +103,7 @@ void AppEngine::RenderLayer(XrTime dpy_time, XrTime elapsed_us, uint32_t i,
     sceneData.elapsed_us = elapsed_us;
     sceneData.viewID = i;
     sceneData.view = &view;
-    render_gles_scene(layerView, fbo_id, viewLoc.pose, stageLoc.pose,
-                      sceneData);
+    render_gles_scene(layerView, fbo_id, stageLoc.pose, sceneData);
 
     // oxr_release_viewsurface(m_viewSurface[i]);
   }
@@ -116,3 +114,32 @@ void AppEngine::RenderLayer(XrTime dpy_time, XrTime elapsed_us, uint32_t i,
   //
   // return true;
 }
+
+uint64_t AppEngine::UpdateUI(XrTime elapsed_us, const XrView &view,
+                             const XrRect2Di &viewport) {
+  scene_data_t sceneData;
+  sceneData.runtime_name = m_runtime_name;
+  sceneData.system_name = m_system_name;
+  sceneData.elapsed_us = elapsed_us;
+  sceneData.viewID = 0;
+  sceneData.view = &view;
+  return update_gles_ui(viewport, sceneData);
+}
+
+void AppEngine::RenderUI(uint32_t fbo_id) { render_gles_ui(fbo_id); }
+
+XrPosef AppEngine::UIPose(XrTime dpy_time) {
+  XrSpaceLocation viewLoc{XR_TYPE_SPACE_LOCATION};
+  xrLocateSpace(m_viewSpace, m_appSpace, dpy_time, &viewLoc);
+
+  /* 2m ahead, 1m right. turned 30 degrees to the head */
+  XrPosef local;
+  const XrVector3f up = {0.0f, 1.0f, 0.0f};
+  XrQuaternionf_CreateFromAxisAngle(&local.orientation, &up,
+                                    -30.0f * 3.14159265f / 180.0f);
+  local.position = {1.0f, 0.0f, -2.0f};
+
+  XrPosef pose;
+  XrPosef_Multiply(&pose, &viewLoc.pose, &local);
+  return pose;
+}
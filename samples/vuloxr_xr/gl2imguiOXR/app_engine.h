@@ -23,4 +23,12 @@ public:
                    const XrCompositionLayerProjectionView &layerView,
                    const XrView &view,
                    uint32_t fbo_id);
+
+  // the imgui panel. once per frame. returns the hash of the draw data
+  uint64_t UpdateUI(XrTime elapsed_us, const XrView &view,
+                    const XrRect2Di &viewport);
+  // UI_WIN_W x UI_WIN_H
+  void RenderUI(uint32_t fbo_id);
+  // in front of the head. in appSpace
+  XrPosef UIPose(XrTime dpy_time);
 };
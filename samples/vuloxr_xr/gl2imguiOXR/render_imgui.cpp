@@ -152,8 +152,46 @@ render_gui (scene_data_t *scn_data)
     ImGui::End();
 }
 
-int
-invoke_imgui (scene_data_t *scn_data)
+/* FNV-1a */
+static uint64_t
+hash_bytes (uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i ++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint64_t
+hash_drawdata (const ImDrawData *draw_data)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hash_bytes (hash, &draw_data->DisplaySize, sizeof(ImVec2));
+    for (int n = 0; n < draw_data->CmdListsCount; n ++)
+    {
+        const ImDrawList *cmd_list = draw_data->CmdLists[n];
+        hash = hash_bytes (hash, cmd_list->VtxBuffer.Data,
+                           cmd_list->VtxBuffer.size_in_bytes());
+        hash = hash_bytes (hash, cmd_list->IdxBuffer.Data,
+                           cmd_list->IdxBuffer.size_in_bytes());
+        for (int i = 0; i < cmd_list->CmdBuffer.Size; i ++)
+        {
+            const ImDrawCmd *cmd = &cmd_list->CmdBuffer[i];
+            hash = hash_bytes (hash, &cmd->ClipRect,  sizeof(cmd->ClipRect));
+            hash = hash_bytes (hash, &cmd->TextureId, sizeof(cmd->TextureId));
+            hash = hash_bytes (hash, &cmd->VtxOffset, sizeof(cmd->VtxOffset));
+            hash = hash_bytes (hash, &cmd->IdxOffset, sizeof(cmd->IdxOffset));
+            hash = hash_bytes (hash, &cmd->ElemCount, sizeof(cmd->ElemCount));
+        }
+    }
+    return hash;
+}
+
+uint64_t
+update_imgui (scene_data_t *scn_data)
 {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui::NewFrame();
@@ -161,6 +199,13 @@ invoke_imgui (scene_data_t *scn_data)
     render_gui (scn_data);
 
     ImGui::Render();
+
+    return hash_drawdata (ImGui::GetDrawData());
+}
+
+int
+draw_imgui ()
+{
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
     return 0;
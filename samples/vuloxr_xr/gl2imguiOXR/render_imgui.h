@@ -16,7 +16,9 @@ int  init_imgui (int width, int height);
 void imgui_mousebutton (int button, int state, int x, int y);
 void imgui_mousemove (int x, int y);
 
-int invoke_imgui (scene_data_t *scn_data);
+/* builds the draw data. returns its hash. same hash, same image */
+uint64_t update_imgui (scene_data_t *scn_data);
+int      draw_imgui ();
 
 #endif /* UTIL_IMGUI_H_ */
  
@@ -6,17 +6,11 @@
 #include "assertgl.h"
 #include "render_imgui.h"
 #include "render_scene.h"
-#include "render_texplate.h"
 #include "util_debugstr.h"
 #include "util_matrix.h"
-#include "util_render_target.h"
 #include "util_shader.h"
 
 static shader_obj_t s_sobj;
-static render_target_t s_rtarget;
-
-#define UI_WIN_W 300
-#define UI_WIN_H 350
 
 static char s_strVS[] = "                                   \n\
                                                             \n\
@@ -43,12 +37,9 @@ void main(void)                                             \n\
 int init_gles_scene() {
   generate_shader(&s_sobj, s_strVS, s_strFS);
   init_teapot();
-  init_texplate();
   init_dbgstr(0, 0);
   init_imgui(UI_WIN_W, UI_WIN_H);
 
-  create_render_target(&s_rtarget, UI_WIN_W, UI_WIN_H, RTARGET_COLOR);
-
   return 0;
 }
 
@@ -130,58 +121,36 @@ static int draw_stage(float *matStage) {
   return 0;
 }
 
-static int draw_uiplane(float *matPVMbase,
-                        const XrCompositionLayerProjectionView &layerView,
-                        scene_data_t &sceneData) {
-  /* save current FBO */
-  render_target_t rtarget0;
-  get_render_target(&rtarget0);
-
-  /* render to UIPlane-FBO */
-  set_render_target(&s_rtarget);
-  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-  glClear(GL_COLOR_BUFFER_BIT);
+uint64_t update_gles_ui(const XrRect2Di &viewport, scene_data_t &sceneData) {
+  static uint32_t prev_us = 0;
+  sceneData.interval_ms = (sceneData.elapsed_us - prev_us) / 1000.0f;
+  prev_us = sceneData.elapsed_us;
 
-  {
-    static uint32_t prev_us = 0;
-    if (sceneData.viewID == 0) {
-      sceneData.interval_ms = (sceneData.elapsed_us - prev_us) / 1000.0f;
-      prev_us = sceneData.elapsed_us;
-    }
-
-    sceneData.gl_version = glGetString(GL_VERSION);
-    sceneData.gl_vendor = glGetString(GL_VENDOR);
-    sceneData.gl_render = glGetString(GL_RENDERER);
-    sceneData.viewport = layerView.subImage.imageRect;
-    invoke_imgui(&sceneData);
-  }
+  sceneData.gl_version = glGetString(GL_VERSION);
+  sceneData.gl_vendor = glGetString(GL_VENDOR);
+  sceneData.gl_render = glGetString(GL_RENDERER);
+  sceneData.viewport = viewport;
+  return update_imgui(&sceneData);
+}
 
-  /* restore FBO */
-  set_render_target(&rtarget0);
+int render_gles_ui(uint32_t fbo_id) {
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_id);
+  glViewport(0, 0, UI_WIN_W, UI_WIN_H);
 
-  glEnable(GL_DEPTH_TEST);
+  /* transparent outside the windows */
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  draw_imgui();
 
-  {
-    float matPVM[16], matT[16];
-    float win_x = 1.0f;
-    float win_y = 0.0f;
-    float win_z = -2.0f;
-    float win_w = 1.0f;
-    float win_h = win_w * ((float)UI_WIN_H / (float)UI_WIN_W);
-    matrix_identity(matT);
-    matrix_translate(matT, win_x, win_y, win_z);
-    matrix_rotate(matT, -30.0f, 0.0f, 1.0f, 0.0f);
-    matrix_scale(matT, win_w, win_h, 1.0f);
-    matrix_mult(matPVM, matPVMbase, matT);
-    draw_tex_plate(s_rtarget.texc_id, matPVM, RENDER2D_FLIP_V);
-  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  GLASSERT();
 
   return 0;
 }
 
 int render_gles_scene(const XrCompositionLayerProjectionView &layerView,
-                      uint32_t fbo_id, const XrPosef &viewPose,
-                      const XrPosef &stagePose, scene_data_t &sceneData) {
+                      uint32_t fbo_id, const XrPosef &stagePose,
+                      scene_data_t &sceneData) {
   int view_x = layerView.subImage.imageRect.offset.x;
   int view_y = layerView.subImage.imageRect.offset.y;
   int view_w = layerView.subImage.imageRect.extent.width;
@@ -231,18 +200,7 @@ int render_gles_scene(const XrCompositionLayerProjectionView &layerView,
   float col[] = {1.0f, 0.0f, 0.0f};
   draw_teapot(sceneData.elapsed_us / 1000, col, (float *)&matP, (float *)&matV);
 
-  /* UI plane always view front */
-  {
-    const XrVector3f scale = {1.0f, 1.0f, 1.0f};
-    const XrVector3f &pos = viewPose.position;
-    const XrQuaternionf &qtn = viewPose.orientation;
-    XrMatrix4x4f_CreateTranslationRotationScale(&matM, &pos, &qtn, &scale);
-
-    XrMatrix4x4f matPVM;
-    XrMatrix4x4f_Multiply(&matPVM, &matPV, &matM);
-
-    draw_uiplane((float *)&matPVM, layerView, sceneData);
-  }
+  /* the UI plane is a quad layer. see render_gles_ui */
 
   {
     const XrVector3f &pos = layerView.pose.position;
@@ -17,7 +17,16 @@ typedef struct scene_data_t {
   uint32_t viewID;
 } scene_data_t;
 
+/* pixels of the UI plane */
+#define UI_WIN_W 300
+#define UI_WIN_H 350
+
 int init_gles_scene();
 int render_gles_scene(const XrCompositionLayerProjectionView &layerView,
-                      uint32_t fbo_id, const XrPosef &viewPose,
-                      const XrPosef &stagePose, scene_data_t &sceneData);
+                      uint32_t fbo_id, const XrPosef &stagePose,
+                      scene_data_t &sceneData);
+
+/* runs imgui. returns the hash of the draw data */
+uint64_t update_gles_ui(const XrRect2Di &viewport, scene_data_t &sceneData);
+/* draws the last update_gles_ui into a UI_WIN_W x UI_WIN_H image */
+int render_gles_ui(uint32_t fbo_id);
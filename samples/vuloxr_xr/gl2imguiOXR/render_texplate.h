@@ -1,9 +0,0 @@
-#ifndef RENDER_TEXPLATE_H_
-#define RENDER_TEXPLATE_H_
-
-#include "util_render2d.h"
-
-int init_texplate ();
-int draw_tex_plate (int texid, float *matPVM, int upsidedown);
-
-#endif
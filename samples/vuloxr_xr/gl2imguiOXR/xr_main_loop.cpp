@@ -1,5 +1,6 @@
 #include "../xr_main_loop.h"
 #include "app_engine.h"
+#include "render_scene.h"
 #include <vuloxr/xr/session.h>
 
 #include <thread>
@@ -24,7 +25,8 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
                   //
                   const Graphics &graphics,
                   //
-                  const XrColor4f &clearColor, XrEnvironmentBlendMode blendMode,
+                  const XrColor4f &clearColor, bool depthLayer,
+                  XrEnvironmentBlendMode blendMode,
                   XrViewConfigurationType viewConfigurationType) {
 
   vuloxr::xr::Stereoscope stereoscope(instance, systemId,
@@ -42,6 +44,17 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
 
   AppEngine engine(instance, systemId, session, appSpace);
 
+  // the imgui windows. 1m wide
+  vuloxr::xr::QuadPanel<SwapchainImageType> panel(
+      session, UI_WIN_W, UI_WIN_H, format, SwapchainImage,
+      {1.0f, 1.0f * UI_WIN_H / UI_WIN_W});
+  std::vector<std::shared_ptr<vuloxr::gl::FramebufferObject>> panelFbos;
+  for (auto &image : panel.swapchain.swapchainImages) {
+    auto fbo = std::make_shared<vuloxr::gl::FramebufferObject>();
+    fbo->attach(image.image, 0);
+    panelFbos.push_back(fbo);
+  }
+
   vuloxr::xr::SessionState state(instance, session, viewConfigurationType);
   while (runLoop(state.m_sessionRunning)) {
 
@@ -68,6 +81,16 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
           init_time = frameState.predictedDisplayTime;
         auto elapsed_us = (frameState.predictedDisplayTime - init_time) / 1000;
 
+        // raster only when the draw data changed. the compositor keeps the
+        // last image
+        auto hash = engine.UpdateUI(
+            elapsed_us, stereoscope.views[0],
+            {{0, 0}, swapchains[0]->renderExtent});
+        panel.update(hash, [&panelFbos, &engine](uint32_t index, auto &) {
+          engine.RenderUI(panelFbos[index]->id);
+        });
+        panel.pose = engine.UIPose(frameState.predictedDisplayTime);
+
         for (uint32_t i = 0; i < stereoscope.views.size(); ++i) {
           // XrCompositionLayerProjectionView(left / right)
           auto swapchain = swapchains[i];
@@ -82,6 +105,7 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
 
           swapchain->EndSwapchain();
         }
+        composition.pushQuad(panel.layer(appSpace));
       }
     }
 
@@ -24,7 +24,8 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
                   //
                   const Graphics &graphics,
                   //
-                  const XrColor4f &clearColor, XrEnvironmentBlendMode blendMode,
+                  const XrColor4f &clearColor, bool depthLayer,
+                  XrEnvironmentBlendMode blendMode,
                   XrViewConfigurationType viewConfigurationType) {
 
   vuloxr::xr::Stereoscope stereoscope(instance, systemId,
@@ -5,6 +5,9 @@
 struct ShaderProgram {};
 
 struct Impl {
+  std::shared_ptr<GraphicsSwapchain> swapchain;
+  // XR_KHR_composition_layer_depth. null for a depth renderbuffer per image
+  std::shared_ptr<GraphicsSwapchain> depthSwapchain;
   uint32_t swapchainWidth;
   uint32_t swapchainHeight;
   std::vector<std::shared_ptr<vuloxr::gl::RenderTarget>> backbuffers;
@@ -16,7 +19,10 @@ struct Impl {
   std::shared_ptr<vuloxr::gl::Ubo> ubo;
   struct RenderTarget {};
 
-  Impl(const Graphics *g) {}
+  Impl(const Graphics *g,
+       const std::shared_ptr<GraphicsSwapchain> &_swapchain,
+       const std::shared_ptr<GraphicsSwapchain> &_depthSwapchain)
+      : swapchain(_swapchain), depthSwapchain(_depthSwapchain) {}
 
   ~Impl() {}
 
@@ -50,16 +56,31 @@ struct Impl {
     this->swapchainHeight = height;
 
     for (auto &image : images) {
-      this->backbuffers.push_back(std::make_shared<vuloxr::gl::RenderTarget>(
-          image.image, width, height));
+      if (this->depthSwapchain) {
+        this->backbuffers.push_back(
+            std::make_shared<vuloxr::gl::RenderTarget>(
+                image.image, this->depthSwapchain->swapchainImages[0].image,
+                width, height));
+      } else {
+        this->backbuffers.push_back(
+            std::make_shared<vuloxr::gl::RenderTarget>(image.image, width,
+                                                       height));
+      }
     }
   }
 
   void render(uint32_t index, const XrColor4f &clearColor,
-              std::span<const DirectX::XMFLOAT4X4> matrices) {
+              const DirectX::XMFLOAT4X4 &viewProjection,
+              std::span<const DirectX::XMFLOAT4X4> models) {
     auto &backbuffer = this->backbuffers[index];
-    backbuffer->beginFrame(this->swapchainWidth, this->swapchainHeight,
-                           clearColor);
+    if (this->depthSwapchain) {
+      auto [depthIndex, depthImage] = this->depthSwapchain->AcquireImage();
+      backbuffer->attachDepth(depthImage.image);
+    }
+    // the bottom left part with dynamic resolution. the imageRect origin of
+    // a GL swapchain is the lower left
+    backbuffer->beginFrame(this->swapchain->renderExtent.width,
+                           this->swapchain->renderExtent.height, clearColor);
 
     this->shader.bind();
     {
@@ -68,8 +89,13 @@ struct Impl {
       this->ubo->Bind();
       this->ubo->SetBindingPoint(0);
 
-      for (auto matrix : matrices) {
-        this->ubo->Upload(matrix);
+      auto vp = DirectX::XMLoadFloat4x4(&viewProjection);
+      for (auto &model : models) {
+        DirectX::XMFLOAT4X4 mvp;
+        DirectX::XMStoreFloat4x4(
+            &mvp,
+            DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&model), vp));
+        this->ubo->Upload(mvp);
 
         this->ibo.draw();
       }
@@ -79,12 +105,16 @@ struct Impl {
     this->shader.unbind();
 
     backbuffer->endFrame();
+    if (this->depthSwapchain) {
+      this->depthSwapchain->EndSwapchain();
+    }
   }
 };
 
-ViewRenderer::ViewRenderer(const Graphics *g,
-                           const std::shared_ptr<GraphicsSwapchain> &swapchain)
-    : _impl(new Impl(g)) {}
+ViewRenderer::ViewRenderer(
+    const Graphics *g, const std::shared_ptr<GraphicsSwapchain> &swapchain,
+    const std::shared_ptr<GraphicsSwapchain> &depthSwapchain)
+    : _impl(new Impl(g, swapchain, depthSwapchain)) {}
 
 ViewRenderer::~ViewRenderer() { delete this->_impl; }
 
@@ -99,6 +129,10 @@ void ViewRenderer::initSwapchain(int width, int height,
   this->_impl->initSwapchain(width, height, images);
 }
 void ViewRenderer::render(uint32_t index, const XrColor4f &clearColor,
-                          std::span<const DirectX::XMFLOAT4X4> matrices) {
-  this->_impl->render(index, clearColor, matrices);
+                          const DirectX::XMFLOAT4X4 &viewProjection,
+                          std::span<const DirectX::XMFLOAT4X4> models) {
+  this->_impl->render(index, clearColor, viewProjection, models);
 }
+// no timer queries. the resolution stays at the recommended size
+double ViewRenderer::gpuMs() const { return 0; }
+bool ViewRenderer::measuresGpuTime() { return false; }
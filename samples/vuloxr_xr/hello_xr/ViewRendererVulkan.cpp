@@ -1,20 +1,24 @@
 #include "../xr_main_loop.h"
+#include <cuber/vk/VkCubeRenderer.h>
 #include <vuloxr/vk/pipeline.h>
-#include <vuloxr/vk/shaderc.h>
+#include <vuloxr/vk/profiler.h>
 
 auto DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
 
 struct Impl {
   const Graphics *graphics;
   std::shared_ptr<GraphicsSwapchain> swapchain;
+  // XR_KHR_composition_layer_depth. null for the private depth images
+  std::shared_ptr<GraphicsSwapchain> depthSwapchain;
+  VkFormat depthFormat;
 
   VkDevice device = VK_NULL_HANDLE;
   VkQueue queue = VK_NULL_HANDLE;
   VkCommandPool commandPool = VK_NULL_HANDLE;
+  VkRenderPass renderPass = VK_NULL_HANDLE;
 
-  vuloxr::vk::VertexBuffer vertices;
-  vuloxr::vk::IndexBuffer indices;
-  vuloxr::vk::Pipeline pipeline;
+  // all cubes in one instanced draw
+  std::shared_ptr<cuber::vk::VkCubeRenderer> cubes;
 
   struct RenderTarget {
     VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
@@ -22,13 +26,24 @@ struct Impl {
   };
   std::vector<std::shared_ptr<RenderTarget>> renderTargets;
   vuloxr::vk::SwapchainIsolatedDepthFramebufferList framebuffers;
-
-  Impl(const Graphics *g, const std::shared_ptr<GraphicsSwapchain> &_swapchain)
-      : graphics(g), swapchain(_swapchain), device(g->device),
+  vuloxr::vk::SwapchainDepthFramebufferList depthFramebuffers;
+  // one slot per swapchain image. the execFence of the image guards the slot
+  std::shared_ptr<vuloxr::vk::GpuProfiler> profiler;
+
+  Impl(const Graphics *g, const std::shared_ptr<GraphicsSwapchain> &_swapchain,
+       const std::shared_ptr<GraphicsSwapchain> &_depthSwapchain)
+      : graphics(g), swapchain(_swapchain), depthSwapchain(_depthSwapchain),
+        depthFormat(_depthSwapchain
+                        ? (VkFormat)_depthSwapchain->swapchainCreateInfo.format
+                        : DEPTH_FORMAT),
+        device(g->device),
         framebuffers(
             g->device, (VkFormat)swapchain->swapchainCreateInfo.format,
             DEPTH_FORMAT,
-            (VkSampleCountFlagBits)swapchain->swapchainCreateInfo.sampleCount) {
+            (VkSampleCountFlagBits)swapchain->swapchainCreateInfo.sampleCount),
+        depthFramebuffers(g->device,
+                          (VkFormat)swapchain->swapchainCreateInfo.format,
+                          this->depthFormat) {
     vkGetDeviceQueue(this->device,
                      this->graphics->physicalDevice.graphicsFamilyIndex, 0,
                      &this->queue);
@@ -43,64 +58,32 @@ struct Impl {
   }
 
   ~Impl() {
+    if (this->commandPool != VK_NULL_HANDLE) {
+      // the cube renderer frees buffers that the command buffers may use
+      vkDeviceWaitIdle(this->device);
+    }
+    this->cubes = nullptr;
+    this->profiler = nullptr;
+    this->framebuffers.release();
+    this->depthFramebuffers.release();
+    if (this->renderPass != VK_NULL_HANDLE) {
+      vkDestroyRenderPass(this->device, this->renderPass, nullptr);
+    }
     if (this->commandPool != VK_NULL_HANDLE) {
       vkDestroyCommandPool(this->device, this->commandPool, nullptr);
     }
   }
 
+  // the cube mesh, shaders and palette come from cuber::vk::VkCubeRenderer.
+  // vs, fs and the vertices are for ViewRendererOpenGL
   void initScene(const char *vertexShaderGlsl, const char *fragmentShaderGlsl,
                  std::span<const VertexAttributeLayout> layouts,
                  const InputData &vertices, const InputData &indices) {
-    this->vertices.bindings = {
-        {
-            .binding = 0,
-            .stride = vertices.stride,
-            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-        },
-    };
-    for (uint32_t i = 0; i < layouts.size(); ++i) {
-      this->vertices.attributes.push_back({
-          .location = i,
-          .binding = 0,
-          .format = vuloxr::vk::getFloatFormat(layouts[i].components),
-          .offset = layouts[i].offset,
-      });
-    }
-    this->vertices.allocate(this->graphics->physicalDevice,
-                            this->graphics->device, vertices.data,
-                            vertices.byteSize(), vertices.drawCount);
-
-    this->indices.allocate(this->graphics->physicalDevice,
-                           this->graphics->device, indices.data,
-                           indices.byteSize(), indices.drawCount);
-
-    // pieline
-    auto pipelineLayout = vuloxr::vk::createPipelineLayoutWithConstantSize(
-        this->graphics->device, sizeof(float) * 16);
     auto [renderPass, depthStencil] = vuloxr::vk::createColorDepthRenderPass(
         this->graphics->device,
-        (VkFormat)this->swapchain->swapchainCreateInfo.format, DEPTH_FORMAT);
-
-    auto vertexSPIRV = vuloxr::vk::glsl_vs_to_spv(vertexShaderGlsl);
-    assert(vertexSPIRV.size());
-    auto vs = vuloxr::vk::ShaderModule::createVertexShader(
-        this->graphics->device, vertexSPIRV, "main");
-
-    auto fragmentSPIRV = vuloxr::vk::glsl_fs_to_spv(fragmentShaderGlsl);
-    assert(fragmentSPIRV.size());
-    auto fs = vuloxr::vk::ShaderModule::createFragmentShader(
-        this->graphics->device, fragmentSPIRV, "main");
-
-    std::vector<VkPipelineShaderStageCreateInfo> stages = {
-        vs.pipelineShaderStageCreateInfo,
-        fs.pipelineShaderStageCreateInfo,
-    };
-
-    vuloxr::vk::PipelineBuilder builder;
-    this->pipeline = builder.create(
-        this->graphics->device, renderPass, depthStencil, pipelineLayout,
-        stages, this->vertices.bindings, this->vertices.attributes, {}, {},
-        {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR});
+        (VkFormat)this->swapchain->swapchainCreateInfo.format,
+        this->depthFormat);
+    this->renderPass = renderPass;
   }
 
   void initSwapchain(int width, int height,
@@ -109,9 +92,31 @@ struct Impl {
     for (auto &image : images) {
       vkImages.push_back(image.image);
     }
-    framebuffers.reset(this->graphics->physicalDevice,
-                       this->pipeline.renderPass,
-                       VkExtent2D{uint32_t(width), uint32_t(height)}, vkImages);
+    VkExtent2D extent{uint32_t(width), uint32_t(height)};
+    if (this->depthSwapchain) {
+      // render into the depth swapchain. no depth image per color image
+      std::vector<VkImage> depthImages;
+      for (auto &image : this->depthSwapchain->swapchainImages) {
+        depthImages.push_back(image.image);
+      }
+      this->depthFramebuffers.reset(this->renderPass, extent, vkImages,
+                                    depthImages);
+    } else {
+      this->framebuffers.reset(this->graphics->physicalDevice,
+                               this->renderPass, extent, vkImages);
+    }
+
+    // one instance slice for each swapchain image. the execFence of the image
+    // guards its slice
+    this->cubes = std::make_shared<cuber::vk::VkCubeRenderer>(
+        this->graphics->physicalDevice, this->device, this->renderPass,
+        static_cast<uint32_t>(images.size()),
+        this->graphics->device.pipelineCache);
+
+    this->profiler = std::make_shared<vuloxr::vk::GpuProfiler>(
+        this->graphics->physicalDevice, this->device,
+        this->graphics->physicalDevice.graphicsFamilyIndex,
+        static_cast<uint32_t>(images.size()), 1);
 
     this->renderTargets.resize(images.size());
     for (int index = 0; index < images.size(); ++index) {
@@ -133,52 +138,63 @@ struct Impl {
   }
 
   void render(uint32_t index, const XrColor4f &clearColor,
-              std::span<const DirectX::XMFLOAT4X4> matrices) {
-    auto framebuffer = &this->framebuffers[index];
+              const DirectX::XMFLOAT4X4 &viewProjection,
+              std::span<const DirectX::XMFLOAT4X4> models) {
     auto rt = this->renderTargets[index];
+    VkFramebuffer framebuffer;
+    if (this->depthSwapchain) {
+      auto [depthIndex, depthImage] = this->depthSwapchain->AcquireImage();
+      framebuffer = this->depthFramebuffers(index, depthIndex);
+    } else {
+      framebuffer = this->framebuffers[index].framebuffer;
+    }
 
     // Waiting on a not-in-flight command buffer is a no-op
     rt->execFence.wait();
     rt->execFence.reset();
 
+    // the slice of this image is free
+    auto instances = this->cubes->BeginInstances(
+        index, static_cast<uint32_t>(models.size()));
+    for (uint32_t i = 0; i < models.size(); ++i) {
+      // default face flags. x+ Red, y+ Green, z+ Blue and dark for x-, y-, z-
+      cuber::Instance instance;
+      instance.Matrix = models[i];
+      instances[i] = instance;
+    }
+
     vuloxr::vk::CheckVkResult(vkResetCommandBuffer(rt->commandBuffer, 0));
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vuloxr::vk::CheckVkResult(
+        vkBeginCommandBuffer(rt->commandBuffer, &beginInfo));
+    // resolves the previous use of this image. the fence is waited
+    this->profiler->beginFrame(rt->commandBuffer, index);
 
     {
+      vuloxr::vk::GpuZone zone(*this->profiler, rt->commandBuffer, "eye");
+
+      // the framebuffer has the swapchain size. render the top left part
       VkExtent2D extent{
-          this->swapchain->swapchainCreateInfo.width,
-          this->swapchain->swapchainCreateInfo.height,
+          static_cast<uint32_t>(this->swapchain->renderExtent.width),
+          static_cast<uint32_t>(this->swapchain->renderExtent.height),
       };
       VkClearValue clearValues[] = {
           {.color = {clearColor.r, clearColor.g, clearColor.b, clearColor.a}},
           {.depthStencil = {.depth = 1.0f, .stencil = 0}},
       };
 
-      vuloxr::vk::RenderPassRecording recording(
-          rt->commandBuffer, this->pipeline.pipelineLayout,
-          this->pipeline.renderPass, framebuffer->framebuffer, extent,
-          clearValues);
-
-      vkCmdBindPipeline(rt->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        pipeline);
-
-      // Bind index and vertex buffers
-      vkCmdBindIndexBuffer(rt->commandBuffer, indices.buffer, 0,
-                           VK_INDEX_TYPE_UINT16);
-      VkDeviceSize offset = 0;
-      vkCmdBindVertexBuffers(rt->commandBuffer, 0, 1, &vertices.buffer.buffer,
-                             &offset);
-
-      // Render each cube
-      for (auto &m : matrices) {
-        vkCmdPushConstants(rt->commandBuffer, this->pipeline.pipelineLayout,
-                           VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(m), &m.m);
-
-        // Draw the cube.
-        vkCmdDrawIndexed(rt->commandBuffer, this->indices.drawCount, 1, 0, 0,
-                         0);
-      }
+      vuloxr::vk::RenderPassScope scope(rt->commandBuffer, VK_NULL_HANDLE,
+                                        this->renderPass, framebuffer, extent,
+                                        clearValues);
+
+      this->cubes->Render(rt->commandBuffer, &viewProjection.m[0][0]);
     }
 
+    vuloxr::vk::CheckVkResult(vkEndCommandBuffer(rt->commandBuffer));
+
     VkSubmitInfo submitInfo{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
         .commandBufferCount = 1,
@@ -186,12 +202,25 @@ struct Impl {
     };
     vuloxr::vk::CheckVkResult(
         vkQueueSubmit(this->queue, 1, &submitInfo, rt->execFence));
+    if (this->depthSwapchain) {
+      // after the submit. the runtime waits the queue
+      this->depthSwapchain->EndSwapchain();
+    }
+  }
+
+  double gpuMs() const {
+    if (!this->profiler) {
+      return 0;
+    }
+    auto found = this->profiler->stats.find("eye");
+    return found != this->profiler->stats.end() ? found->second.lastMs : 0;
   }
 };
 
-ViewRenderer::ViewRenderer(const Graphics *g,
-                           const std::shared_ptr<GraphicsSwapchain> &swapchain)
-    : _impl(new Impl(g, swapchain)) {}
+ViewRenderer::ViewRenderer(
+    const Graphics *g, const std::shared_ptr<GraphicsSwapchain> &swapchain,
+    const std::shared_ptr<GraphicsSwapchain> &depthSwapchain)
+    : _impl(new Impl(g, swapchain, depthSwapchain)) {}
 
 ViewRenderer::~ViewRenderer() { delete this->_impl; }
 
@@ -206,6 +235,9 @@ void ViewRenderer::initSwapchain(int width, int height,
   this->_impl->initSwapchain(width, height, images);
 }
 void ViewRenderer::render(uint32_t index, const XrColor4f &clearColor,
-                          std::span<const DirectX::XMFLOAT4X4> matrices) {
-  this->_impl->render(index, clearColor, matrices);
+                          const DirectX::XMFLOAT4X4 &viewProjection,
+                          std::span<const DirectX::XMFLOAT4X4> models) {
+  this->_impl->render(index, clearColor, viewProjection, models);
 }
+double ViewRenderer::gpuMs() const { return this->_impl->gpuMs(); }
+bool ViewRenderer::measuresGpuTime() { return true; }
@@ -1,6 +1,7 @@
 #include "../xr_main_loop.h"
 #include "../xr_linear.h"
 
+#include <vuloxr/xr/resolution.h>
 #include <vuloxr/xr/session.h>
 #include <vuloxr/xr/swapchain.h>
 
@@ -8,6 +9,10 @@
 
 #include <thread>
 
+// the projection. also XrCompositionLayerDepthInfoKHR
+const float NEAR_Z = 0.05f;
+const float FAR_Z = 100.0f;
+
 struct Cube {
   XrPosef pose;
   XrVector3f scale;
@@ -79,18 +84,13 @@ struct CubeScene : vuloxr::NonCopyable {
 
   void clear() { this->cubes.clear(); }
 
-  std::span<const DirectX::XMFLOAT4X4>
-  calcMatrix(const DirectX::XMFLOAT4X4 &viewProjection) {
+  // world matrices. once per frame, shared by the views
+  std::span<const DirectX::XMFLOAT4X4> calcModels() {
     this->matrices.resize(this->cubes.size());
 
-    auto vp =
-        DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4 *)&viewProjection);
-
     for (int i = 0; i < this->cubes.size(); ++i) {
       auto &cube = this->cubes[i];
 
-      // Compute the model-view-projection transform and push it.
-      // XrMatrix4x4f model;
       auto model = DirectX::XMMatrixTransformation(
           // S
           DirectX::XMVectorZero(), DirectX::XMQuaternionIdentity(),
@@ -102,20 +102,23 @@ struct CubeScene : vuloxr::NonCopyable {
           // T
           DirectX::XMLoadFloat3(
               (const DirectX::XMFLOAT3 *)&cube.pose.position));
-      // XrMatrix4x4f_CreateTranslationRotationScale(
-      //     &model, &cube.pose.position, &cube.pose.orientation, &cube.scale);
 
-      // auto mvp = (XrMatrix4x4f *)&m;
-      // XrMatrix4x4f_Multiply(mvp, &vp, &model);
-      auto mvp = DirectX::XMMatrixMultiply(model, vp);
-
-      DirectX::XMStoreFloat4x4(&this->matrices[i], mvp);
+      DirectX::XMStoreFloat4x4(&this->matrices[i], model);
     }
 
     return this->matrices;
   }
 };
 
+SceneHook xr_scene_hook;
+
+// handed from the frame thread to the render thread
+struct SceneSnapshot {
+  bool located = false;
+  std::vector<XrView> views;
+  std::vector<DirectX::XMFLOAT4X4> models;
+};
+
 char VS[] = {
 #embed "shader.vert"
     , 0};
@@ -184,23 +187,47 @@ constexpr uint16_t indices[] = {
 void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
                   XrSystemId systemId, XrSession session, XrSpace appSpace,
                   std::span<const int64_t> formats, const Graphics &graphics,
-                  const XrColor4f &clearColor, XrEnvironmentBlendMode blendMode,
+                  const XrColor4f &clearColor, bool depthLayer,
+                  XrEnvironmentBlendMode blendMode,
                   XrViewConfigurationType viewConfigurationType) {
 
   vuloxr::xr::Stereoscope stereoscope(instance, systemId,
                                       viewConfigurationType);
 
   auto format = Graphics::selectColorSwapchainFormat(formats);
+  // the compositor reprojects with the depth when a frame is late
+  int64_t depthFormat =
+      depthLayer ? Graphics::selectDepthSwapchainFormat(formats) : 0;
+  if (depthLayer && !depthFormat) {
+    vuloxr::Logger::Warn("no depth swapchain format");
+  }
 
   // Create resources for each view.
   std::vector<std::shared_ptr<GraphicsSwapchain>> swapchains;
+  std::vector<std::shared_ptr<GraphicsSwapchain>> depthSwapchains;
   std::vector<std::shared_ptr<ViewRenderer>> renderers;
+  float maxRenderScale = 2.0f;
+  // maxImageRect is allocated only if the scale can follow the gpu time
+  auto dynamicResolution = ViewRenderer::measuresGpuTime();
   for (uint32_t i = 0; i < stereoscope.views.size(); i++) {
+    // renders renderExtent of it
     auto swapchain = std::make_shared<GraphicsSwapchain>(
-        session, i, stereoscope.viewConfigurations[i], format, SwapchainImage);
+        session, i, stereoscope.viewConfigurations[i], format, SwapchainImage,
+        1, dynamicResolution);
     swapchains.push_back(swapchain);
+    maxRenderScale = std::min(maxRenderScale, swapchain->maxRenderScale());
+
+    std::shared_ptr<GraphicsSwapchain> depthSwapchain;
+    if (depthFormat) {
+      depthSwapchain = std::make_shared<GraphicsSwapchain>(
+          session, i, stereoscope.viewConfigurations[i], depthFormat,
+          SwapchainImage, 1, dynamicResolution,
+          XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    }
+    depthSwapchains.push_back(depthSwapchain);
 
-    auto r = std::make_shared<ViewRenderer>(&graphics, swapchain);
+    auto r = std::make_shared<ViewRenderer>(&graphics, swapchain,
+                                            depthSwapchain);
 
     r->initScene(VS, FS, layouts,
                  {
@@ -222,30 +249,26 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
   }
 
   CubeScene scene(session);
+  vuloxr::xr::DynamicResolution resolution(maxRenderScale);
 
-  // mainloop
   vuloxr::xr::SessionState state(instance, session, viewConfigurationType);
   vuloxr::xr::InputState input(instance, session);
-  while (runLoop(state.m_sessionRunning)) {
-    state.PollEvents();
-    if (state.m_exitRenderLoop) {
-      break;
-    }
 
-    if (!state.m_sessionRunning) {
-      // Throttle loop since xrWaitFrame won't be called.
-      std::this_thread::sleep_for(std::chrono::milliseconds(250));
-      continue;
-    }
-
-    input.PollActions();
-
-    auto frameState = vuloxr::xr::beginFrame(session);
-    vuloxr::xr::LayerComposition composition(appSpace, blendMode);
-
-    if (frameState.shouldRender == XR_TRUE) {
-      if (stereoscope.Locate(session, appSpace, frameState.predictedDisplayTime,
-                             viewConfigurationType)) {
+  // frame thread. xrWaitFrame, input and locate overlap the rendering of the
+  // previous frame
+  vuloxr::xr::FramePipeline<SceneSnapshot> pipeline(
+      session, [&](const XrFrameState &frameState, SceneSnapshot &snapshot) {
+        input.PollActions();
+
+        snapshot.located =
+            frameState.shouldRender == XR_TRUE &&
+            stereoscope.Locate(session, appSpace,
+                               frameState.predictedDisplayTime,
+                               viewConfigurationType);
+        if (!snapshot.located) {
+          return;
+        }
+        snapshot.views = stereoscope.views;
 
         scene.clear();
         for (XrSpace visualizedSpace : scene.spaces) {
@@ -264,49 +287,108 @@ void xr_main_loop(const std::function<bool(bool)> &runLoop, XrInstance instance,
           }
         }
 
-        for (uint32_t i = 0; i < stereoscope.views.size(); ++i) {
-          // XrCompositionLayerProjectionView(left / right)
-          auto swapchain = swapchains[i];
-          auto [index, image, projectionLayer] =
-              swapchain->AcquireSwapchain(stereoscope.views[i]);
+        auto models = scene.calcModels();
+        snapshot.models.assign(models.begin(), models.end());
+        if (xr_scene_hook) {
+          xr_scene_hook(frameState.predictedDisplayTime, snapshot.models);
+        }
+      });
+  state.m_beforeEndSession = [&pipeline]() { pipeline.stop(); };
+
+  // mainloop. render thread
+  while (runLoop(state.m_sessionRunning)) {
+    state.PollEvents();
+    if (state.m_exitRenderLoop) {
+      break;
+    }
+
+    if (!state.m_sessionRunning) {
+      // Throttle loop since xrWaitFrame won't be called.
+      std::this_thread::sleep_for(std::chrono::milliseconds(250));
+      continue;
+    }
+
+    pipeline.start();
+    auto frame = pipeline.beginFrame();
+    if (!frame) {
+      continue;
+    }
+    vuloxr::xr::LayerComposition composition(appSpace, blendMode);
+
+    // the sum of the eyes. 0 until every eye is measured
+    double gpuMs = 0;
+    for (auto &r : renderers) {
+      auto ms = r->gpuMs();
+      if (ms <= 0) {
+        gpuMs = 0;
+        break;
+      }
+      gpuMs += ms;
+    }
+    auto scale = resolution.scale;
+    if (resolution.update(gpuMs, frame->state.predictedDisplayPeriod) !=
+        scale) {
+      vuloxr::Logger::Verbose("render scale %.2f (gpu %.2fms)",
+                              resolution.scale, resolution.averageMs);
+      for (auto &swapchain : swapchains) {
+        swapchain->setRenderScale(resolution.scale);
+      }
+      for (auto &depthSwapchain : depthSwapchains) {
+        if (depthSwapchain) {
+          depthSwapchain->setRenderScale(resolution.scale);
+        }
+      }
+    }
+
+    if (frame->scene.located) {
+      auto &views = frame->scene.views;
+      for (uint32_t i = 0; i < views.size(); ++i) {
+        // XrCompositionLayerProjectionView(left / right)
+        auto swapchain = swapchains[i];
+        auto [index, image, projectionLayer] =
+            swapchain->AcquireSwapchain(views[i]);
+        if (auto &depthSwapchain = depthSwapchains[i]) {
+          composition.pushView(projectionLayer,
+                               depthSwapchain->DepthInfo(NEAR_Z, FAR_Z));
+        } else {
           composition.pushView(projectionLayer);
+        }
 
-          // Compute the view-projection transform. Note all matrixes (including
-          // OpenXR's) are column-major, right-handed.
-          XrMatrix4x4f proj;
+        // Compute the view-projection transform. Note all matrixes (including
+        // OpenXR's) are column-major, right-handed.
+        XrMatrix4x4f proj;
 
-          XrMatrix4x4f_CreateProjectionFov(&proj,
+        XrMatrix4x4f_CreateProjectionFov(&proj,
 #ifdef XR_USE_GRAPHICS_API_VULKAN
-                                           GRAPHICS_VULKAN,
+                                         GRAPHICS_VULKAN,
 #elif defined(XR_USE_GRAPHICS_API_OPENGL_ES)
-                                           GRAPHICS_OPENGL_ES,
+                                         GRAPHICS_OPENGL_ES,
 #elif defined(XR_USE_GRAPHICS_API_OPENGL)
-                                           GRAPHICS_OPENGL,
+                                         GRAPHICS_OPENGL,
 #else
-                                           static_assert(false, "no XR_USE_");
+                                         static_assert(false, "no XR_USE_");
 #endif
 
-                                           projectionLayer.fov, 0.05f, 100.0f);
-          XrMatrix4x4f toView;
-          XrMatrix4x4f_CreateFromRigidTransform(&toView, &projectionLayer.pose);
-          XrMatrix4x4f view;
-          XrMatrix4x4f_InvertRigidBody(&view, &toView);
-          XrMatrix4x4f vp;
-          XrMatrix4x4f_Multiply(&vp, &proj, &view);
+                                         projectionLayer.fov, NEAR_Z, FAR_Z);
+        XrMatrix4x4f toView;
+        XrMatrix4x4f_CreateFromRigidTransform(&toView, &projectionLayer.pose);
+        XrMatrix4x4f view;
+        XrMatrix4x4f_InvertRigidBody(&view, &toView);
+        XrMatrix4x4f vp;
+        XrMatrix4x4f_Multiply(&vp, &proj, &view);
 
-          auto matrices = scene.calcMatrix(*((DirectX::XMFLOAT4X4 *)&vp));
-          renderers[i]->render(index, clearColor, matrices);
+        renderers[i]->render(index, clearColor, *((DirectX::XMFLOAT4X4 *)&vp),
+                             frame->scene.models);
 
-          swapchain->EndSwapchain();
-        }
+        swapchain->EndSwapchain();
       }
     }
 
     // std::vector<XrCompositionLayerBaseHeader *>
     auto &layers = composition.commitLayers();
-    vuloxr::xr::endFrame(session, frameState.predictedDisplayTime, layers,
-                         blendMode);
+    pipeline.endFrame(*frame, layers, blendMode);
   }
+  pipeline.stop();
 
   // vkDeviceWaitIdle(graphics.device);
 }
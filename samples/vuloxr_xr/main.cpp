@@ -36,6 +36,10 @@ int main(int argc, char *argv[]) {
 #define createGraphics vuloxr::xr::createGl
 #endif
 
+  // positional reprojection with the depth buffer
+  auto depthLayer = xr_instance.enableIfSupported(
+      XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+
   if (xr_instance.create(nullptr) != XR_SUCCESS) {
     vuloxr::Logger::Info("no xro::Instance. no Oculus link ? shutdown...");
     return 1;
@@ -68,7 +72,7 @@ int main(int argc, char *argv[]) {
             return true;
           },
           xr_instance.instance, xr_instance.systemId, session, appSpace,
-          session.formats, vulkan, clearColor);
+          session.formats, vulkan, clearColor, depthLayer);
 
       // session
     }
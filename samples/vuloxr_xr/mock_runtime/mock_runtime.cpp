@@ -0,0 +1,1519 @@
+//
+// stand-in OpenXR runtime for headless benchmarks. no display, no tracking.
+//
+//   XR_RUNTIME_JSON=.../vuloxr_mock_runtime.json hello_xr_vk
+//
+// XR_KHR_vulkan_enable2 and XR_KHR_composition_layer_depth. swapchain images
+// are plain VkImages in device memory that nobody reads. xrWaitFrame
+// throttles to the display period and the head and hand poses follow a
+// script.
+//
+// environment
+//   VULOXR_MOCK_PERIOD_MS  predicted display period. default 11.111 (90Hz)
+//   VULOXR_MOCK_SIZE       recommended view size WxH. default 1024x1024
+//   VULOXR_MOCK_FRAMES     request exit after N xrEndFrame. default 0, never
+//   VULOXR_MOCK_SCRIPT     pose script. see PoseScript
+//   VULOXR_MOCK_REPORT     write the timings as json at xrDestroySession
+//
+#include <vulkan/vulkan.h>
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_negotiation.h>
+#include <openxr/openxr_platform.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <numbers>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <vuloxr.h>
+
+#ifdef _WIN32
+#define MOCK_EXPORT __declspec(dllexport)
+#else
+#define MOCK_EXPORT __attribute__((visibility("default")))
+#endif
+
+namespace mock {
+
+using Clock = std::chrono::steady_clock;
+
+static XrTime toXrTime(Clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             t.time_since_epoch())
+      .count();
+}
+
+static double ms(Clock::time_point begin, Clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// handles are pointers to the structs below
+template <typename H, typename T> static H toHandle(T *p) {
+  return (H)(uintptr_t)p;
+}
+template <typename T, typename H> static T *fromHandle(H h) {
+  return (T *)(uintptr_t)h;
+}
+
+//
+// pose math
+//
+static XrQuaternionf mul(const XrQuaternionf &a, const XrQuaternionf &b) {
+  return {
+      a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+      a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+      a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+      a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+  };
+}
+
+static XrVector3f rotate(const XrQuaternionf &q, const XrVector3f &v) {
+  auto r = mul(mul(q, {v.x, v.y, v.z, 0}), {-q.x, -q.y, -q.z, q.w});
+  return {r.x, r.y, r.z};
+}
+
+// apply b then a
+static XrPosef compose(const XrPosef &a, const XrPosef &b) {
+  auto p = rotate(a.orientation, b.position);
+  return {
+      .orientation = mul(a.orientation, b.orientation),
+      .position = {a.position.x + p.x, a.position.y + p.y,
+                   a.position.z + p.z},
+  };
+}
+
+static XrPosef inverse(const XrPosef &a) {
+  XrQuaternionf q{-a.orientation.x, -a.orientation.y, -a.orientation.z,
+                  a.orientation.w};
+  auto p = rotate(q, a.position);
+  return {.orientation = q, .position = {-p.x, -p.y, -p.z}};
+}
+
+static XrPosef yawPose(float radians, XrVector3f position) {
+  return {
+      .orientation = {0, std::sin(radians * 0.5f), 0, std::cos(radians * 0.5f)},
+      .position = position,
+  };
+}
+
+static const XrPosef IDENTITY{.orientation = {0, 0, 0, 1},
+                              .position = {0, 0, 0}};
+
+// head, left hand and right hand in LOCAL space.
+//
+// one key per line. '#' starts a comment. the script loops after the last
+// key. positions are interpolated linearly and orientations with nlerp.
+//
+//   # seconds track px py pz qx qy qz qw [grab]
+//   0.0 head  0 0 0      0 0 0 1
+//   2.0 head  0 0 0      0 0.38 0 0.92
+//   0.0 left  -0.2 -0.3 -0.4  0 0 0 1  0.0
+//
+// without a script the head turns +-30 degrees every 4 seconds and the hands
+// draw circles in front of it.
+struct PoseScript {
+  enum Track {
+    HEAD,
+    LEFT,
+    RIGHT,
+    COUNT,
+  };
+  struct Key {
+    double time;
+    XrPosef pose;
+    float grab;
+  };
+  std::array<std::vector<Key>, COUNT> tracks;
+  double duration = 0;
+
+  bool load(const char *path) {
+    std::ifstream is(path);
+    if (!is) {
+      return false;
+    }
+    std::string line;
+    while (std::getline(is, line)) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream ss(line);
+      Key key{.grab = 0};
+      std::string name;
+      auto &p = key.pose;
+      if (!(ss >> key.time >> name >> p.position.x >> p.position.y >>
+            p.position.z >> p.orientation.x >> p.orientation.y >>
+            p.orientation.z >> p.orientation.w)) {
+        continue;
+      }
+      ss >> key.grab;
+      auto track = name == "head"   ? HEAD
+                   : name == "left" ? LEFT
+                   : name == "right"
+                       ? RIGHT
+                       : COUNT;
+      if (track == COUNT) {
+        vuloxr::Logger::Warn("mock: unknown track '%s'", name.c_str());
+        continue;
+      }
+      this->tracks[track].push_back(key);
+      this->duration = std::max(this->duration, key.time);
+    }
+    for (auto &keys : this->tracks) {
+      std::sort(keys.begin(), keys.end(),
+                [](auto &a, auto &b) { return a.time < b.time; });
+    }
+    return true;
+  }
+
+  Key sample(Track track, double seconds) const {
+    auto &keys = this->tracks[track];
+    if (keys.empty()) {
+      return procedural(track, seconds);
+    }
+    if (this->duration > 0) {
+      seconds = std::fmod(seconds, this->duration);
+    }
+    auto it = std::upper_bound(
+        keys.begin(), keys.end(), seconds,
+        [](double t, const Key &key) { return t < key.time; });
+    if (it == keys.begin()) {
+      return keys.front();
+    }
+    if (it == keys.end()) {
+      return keys.back();
+    }
+    auto &a = *(it - 1);
+    auto &b = *it;
+    auto t = static_cast<float>((seconds - a.time) / (b.time - a.time));
+    return lerp(a, b, t);
+  }
+
+private:
+  static Key lerp(const Key &a, const Key &b, float t) {
+    auto &pa = a.pose;
+    auto &pb = b.pose;
+    auto qa = pa.orientation;
+    auto qb = pb.orientation;
+    // shortest arc
+    if (qa.x * qb.x + qa.y * qb.y + qa.z * qb.z + qa.w * qb.w < 0) {
+      qb = {-qb.x, -qb.y, -qb.z, -qb.w};
+    }
+    XrQuaternionf q{
+        qa.x + (qb.x - qa.x) * t,
+        qa.y + (qb.y - qa.y) * t,
+        qa.z + (qb.z - qa.z) * t,
+        qa.w + (qb.w - qa.w) * t,
+    };
+    auto len = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return {
+        .time = a.time + (b.time - a.time) * t,
+        .pose =
+            {
+                .orientation = {q.x / len, q.y / len, q.z / len, q.w / len},
+                .position =
+                    {
+                        pa.position.x + (pb.position.x - pa.position.x) * t,
+                        pa.position.y + (pb.position.y - pa.position.y) * t,
+                        pa.position.z + (pb.position.z - pa.position.z) * t,
+                    },
+            },
+        .grab = a.grab + (b.grab - a.grab) * t,
+    };
+  }
+
+  static Key procedural(Track track, double seconds) {
+    constexpr auto PI = std::numbers::pi_v<float>;
+    auto t = static_cast<float>(seconds);
+    auto head = yawPose(PI / 6 * std::sin(2 * PI * t / 4), {0, 0, 0});
+    switch (track) {
+    case HEAD:
+      return {.time = seconds, .pose = head, .grab = 0};
+    case LEFT:
+    case RIGHT: {
+      auto side = track == LEFT ? -1.0f : 1.0f;
+      auto a = 2 * PI * t / 2 * side;
+      return {
+          .time = seconds,
+          .pose = compose(head, yawPose(0, {side * 0.2f + 0.05f * std::cos(a),
+                                            -0.3f + 0.05f * std::sin(a),
+                                            -0.4f})),
+          .grab = 0.5f + 0.5f * std::sin(2 * PI * t / 3),
+      };
+    }
+    default:
+      return {.time = seconds, .pose = IDENTITY, .grab = 0};
+    }
+  }
+};
+
+//
+// objects
+//
+struct Session;
+
+struct Instance {
+  PoseScript script;
+  std::chrono::nanoseconds period;
+  uint32_t width = 1024;
+  uint32_t height = 1024;
+  uint64_t exitAfter = 0;
+  std::string report;
+  Clock::time_point start = Clock::now();
+
+  std::mutex mutex;
+  std::vector<std::string> paths;
+  std::deque<XrEventDataSessionStateChanged> events;
+
+  XrPath path(const std::string &str) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto found = std::find(this->paths.begin(), this->paths.end(), str);
+    if (found != this->paths.end()) {
+      return static_cast<XrPath>(found - this->paths.begin() + 1);
+    }
+    this->paths.push_back(str);
+    return static_cast<XrPath>(this->paths.size());
+  }
+
+  PoseScript::Key sample(PoseScript::Track track, XrTime time) const {
+    auto seconds = (time - toXrTime(this->start)) / 1e9;
+    return this->script.sample(track, std::max(0.0, seconds));
+  }
+};
+
+struct Stats {
+  std::vector<double> frameMs;
+  std::vector<double> cpuMs;
+  std::vector<double> waitFrameMs;
+  std::vector<double> acquireMs;
+  uint32_t late = 0;
+  uint32_t discarded = 0;
+};
+
+struct Session {
+  Instance *instance;
+  VkPhysicalDevice physicalDevice;
+  VkDevice device;
+  // read by the xrWaitFrame thread
+  std::atomic<XrSessionState> state = XR_SESSION_STATE_UNKNOWN;
+  // guarded by mutex
+  bool exitRequested = false;
+
+  // xrWaitFrame, xrBeginFrame, xrEndFrame counts
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint64_t waited = 0;
+  uint64_t begun = 0;
+  uint64_t ended = 0;
+  Clock::time_point vsync;
+  // return of xrWaitFrame for each predictedDisplayTime in flight
+  std::deque<std::pair<XrTime, Clock::time_point>> inFlight;
+  Clock::time_point lastEnd;
+  Stats stats;
+
+  void setState(XrSessionState newState) {
+    this->state = newState;
+    std::lock_guard<std::mutex> lock(this->instance->mutex);
+    this->instance->events.push_back({
+        .type = XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED,
+        .session = toHandle<XrSession>(this),
+        .state = newState,
+        .time = toXrTime(Clock::now()),
+    });
+  }
+
+  bool running() const {
+    return this->state == XR_SESSION_STATE_SYNCHRONIZED ||
+           this->state == XR_SESSION_STATE_VISIBLE ||
+           this->state == XR_SESSION_STATE_FOCUSED ||
+           this->state == XR_SESSION_STATE_STOPPING;
+  }
+
+  // call with mutex locked. xrRequestExitSession and xrEndFrame race
+  void requestExit() {
+    if (this->exitRequested) {
+      return;
+    }
+    this->exitRequested = true;
+    if (this->state == XR_SESSION_STATE_FOCUSED) {
+      this->setState(XR_SESSION_STATE_VISIBLE);
+    }
+    if (this->state == XR_SESSION_STATE_VISIBLE) {
+      this->setState(XR_SESSION_STATE_SYNCHRONIZED);
+    }
+    if (this->state == XR_SESSION_STATE_SYNCHRONIZED) {
+      this->setState(XR_SESSION_STATE_STOPPING);
+    }
+  }
+};
+
+struct Swapchain {
+  Session *session;
+  XrSwapchainCreateInfo createInfo;
+  std::vector<VkImage> images;
+  std::vector<VkDeviceMemory> memories;
+  uint32_t next = 0;
+  std::deque<uint32_t> acquired;
+  bool waited = false;
+  Clock::time_point acquireBegin;
+};
+
+struct Space {
+  Session *session;
+  // XR_REFERENCE_SPACE_TYPE_MAX_ENUM for an action space
+  XrReferenceSpaceType type;
+  PoseScript::Track track;
+  XrPosef offset;
+
+  XrPosef locate(XrTime time) const {
+    auto instance = this->session->instance;
+    switch (this->type) {
+    case XR_REFERENCE_SPACE_TYPE_VIEW:
+      return compose(instance->sample(PoseScript::HEAD, time).pose,
+                     this->offset);
+    case XR_REFERENCE_SPACE_TYPE_LOCAL:
+      return this->offset;
+    case XR_REFERENCE_SPACE_TYPE_STAGE:
+      // the floor is 1.6m below the LOCAL origin
+      return compose(yawPose(0, {0, -1.6f, 0}), this->offset);
+    default:
+      return compose(instance->sample(this->track, time).pose, this->offset);
+    }
+  }
+};
+
+struct Action {
+  XrActionType type;
+};
+
+//
+// helpers
+//
+template <typename T>
+static XrResult enumerate(uint32_t capacity, uint32_t *countOutput, T *items,
+                          std::span<const T> values) {
+  if (!countOutput) {
+    return XR_ERROR_VALIDATION_FAILURE;
+  }
+  *countOutput = static_cast<uint32_t>(values.size());
+  if (capacity == 0) {
+    return XR_SUCCESS;
+  }
+  if (capacity < values.size()) {
+    return XR_ERROR_SIZE_INSUFFICIENT;
+  }
+  std::copy(values.begin(), values.end(), items);
+  return XR_SUCCESS;
+}
+
+static XrResult enumerateString(uint32_t capacity, uint32_t *countOutput,
+                                char *buffer, const std::string &str) {
+  auto size = static_cast<uint32_t>(str.size() + 1);
+  *countOutput = size;
+  if (capacity == 0) {
+    return XR_SUCCESS;
+  }
+  if (capacity < size) {
+    return XR_ERROR_SIZE_INSUFFICIENT;
+  }
+  memcpy(buffer, str.c_str(), size);
+  return XR_SUCCESS;
+}
+
+static const char *getEnv(const char *name) {
+  auto value = getenv(name);
+  return value && value[0] ? value : nullptr;
+}
+
+static double percentile(std::vector<double> values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(p * (values.size() - 1) + 0.5)];
+}
+
+static double average(const std::vector<double> &values) {
+  double sum = 0;
+  for (auto v : values) {
+    sum += v;
+  }
+  return values.empty() ? 0 : sum / values.size();
+}
+
+static void printStats(const char *label, const std::vector<double> &ms) {
+  printf("%-10s avg %8.3f  p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f (ms)\n",
+         label, average(ms), percentile(ms, 0.5), percentile(ms, 0.9),
+         percentile(ms, 0.99), percentile(ms, 1.0));
+}
+
+static void writeStats(std::ostream &os, const char *label,
+                       const std::vector<double> &ms, bool last = false) {
+  os << "  \"" << label << "\": {\"avg\": " << average(ms)
+     << ", \"p50\": " << percentile(ms, 0.5)
+     << ", \"p90\": " << percentile(ms, 0.9)
+     << ", \"p99\": " << percentile(ms, 0.99)
+     << ", \"max\": " << percentile(ms, 1.0) << "}" << (last ? "\n" : ",\n");
+}
+
+static void report(const Session &session) {
+  auto &stats = session.stats;
+  auto periodMs = session.instance->period.count() / 1e6;
+  printf("mock       %llu frames, period %.3f ms, %u late, %u discarded\n",
+         (unsigned long long)session.ended, periodMs, stats.late,
+         stats.discarded);
+  printStats("frame", stats.frameMs);
+  printStats("cpu", stats.cpuMs);
+  printStats("waitFrame", stats.waitFrameMs);
+  printStats("acquire", stats.acquireMs);
+
+  auto &path = session.instance->report;
+  if (path.empty()) {
+    return;
+  }
+  std::ofstream os(path);
+  if (!os) {
+    vuloxr::Logger::Error("mock: fail to write %s", path.c_str());
+    return;
+  }
+  os << "{\n"
+     << "  \"frames\": " << session.ended << ",\n"
+     << "  \"period_ms\": " << periodMs << ",\n"
+     << "  \"late\": " << stats.late << ",\n"
+     << "  \"discarded\": " << stats.discarded << ",\n";
+  writeStats(os, "frame_ms", stats.frameMs);
+  writeStats(os, "cpu_ms", stats.cpuMs);
+  writeStats(os, "wait_frame_ms", stats.waitFrameMs);
+  writeStats(os, "acquire_ms", stats.acquireMs, true);
+  os << "}\n";
+  printf("report     %s\n", path.c_str());
+}
+
+static uint32_t findMemoryType(VkPhysicalDevice physicalDevice,
+                               uint32_t typeBits,
+                               VkMemoryPropertyFlags properties) {
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+    if ((typeBits & (1 << i)) &&
+        (memoryProperties.memoryTypes[i].propertyFlags & properties) ==
+            properties) {
+      return i;
+    }
+  }
+  return UINT32_MAX;
+}
+
+static const XrExtensionProperties EXTENSIONS[] = {
+    {
+        .type = XR_TYPE_EXTENSION_PROPERTIES,
+        .extensionName = XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME,
+        .extensionVersion = XR_KHR_vulkan_enable2_SPEC_VERSION,
+    },
+    // accepted and ignored. nothing is composited
+    {
+        .type = XR_TYPE_EXTENSION_PROPERTIES,
+        .extensionName = XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME,
+        .extensionVersion = XR_KHR_composition_layer_depth_SPEC_VERSION,
+    },
+};
+
+static const XrSystemId SYSTEM_ID = 1;
+
+// color and depth. XR_KHR_composition_layer_depth takes the depth ones
+static const int64_t SWAPCHAIN_FORMATS[] = {
+    VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_SRGB,
+    VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8A8_UNORM,
+    VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM,
+};
+
+//
+// instance
+//
+static XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance,
+                                                 const char *name,
+                                                 PFN_xrVoidFunction *function);
+
+static XrResult XRAPI_CALL xrEnumerateInstanceExtensionProperties(
+    const char *layerName, uint32_t propertyCapacityInput,
+    uint32_t *propertyCountOutput, XrExtensionProperties *properties) {
+  if (layerName) {
+    return XR_ERROR_API_LAYER_NOT_PRESENT;
+  }
+  return enumerate(propertyCapacityInput, propertyCountOutput, properties,
+                   std::span<const XrExtensionProperties>(EXTENSIONS));
+}
+
+static XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCreateInfo *info,
+                                            XrInstance *out) {
+  if (XR_VERSION_MAJOR(info->applicationInfo.apiVersion) != 1) {
+    return XR_ERROR_API_VERSION_UNSUPPORTED;
+  }
+  for (uint32_t i = 0; i < info->enabledExtensionCount; ++i) {
+    auto name = info->enabledExtensionNames[i];
+    if (std::none_of(std::begin(EXTENSIONS), std::end(EXTENSIONS),
+                     [name](auto &e) {
+                       return strcmp(e.extensionName, name) == 0;
+                     })) {
+      vuloxr::Logger::Error("mock: %s is not supported", name);
+      return XR_ERROR_EXTENSION_NOT_PRESENT;
+    }
+  }
+
+  auto instance = new Instance;
+  auto periodMs = 1000.0 / 90;
+  if (auto value = getEnv("VULOXR_MOCK_PERIOD_MS")) {
+    periodMs = std::max(0.1, atof(value));
+  }
+  instance->period =
+      std::chrono::nanoseconds(static_cast<int64_t>(periodMs * 1e6));
+  if (auto value = getEnv("VULOXR_MOCK_SIZE")) {
+    sscanf(value, "%ux%u", &instance->width, &instance->height);
+  }
+  if (auto value = getEnv("VULOXR_MOCK_FRAMES")) {
+    instance->exitAfter = strtoull(value, nullptr, 10);
+  }
+  if (auto value = getEnv("VULOXR_MOCK_SCRIPT")) {
+    if (!instance->script.load(value)) {
+      vuloxr::Logger::Error("mock: fail to load %s", value);
+    }
+  }
+  if (auto value = getEnv("VULOXR_MOCK_REPORT")) {
+    instance->report = value;
+  }
+  vuloxr::Logger::Info("mock: %s, period %.3f ms, %ux%u",
+                       info->applicationInfo.applicationName, periodMs,
+                       instance->width, instance->height);
+  *out = toHandle<XrInstance>(instance);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrDestroyInstance(XrInstance instance) {
+  delete fromHandle<Instance>(instance);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrGetInstanceProperties(XrInstance instance, XrInstanceProperties *properties) {
+  properties->runtimeVersion = XR_MAKE_VERSION(0, 1, 0);
+  snprintf(properties->runtimeName, sizeof(properties->runtimeName),
+           "vuloxr mock runtime");
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrPollEvent(XrInstance _instance,
+                                       XrEventDataBuffer *eventData) {
+  auto instance = fromHandle<Instance>(_instance);
+  std::lock_guard<std::mutex> lock(instance->mutex);
+  if (instance->events.empty()) {
+    return XR_EVENT_UNAVAILABLE;
+  }
+  static_assert(sizeof(XrEventDataSessionStateChanged) <=
+                sizeof(XrEventDataBuffer));
+  memcpy(eventData, &instance->events.front(),
+         sizeof(XrEventDataSessionStateChanged));
+  instance->events.pop_front();
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrResultToString(XrInstance instance, XrResult value,
+                 char buffer[XR_MAX_RESULT_STRING_SIZE]) {
+  snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_RESULT_%d", value);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrStructureTypeToString(
+    XrInstance instance, XrStructureType value,
+    char buffer[XR_MAX_STRUCTURE_NAME_SIZE]) {
+  snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "XR_STRUCTURE_TYPE_%d", value);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrStringToPath(XrInstance instance,
+                                          const char *pathString,
+                                          XrPath *path) {
+  if (!pathString || pathString[0] != '/') {
+    return XR_ERROR_PATH_FORMAT_INVALID;
+  }
+  *path = fromHandle<Instance>(instance)->path(pathString);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrPathToString(XrInstance _instance, XrPath path,
+                                          uint32_t bufferCapacityInput,
+                                          uint32_t *bufferCountOutput,
+                                          char *buffer) {
+  auto instance = fromHandle<Instance>(_instance);
+  std::string str;
+  {
+    std::lock_guard<std::mutex> lock(instance->mutex);
+    if (path == XR_NULL_PATH || path > instance->paths.size()) {
+      return XR_ERROR_PATH_INVALID;
+    }
+    str = instance->paths[path - 1];
+  }
+  return enumerateString(bufferCapacityInput, bufferCountOutput, buffer, str);
+}
+
+//
+// system
+//
+static XrResult XRAPI_CALL xrGetSystem(XrInstance instance,
+                                       const XrSystemGetInfo *getInfo,
+                                       XrSystemId *systemId) {
+  if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
+    return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+  }
+  *systemId = SYSTEM_ID;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrGetSystemProperties(
+    XrInstance instance, XrSystemId systemId, XrSystemProperties *properties) {
+  properties->systemId = systemId;
+  properties->vendorId = 0;
+  snprintf(properties->systemName, sizeof(properties->systemName),
+           "vuloxr mock hmd");
+  properties->graphicsProperties = {
+      .maxSwapchainImageHeight = 4096,
+      .maxSwapchainImageWidth = 4096,
+      .maxLayerCount = XR_MIN_COMPOSITION_LAYERS_SUPPORTED,
+  };
+  properties->trackingProperties = {
+      .orientationTracking = XR_TRUE,
+      .positionTracking = XR_TRUE,
+  };
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrEnumerateViewConfigurations(
+    XrInstance instance, XrSystemId systemId, uint32_t capacity,
+    uint32_t *countOutput, XrViewConfigurationType *types) {
+  static const XrViewConfigurationType TYPES[] = {
+      XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO,
+  };
+  return enumerate(capacity, countOutput, types,
+                   std::span<const XrViewConfigurationType>(TYPES));
+}
+
+static XrResult XRAPI_CALL xrGetViewConfigurationProperties(
+    XrInstance instance, XrSystemId systemId, XrViewConfigurationType type,
+    XrViewConfigurationProperties *properties) {
+  if (type != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+    return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+  }
+  properties->viewConfigurationType = type;
+  properties->fovMutable = XR_FALSE;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrEnumerateViewConfigurationViews(
+    XrInstance _instance, XrSystemId systemId, XrViewConfigurationType type,
+    uint32_t capacity, uint32_t *countOutput, XrViewConfigurationView *views) {
+  if (type != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+    return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+  }
+  auto instance = fromHandle<Instance>(_instance);
+  XrViewConfigurationView view{
+      .type = XR_TYPE_VIEW_CONFIGURATION_VIEW,
+      .recommendedImageRectWidth = instance->width,
+      .maxImageRectWidth = 4096,
+      .recommendedImageRectHeight = instance->height,
+      .maxImageRectHeight = 4096,
+      .recommendedSwapchainSampleCount = 1,
+      .maxSwapchainSampleCount = 4,
+  };
+  XrViewConfigurationView values[] = {view, view};
+  return enumerate(capacity, countOutput, views,
+                   std::span<const XrViewConfigurationView>(values));
+}
+
+static XrResult XRAPI_CALL xrEnumerateEnvironmentBlendModes(
+    XrInstance instance, XrSystemId systemId, XrViewConfigurationType type,
+    uint32_t capacity, uint32_t *countOutput,
+    XrEnvironmentBlendMode *blendModes) {
+  static const XrEnvironmentBlendMode MODES[] = {
+      XR_ENVIRONMENT_BLEND_MODE_OPAQUE,
+  };
+  return enumerate(capacity, countOutput, blendModes,
+                   std::span<const XrEnvironmentBlendMode>(MODES));
+}
+
+//
+// XR_KHR_vulkan_enable2
+//
+static XrResult XRAPI_CALL xrGetVulkanGraphicsRequirements2KHR(
+    XrInstance instance, XrSystemId systemId,
+    XrGraphicsRequirementsVulkanKHR *requirements) {
+  requirements->minApiVersionSupported = XR_MAKE_VERSION(1, 0, 0);
+  requirements->maxApiVersionSupported = XR_MAKE_VERSION(1, 4, 0);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrCreateVulkanInstanceKHR(
+    XrInstance instance, const XrVulkanInstanceCreateInfoKHR *createInfo,
+    VkInstance *vulkanInstance, VkResult *vulkanResult) {
+  auto pfnCreateInstance =
+      (PFN_vkCreateInstance)createInfo->pfnGetInstanceProcAddr(
+          VK_NULL_HANDLE, "vkCreateInstance");
+  *vulkanResult = pfnCreateInstance(createInfo->vulkanCreateInfo,
+                                    createInfo->vulkanAllocator,
+                                    vulkanInstance);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrGetVulkanGraphicsDevice2KHR(
+    XrInstance instance, const XrVulkanGraphicsDeviceGetInfoKHR *getInfo,
+    VkPhysicalDevice *vulkanPhysicalDevice) {
+  uint32_t count = 0;
+  vkEnumeratePhysicalDevices(getInfo->vulkanInstance, &count, nullptr);
+  std::vector<VkPhysicalDevice> physicalDevices(count);
+  vkEnumeratePhysicalDevices(getInfo->vulkanInstance, &count,
+                             physicalDevices.data());
+  if (physicalDevices.empty()) {
+    return XR_ERROR_RUNTIME_FAILURE;
+  }
+  // VULOXR_MOCK_DEVICE picks by name. e.g. llvmpipe
+  auto name = getEnv("VULOXR_MOCK_DEVICE");
+  *vulkanPhysicalDevice = physicalDevices[0];
+  for (auto physicalDevice : physicalDevices) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (name && strstr(properties.deviceName, name)) {
+      *vulkanPhysicalDevice = physicalDevice;
+      break;
+    }
+  }
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrCreateVulkanDeviceKHR(
+    XrInstance instance, const XrVulkanDeviceCreateInfoKHR *createInfo,
+    VkDevice *vulkanDevice, VkResult *vulkanResult) {
+  auto pfnCreateDevice = (PFN_vkCreateDevice)createInfo->pfnGetInstanceProcAddr(
+      VK_NULL_HANDLE, "vkCreateDevice");
+  if (!pfnCreateDevice) {
+    pfnCreateDevice = vkCreateDevice;
+  }
+  *vulkanResult =
+      pfnCreateDevice(createInfo->vulkanPhysicalDevice,
+                      createInfo->vulkanCreateInfo,
+                      createInfo->vulkanAllocator, vulkanDevice);
+  return XR_SUCCESS;
+}
+
+//
+// session
+//
+static XrResult XRAPI_CALL
+xrCreateSession(XrInstance instance, const XrSessionCreateInfo *createInfo,
+                XrSession *out) {
+  auto binding =
+      static_cast<const XrGraphicsBindingVulkan2KHR *>(createInfo->next);
+  if (!binding || binding->type != XR_TYPE_GRAPHICS_BINDING_VULKAN2_KHR) {
+    return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+  }
+  auto session = new Session{
+      .instance = fromHandle<Instance>(instance),
+      .physicalDevice = binding->physicalDevice,
+      .device = binding->device,
+  };
+  session->setState(XR_SESSION_STATE_IDLE);
+  session->setState(XR_SESSION_STATE_READY);
+  *out = toHandle<XrSession>(session);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrDestroySession(XrSession _session) {
+  auto session = fromHandle<Session>(_session);
+  report(*session);
+  delete session;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrBeginSession(XrSession _session,
+                                          const XrSessionBeginInfo *beginInfo) {
+  auto session = fromHandle<Session>(_session);
+  if (session->state != XR_SESSION_STATE_READY) {
+    return XR_ERROR_SESSION_NOT_READY;
+  }
+  if (beginInfo->primaryViewConfigurationType !=
+      XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+    return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+  }
+  session->vsync = Clock::now();
+  session->setState(XR_SESSION_STATE_SYNCHRONIZED);
+  session->setState(XR_SESSION_STATE_VISIBLE);
+  session->setState(XR_SESSION_STATE_FOCUSED);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrEndSession(XrSession _session) {
+  auto session = fromHandle<Session>(_session);
+  if (session->state != XR_SESSION_STATE_STOPPING) {
+    return XR_ERROR_SESSION_NOT_STOPPING;
+  }
+  session->setState(XR_SESSION_STATE_IDLE);
+  std::lock_guard<std::mutex> lock(session->mutex);
+  if (session->exitRequested) {
+    session->setState(XR_SESSION_STATE_EXITING);
+  }
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrRequestExitSession(XrSession _session) {
+  auto session = fromHandle<Session>(_session);
+  std::lock_guard<std::mutex> lock(session->mutex);
+  if (!session->running()) {
+    return XR_ERROR_SESSION_NOT_RUNNING;
+  }
+  session->requestExit();
+  return XR_SUCCESS;
+}
+
+//
+// frame
+//
+static XrResult XRAPI_CALL xrWaitFrame(XrSession _session,
+                                       const XrFrameWaitInfo *frameWaitInfo,
+                                       XrFrameState *frameState) {
+  auto session = fromHandle<Session>(_session);
+  if (!session->running()) {
+    return XR_ERROR_SESSION_NOT_RUNNING;
+  }
+  auto enter = Clock::now();
+  auto period = session->instance->period;
+
+  std::unique_lock<std::mutex> lock(session->mutex);
+  // blocks until xrBeginFrame of the previous frame
+  session->cv.wait(lock, [session]() {
+    return session->begun >= session->waited;
+  });
+
+  // the next vsync after the last one
+  auto now = Clock::now();
+  auto wake = session->vsync + period;
+  if (wake < now) {
+    // missed. skip to the vsync after now
+    auto skip = (now - session->vsync) / period;
+    wake = session->vsync + period * skip;
+    if (wake < now) {
+      wake += period;
+    }
+  }
+  session->vsync = wake;
+  lock.unlock();
+  std::this_thread::sleep_until(wake);
+  lock.lock();
+
+  auto returned = Clock::now();
+  ++session->waited;
+  // the app has one period after the wake up. the compositor takes the
+  // next period and the frame is displayed after that
+  auto displayTime = toXrTime(wake + period * 2);
+  session->inFlight.push_back({displayTime, returned});
+  if (session->inFlight.size() > 8) {
+    session->inFlight.pop_front();
+  }
+  session->stats.waitFrameMs.push_back(ms(enter, returned));
+
+  frameState->predictedDisplayTime = displayTime;
+  frameState->predictedDisplayPeriod = period.count();
+  frameState->shouldRender =
+      session->state == XR_SESSION_STATE_VISIBLE ||
+              session->state == XR_SESSION_STATE_FOCUSED
+          ? XR_TRUE
+          : XR_FALSE;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrBeginFrame(XrSession _session, const XrFrameBeginInfo *frameBeginInfo) {
+  auto session = fromHandle<Session>(_session);
+  XrResult result = XR_SUCCESS;
+  {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->begun >= session->waited) {
+      return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    if (session->ended < session->begun) {
+      // the previous frame was not ended
+      session->ended = session->begun;
+      ++session->stats.discarded;
+      result = XR_FRAME_DISCARDED;
+    }
+    ++session->begun;
+  }
+  session->cv.notify_all();
+  return result;
+}
+
+static XrResult XRAPI_CALL xrEndFrame(XrSession _session,
+                                      const XrFrameEndInfo *frameEndInfo) {
+  auto session = fromHandle<Session>(_session);
+  auto now = Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->ended >= session->begun) {
+      return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    if (frameEndInfo->layerCount > XR_MIN_COMPOSITION_LAYERS_SUPPORTED) {
+      return XR_ERROR_LAYER_LIMIT_EXCEEDED;
+    }
+    auto found = std::find_if(
+        session->inFlight.begin(), session->inFlight.end(),
+        [t = frameEndInfo->displayTime](auto &f) { return f.first == t; });
+    if (found == session->inFlight.end()) {
+      return XR_ERROR_TIME_INVALID;
+    }
+    ++session->ended;
+
+    auto &stats = session->stats;
+    if (session->ended > 1) {
+      stats.frameMs.push_back(ms(session->lastEnd, now));
+    }
+    session->lastEnd = now;
+    stats.cpuMs.push_back(ms(found->second, now));
+    // the compositor starts one period before the display time
+    if (toXrTime(now) > frameEndInfo->displayTime -
+                            session->instance->period.count()) {
+      ++stats.late;
+    }
+    session->inFlight.erase(found);
+
+    auto exitAfter = session->instance->exitAfter;
+    if (exitAfter > 0 && session->ended == exitAfter) {
+      session->requestExit();
+    }
+  }
+  return XR_SUCCESS;
+}
+
+//
+// swapchain
+//
+static XrResult XRAPI_CALL xrEnumerateSwapchainFormats(XrSession session,
+                                                       uint32_t capacity,
+                                                       uint32_t *countOutput,
+                                                       int64_t *formats) {
+  return enumerate(capacity, countOutput, formats,
+                   std::span<const int64_t>(SWAPCHAIN_FORMATS));
+}
+
+// the images and the memories created so far. then the swapchain
+static void destroySwapchain(Swapchain *swapchain) {
+  auto device = swapchain->session->device;
+  for (auto image : swapchain->images) {
+    vkDestroyImage(device, image, nullptr);
+  }
+  for (auto memory : swapchain->memories) {
+    vkFreeMemory(device, memory, nullptr);
+  }
+  delete swapchain;
+}
+
+static XrResult XRAPI_CALL
+xrCreateSwapchain(XrSession _session, const XrSwapchainCreateInfo *createInfo,
+                  XrSwapchain *out) {
+  auto session = fromHandle<Session>(_session);
+  if (std::find(std::begin(SWAPCHAIN_FORMATS), std::end(SWAPCHAIN_FORMATS),
+                createInfo->format) == std::end(SWAPCHAIN_FORMATS)) {
+    return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+  }
+
+  VkImageUsageFlags usage = 0;
+  if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) {
+    usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  }
+  if (createInfo->usageFlags &
+      XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+    usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  }
+  if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) {
+    usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+  }
+  if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT) {
+    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
+  if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT) {
+    usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  }
+  // the compositor would sample it
+  usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+
+  auto swapchain = new Swapchain{
+      .session = session,
+      .createInfo = *createInfo,
+  };
+  for (int i = 0; i < 3; ++i) {
+    VkImageCreateInfo imageInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .flags = (createInfo->usageFlags &
+                  XR_SWAPCHAIN_USAGE_MUTABLE_FORMAT_BIT)
+                     ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT
+                     : 0u,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = static_cast<VkFormat>(createInfo->format),
+        .extent = {createInfo->width, createInfo->height, 1},
+        .mipLevels = createInfo->mipCount,
+        .arrayLayers = createInfo->arraySize,
+        .samples = static_cast<VkSampleCountFlagBits>(createInfo->sampleCount),
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    VkImage image;
+    if (vkCreateImage(session->device, &imageInfo, nullptr, &image) !=
+        VK_SUCCESS) {
+      destroySwapchain(swapchain);
+      return XR_ERROR_RUNTIME_FAILURE;
+    }
+    swapchain->images.push_back(image);
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(session->device, image, &requirements);
+    VkMemoryAllocateInfo allocateInfo{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = requirements.size,
+        .memoryTypeIndex =
+            findMemoryType(session->physicalDevice,
+                           requirements.memoryTypeBits,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+    };
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(session->device, &allocateInfo, nullptr, &memory) !=
+        VK_SUCCESS) {
+      destroySwapchain(swapchain);
+      return XR_ERROR_RUNTIME_FAILURE;
+    }
+    swapchain->memories.push_back(memory);
+    if (vkBindImageMemory(session->device, image, memory, 0) != VK_SUCCESS) {
+      destroySwapchain(swapchain);
+      return XR_ERROR_RUNTIME_FAILURE;
+    }
+  }
+  *out = toHandle<XrSwapchain>(swapchain);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrDestroySwapchain(XrSwapchain _swapchain) {
+  auto swapchain = fromHandle<Swapchain>(_swapchain);
+  // the app has finished its commands with the images
+  vkDeviceWaitIdle(swapchain->session->device);
+  destroySwapchain(swapchain);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrEnumerateSwapchainImages(
+    XrSwapchain _swapchain, uint32_t capacity, uint32_t *countOutput,
+    XrSwapchainImageBaseHeader *images) {
+  auto swapchain = fromHandle<Swapchain>(_swapchain);
+  *countOutput = static_cast<uint32_t>(swapchain->images.size());
+  if (capacity == 0) {
+    return XR_SUCCESS;
+  }
+  if (capacity < swapchain->images.size()) {
+    return XR_ERROR_SIZE_INSUFFICIENT;
+  }
+  auto vulkanImages = reinterpret_cast<XrSwapchainImageVulkan2KHR *>(images);
+  for (size_t i = 0; i < swapchain->images.size(); ++i) {
+    if (vulkanImages[i].type != XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR) {
+      return XR_ERROR_VALIDATION_FAILURE;
+    }
+    vulkanImages[i].image = swapchain->images[i];
+  }
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrAcquireSwapchainImage(XrSwapchain _swapchain,
+                        const XrSwapchainImageAcquireInfo *acquireInfo,
+                        uint32_t *index) {
+  auto swapchain = fromHandle<Swapchain>(_swapchain);
+  if (swapchain->acquired.size() >= swapchain->images.size()) {
+    return XR_ERROR_CALL_ORDER_INVALID;
+  }
+  if (swapchain->acquired.empty()) {
+    swapchain->acquireBegin = Clock::now();
+  }
+  *index = swapchain->next;
+  swapchain->acquired.push_back(swapchain->next);
+  swapchain->next = (swapchain->next + 1) % swapchain->images.size();
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrWaitSwapchainImage(XrSwapchain _swapchain,
+                     const XrSwapchainImageWaitInfo *waitInfo) {
+  auto swapchain = fromHandle<Swapchain>(_swapchain);
+  if (swapchain->acquired.empty() || swapchain->waited) {
+    return XR_ERROR_CALL_ORDER_INVALID;
+  }
+  // the compositor never holds the images
+  swapchain->waited = true;
+  auto session = swapchain->session;
+  std::lock_guard<std::mutex> lock(session->mutex);
+  session->stats.acquireMs.push_back(
+      ms(swapchain->acquireBegin, Clock::now()));
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrReleaseSwapchainImage(XrSwapchain _swapchain,
+                        const XrSwapchainImageReleaseInfo *releaseInfo) {
+  auto swapchain = fromHandle<Swapchain>(_swapchain);
+  if (!swapchain->waited) {
+    return XR_ERROR_CALL_ORDER_INVALID;
+  }
+  swapchain->acquired.pop_front();
+  swapchain->waited = false;
+  if (!swapchain->acquired.empty()) {
+    swapchain->acquireBegin = Clock::now();
+  }
+  return XR_SUCCESS;
+}
+
+//
+// space
+//
+static XrResult XRAPI_CALL xrEnumerateReferenceSpaces(
+    XrSession session, uint32_t capacity, uint32_t *countOutput,
+    XrReferenceSpaceType *spaces) {
+  static const XrReferenceSpaceType TYPES[] = {
+      XR_REFERENCE_SPACE_TYPE_VIEW,
+      XR_REFERENCE_SPACE_TYPE_LOCAL,
+      XR_REFERENCE_SPACE_TYPE_STAGE,
+  };
+  return enumerate(capacity, countOutput, spaces,
+                   std::span<const XrReferenceSpaceType>(TYPES));
+}
+
+static XrResult XRAPI_CALL
+xrCreateReferenceSpace(XrSession session,
+                       const XrReferenceSpaceCreateInfo *createInfo,
+                       XrSpace *out) {
+  switch (createInfo->referenceSpaceType) {
+  case XR_REFERENCE_SPACE_TYPE_VIEW:
+  case XR_REFERENCE_SPACE_TYPE_LOCAL:
+  case XR_REFERENCE_SPACE_TYPE_STAGE:
+    break;
+  default:
+    return XR_ERROR_REFERENCE_SPACE_UNSUPPORTED;
+  }
+  *out = toHandle<XrSpace>(new Space{
+      .session = fromHandle<Session>(session),
+      .type = createInfo->referenceSpaceType,
+      .track = PoseScript::HEAD,
+      .offset = createInfo->poseInReferenceSpace,
+  });
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrGetReferenceSpaceBoundsRect(
+    XrSession session, XrReferenceSpaceType type, XrExtent2Df *bounds) {
+  if (type != XR_REFERENCE_SPACE_TYPE_STAGE) {
+    *bounds = {0, 0};
+    return XR_SPACE_BOUNDS_UNAVAILABLE;
+  }
+  *bounds = {2, 2};
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrCreateActionSpace(XrSession _session,
+                    const XrActionSpaceCreateInfo *createInfo, XrSpace *out) {
+  auto session = fromHandle<Session>(_session);
+  auto track = createInfo->subactionPath ==
+                       session->instance->path("/user/hand/left")
+                   ? PoseScript::LEFT
+                   : PoseScript::RIGHT;
+  *out = toHandle<XrSpace>(new Space{
+      .session = session,
+      .type = XR_REFERENCE_SPACE_TYPE_MAX_ENUM,
+      .track = track,
+      .offset = createInfo->poseInActionSpace,
+  });
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrDestroySpace(XrSpace space) {
+  delete fromHandle<Space>(space);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrLocateSpace(XrSpace _space, XrSpace _baseSpace,
+                                         XrTime time,
+                                         XrSpaceLocation *location) {
+  auto space = fromHandle<Space>(_space);
+  auto baseSpace = fromHandle<Space>(_baseSpace);
+  location->pose =
+      compose(inverse(baseSpace->locate(time)), space->locate(time));
+  location->locationFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT |
+                            XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+                            XR_SPACE_LOCATION_POSITION_TRACKED_BIT |
+                            XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrLocateViews(XrSession session,
+                                         const XrViewLocateInfo *locateInfo,
+                                         XrViewState *viewState,
+                                         uint32_t capacity,
+                                         uint32_t *countOutput, XrView *views) {
+  if (locateInfo->viewConfigurationType !=
+      XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+    return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+  }
+  auto space = fromHandle<Space>(locateInfo->space);
+  auto head = compose(inverse(space->locate(locateInfo->displayTime)),
+                      Space{
+                          .session = space->session,
+                          .type = XR_REFERENCE_SPACE_TYPE_VIEW,
+                          .track = PoseScript::HEAD,
+                          .offset = IDENTITY,
+                      }
+                          .locate(locateInfo->displayTime));
+
+  viewState->viewStateFlags = XR_VIEW_STATE_POSITION_VALID_BIT |
+                              XR_VIEW_STATE_ORIENTATION_VALID_BIT |
+                              XR_VIEW_STATE_POSITION_TRACKED_BIT |
+                              XR_VIEW_STATE_ORIENTATION_TRACKED_BIT;
+  *countOutput = 2;
+  if (capacity == 0) {
+    return XR_SUCCESS;
+  }
+  if (capacity < 2) {
+    return XR_ERROR_SIZE_INSUFFICIENT;
+  }
+  // 64mm ipd. 90 degrees symmetric fov
+  constexpr float HALF_IPD = 0.032f;
+  constexpr float HALF_FOV = std::numbers::pi_v<float> / 4;
+  for (int i = 0; i < 2; ++i) {
+    views[i].pose =
+        compose(head, yawPose(0, {i == 0 ? -HALF_IPD : HALF_IPD, 0, 0}));
+    views[i].fov = {-HALF_FOV, HALF_FOV, HALF_FOV, -HALF_FOV};
+  }
+  return XR_SUCCESS;
+}
+
+//
+// action. every action is bound and active
+//
+static XrResult XRAPI_CALL xrCreateActionSet(
+    XrInstance instance, const XrActionSetCreateInfo *createInfo,
+    XrActionSet *actionSet) {
+  // not used. a unique non null handle
+  *actionSet = toHandle<XrActionSet>(new int);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrDestroyActionSet(XrActionSet actionSet) {
+  delete fromHandle<int>(actionSet);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrCreateAction(XrActionSet actionSet,
+                                          const XrActionCreateInfo *createInfo,
+                                          XrAction *action) {
+  *action = toHandle<XrAction>(new Action{.type = createInfo->actionType});
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrDestroyAction(XrAction action) {
+  delete fromHandle<Action>(action);
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrSuggestInteractionProfileBindings(
+    XrInstance instance,
+    const XrInteractionProfileSuggestedBinding *suggestedBindings) {
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrAttachSessionActionSets(
+    XrSession session, const XrSessionActionSetsAttachInfo *attachInfo) {
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrGetCurrentInteractionProfile(
+    XrSession session, XrPath topLevelUserPath,
+    XrInteractionProfileState *interactionProfile) {
+  interactionProfile->interactionProfile =
+      fromHandle<Session>(session)->instance->path(
+          "/interaction_profiles/khr/simple_controller");
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrSyncActions(XrSession session,
+                                         const XrActionsSyncInfo *syncInfo) {
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo *getInfo,
+                        XrActionStateBoolean *state) {
+  state->currentState = XR_FALSE;
+  state->changedSinceLastSync = XR_FALSE;
+  state->lastChangeTime = 0;
+  state->isActive = XR_TRUE;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrGetActionStateFloat(XrSession _session, const XrActionStateGetInfo *getInfo,
+                      XrActionStateFloat *state) {
+  auto session = fromHandle<Session>(_session);
+  auto instance = session->instance;
+  auto track = getInfo->subactionPath == instance->path("/user/hand/left")
+                   ? PoseScript::LEFT
+                   : PoseScript::RIGHT;
+  state->currentState = instance->sample(track, toXrTime(Clock::now())).grab;
+  state->changedSinceLastSync = XR_TRUE;
+  state->lastChangeTime = toXrTime(Clock::now());
+  state->isActive = XR_TRUE;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL
+xrGetActionStatePose(XrSession session, const XrActionStateGetInfo *getInfo,
+                     XrActionStatePose *state) {
+  state->isActive = XR_TRUE;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrEnumerateBoundSourcesForAction(
+    XrSession session,
+    const XrBoundSourcesForActionEnumerateInfo *enumerateInfo,
+    uint32_t capacity, uint32_t *countOutput, XrPath *sources) {
+  *countOutput = 0;
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrGetInputSourceLocalizedName(
+    XrSession session, const XrInputSourceLocalizedNameGetInfo *getInfo,
+    uint32_t capacity, uint32_t *countOutput, char *buffer) {
+  return enumerateString(capacity, countOutput, buffer, "mock");
+}
+
+static XrResult XRAPI_CALL xrApplyHapticFeedback(
+    XrSession session, const XrHapticActionInfo *hapticActionInfo,
+    const XrHapticBaseHeader *hapticFeedback) {
+  return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL xrStopHapticFeedback(
+    XrSession session, const XrHapticActionInfo *hapticActionInfo) {
+  return XR_SUCCESS;
+}
+
+//
+// dispatch
+//
+#define MOCK_FUNCTION(name)                                                    \
+  {#name, reinterpret_cast<PFN_xrVoidFunction>(name)}
+
+static const std::unordered_map<std::string, PFN_xrVoidFunction> FUNCTIONS{
+    MOCK_FUNCTION(xrGetInstanceProcAddr),
+    MOCK_FUNCTION(xrEnumerateInstanceExtensionProperties),
+    MOCK_FUNCTION(xrCreateInstance),
+    MOCK_FUNCTION(xrDestroyInstance),
+    MOCK_FUNCTION(xrGetInstanceProperties),
+    MOCK_FUNCTION(xrPollEvent),
+    MOCK_FUNCTION(xrResultToString),
+    MOCK_FUNCTION(xrStructureTypeToString),
+    MOCK_FUNCTION(xrStringToPath),
+    MOCK_FUNCTION(xrPathToString),
+    MOCK_FUNCTION(xrGetSystem),
+    MOCK_FUNCTION(xrGetSystemProperties),
+    MOCK_FUNCTION(xrEnumerateViewConfigurations),
+    MOCK_FUNCTION(xrGetViewConfigurationProperties),
+    MOCK_FUNCTION(xrEnumerateViewConfigurationViews),
+    MOCK_FUNCTION(xrEnumerateEnvironmentBlendModes),
+    MOCK_FUNCTION(xrGetVulkanGraphicsRequirements2KHR),
+    MOCK_FUNCTION(xrCreateVulkanInstanceKHR),
+    MOCK_FUNCTION(xrGetVulkanGraphicsDevice2KHR),
+    MOCK_FUNCTION(xrCreateVulkanDeviceKHR),
+    MOCK_FUNCTION(xrCreateSession),
+    MOCK_FUNCTION(xrDestroySession),
+    MOCK_FUNCTION(xrBeginSession),
+    MOCK_FUNCTION(xrEndSession),
+    MOCK_FUNCTION(xrRequestExitSession),
+    MOCK_FUNCTION(xrWaitFrame),
+    MOCK_FUNCTION(xrBeginFrame),
+    MOCK_FUNCTION(xrEndFrame),
+    MOCK_FUNCTION(xrEnumerateSwapchainFormats),
+    MOCK_FUNCTION(xrCreateSwapchain),
+    MOCK_FUNCTION(xrDestroySwapchain),
+    MOCK_FUNCTION(xrEnumerateSwapchainImages),
+    MOCK_FUNCTION(xrAcquireSwapchainImage),
+    MOCK_FUNCTION(xrWaitSwapchainImage),
+    MOCK_FUNCTION(xrReleaseSwapchainImage),
+    MOCK_FUNCTION(xrEnumerateReferenceSpaces),
+    MOCK_FUNCTION(xrCreateReferenceSpace),
+    MOCK_FUNCTION(xrGetReferenceSpaceBoundsRect),
+    MOCK_FUNCTION(xrCreateActionSpace),
+    MOCK_FUNCTION(xrDestroySpace),
+    MOCK_FUNCTION(xrLocateSpace),
+    MOCK_FUNCTION(xrLocateViews),
+    MOCK_FUNCTION(xrCreateActionSet),
+    MOCK_FUNCTION(xrDestroyActionSet),
+    MOCK_FUNCTION(xrCreateAction),
+    MOCK_FUNCTION(xrDestroyAction),
+    MOCK_FUNCTION(xrSuggestInteractionProfileBindings),
+    MOCK_FUNCTION(xrAttachSessionActionSets),
+    MOCK_FUNCTION(xrGetCurrentInteractionProfile),
+    MOCK_FUNCTION(xrSyncActions),
+    MOCK_FUNCTION(xrGetActionStateBoolean),
+    MOCK_FUNCTION(xrGetActionStateFloat),
+    MOCK_FUNCTION(xrGetActionStatePose),
+    MOCK_FUNCTION(xrEnumerateBoundSourcesForAction),
+    MOCK_FUNCTION(xrGetInputSourceLocalizedName),
+    MOCK_FUNCTION(xrApplyHapticFeedback),
+    MOCK_FUNCTION(xrStopHapticFeedback),
+};
+
+#undef MOCK_FUNCTION
+
+static XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance,
+                                                 const char *name,
+                                                 PFN_xrVoidFunction *function) {
+  auto found = FUNCTIONS.find(name);
+  if (found == FUNCTIONS.end()) {
+    *function = nullptr;
+    return XR_ERROR_FUNCTION_UNSUPPORTED;
+  }
+  *function = found->second;
+  return XR_SUCCESS;
+}
+
+} // namespace mock
+
+extern "C" MOCK_EXPORT XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(
+    const XrNegotiateLoaderInfo *loaderInfo,
+    XrNegotiateRuntimeRequest *runtimeRequest) {
+  if (!loaderInfo || !runtimeRequest ||
+      loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+      runtimeRequest->structType !=
+          XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST ||
+      loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+      loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION) {
+    return XR_ERROR_INITIALIZATION_FAILED;
+  }
+  runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+  runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+  runtimeRequest->getInstanceProcAddr = mock::xrGetInstanceProcAddr;
+  return XR_SUCCESS;
+}
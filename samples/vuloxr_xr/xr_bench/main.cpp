@@ -0,0 +1,190 @@
+//
+// headless XR frame loop benchmark. runs hello_xr's vulkan path against the
+// mock runtime (mock_runtime/). no headset, no window.
+//
+//   xr_bench [--frames N] [--period MS] [--size WxH] [--script FILE]
+//            [--report FILE.json] [--runtime FILE.json] [--device NAME]
+//            [--bvh FILE] [--crowd N]
+//
+// --bvh adds cuber_xr's scene: a crowd of N bvh skeletons (default 64) drawn
+// as one cube per joint. Crowd::Update runs on the frame thread each frame.
+//
+// the runtime measures the frame and prints at exit
+//
+//   frame      interval between xrEndFrame
+//   cpu        xrWaitFrame return => xrEndFrame of the same display time
+//   waitFrame  blocked in xrWaitFrame
+//   acquire    xrAcquireSwapchainImage => xrWaitSwapchainImage return
+//
+// --runtime selects another runtime json. the VULOXR_MOCK_ settings only work
+// with the mock.
+//
+#include "../../cuber/Bvh.h"
+#include "../../cuber/Crowd.h"
+#include "../../cuber/JobSystem.h"
+#include "../xr_main_loop.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vuloxr/xr.h>
+#include <vuloxr/xr/graphics/vulkan.h>
+#include <vuloxr/xr/session.h>
+
+struct Options {
+  uint32_t frames = 1000;
+  std::string period;
+  std::string size;
+  std::string script;
+  std::string report;
+  std::string runtime = MOCK_RUNTIME_JSON;
+  std::string device;
+  std::string bvh;
+  uint32_t crowd = 64;
+
+  bool parse(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto value = [&]() -> const char * {
+        return i + 1 < argc ? argv[++i] : "";
+      };
+      if (arg == "--frames") {
+        this->frames = std::max(1, atoi(value()));
+      } else if (arg == "--period") {
+        this->period = value();
+      } else if (arg == "--size") {
+        this->size = value();
+      } else if (arg == "--script") {
+        this->script = value();
+      } else if (arg == "--report") {
+        this->report = value();
+      } else if (arg == "--runtime") {
+        this->runtime = value();
+      } else if (arg == "--device") {
+        this->device = value();
+      } else if (arg == "--bvh") {
+        this->bvh = value();
+      } else if (arg == "--crowd") {
+        this->crowd = std::max(1, atoi(value()));
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+static void setEnv(const char *name, const std::string &value) {
+  if (value.empty()) {
+    return;
+  }
+#ifdef _WIN32
+  _putenv_s(name, value.c_str());
+#else
+  setenv(name, value.c_str(), 1);
+#endif
+}
+
+XrColor4f clearColor{0, 0.1f, 0, 0};
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!options.parse(argc, argv)) {
+    vuloxr::Logger::Error(
+        "usage: xr_bench [--frames N] [--period MS] [--size WxH] "
+        "[--script FILE] [--report FILE.json] [--runtime FILE.json] "
+        "[--device NAME] [--bvh FILE] [--crowd N]");
+    return 2;
+  }
+
+  Crowd crowd;
+  std::vector<cuber::Instance> instances;
+  std::unique_ptr<JobSystem> jobs;
+  if (!options.bvh.empty()) {
+    auto bvh = Bvh::ParseFile(options.bvh);
+    if (!bvh) {
+      vuloxr::Logger::Error("fail to load: %s", options.bvh.c_str());
+      return 1;
+    }
+    crowd.Initialize(bvh, options.crowd);
+    instances.resize(crowd.InstanceCount());
+    jobs = std::make_unique<JobSystem>();
+    printf("crowd      %u agents x %u joints\n", crowd.AgentCount(),
+           crowd.JointCount());
+
+    xr_scene_hook = [&crowd, &instances, &jobs, origin = XrTime(0)](
+                        XrTime displayTime,
+                        std::vector<DirectX::XMFLOAT4X4> &models) mutable {
+      if (origin == 0) {
+        origin = displayTime;
+      }
+      BvhTime time(static_cast<float>(displayTime - origin) / 1e9f);
+      crowd.Update(*jobs, time, instances);
+      for (auto &instance : instances) {
+        models.push_back(instance.Matrix);
+      }
+    };
+  }
+  // read by the loader and the runtime at xrCreateInstance
+  setEnv("XR_RUNTIME_JSON", options.runtime);
+  setEnv("VULOXR_MOCK_FRAMES", std::to_string(options.frames));
+  setEnv("VULOXR_MOCK_PERIOD_MS", options.period);
+  setEnv("VULOXR_MOCK_SIZE", options.size);
+  setEnv("VULOXR_MOCK_SCRIPT", options.script);
+  setEnv("VULOXR_MOCK_REPORT", options.report);
+  setEnv("VULOXR_MOCK_DEVICE", options.device);
+
+  vuloxr::xr::Instance xr_instance;
+  xr_instance.extensions.push_back(XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME);
+  auto depthLayer = xr_instance.enableIfSupported(
+      XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+  if (xr_instance.create(nullptr) != XR_SUCCESS) {
+    vuloxr::Logger::Error("no xr::Instance. runtime: %s",
+                          options.runtime.c_str());
+    return 1;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  {
+    auto [vulkan, binding] =
+        vuloxr::xr::createVulkan(xr_instance.instance, xr_instance.systemId);
+    {
+      vuloxr::xr::Session session(xr_instance.instance, xr_instance.systemId,
+                                  &binding);
+      XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{
+          .type = XR_TYPE_REFERENCE_SPACE_CREATE_INFO,
+          .next = 0,
+          .referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL,
+          .poseInReferenceSpace = {.orientation = {0, 0, 0, 1.0f},
+                                   .position = {0, 0, 0}},
+      };
+      XrSpace appSpace;
+      vuloxr::xr::CheckXrResult(xrCreateReferenceSpace(
+          session, &referenceSpaceCreateInfo, &appSpace));
+
+      // the runtime requests exit after --frames. the timeout is for a
+      // runtime that never does
+      auto timeout = std::chrono::seconds(30 + options.frames / 10);
+      xr_main_loop(
+          [start, timeout](bool isSessionRunning) {
+            if (Clock::now() - start > timeout) {
+              vuloxr::Logger::Error("xr_bench: timeout");
+              return false;
+            }
+            return true;
+          },
+          xr_instance.instance, xr_instance.systemId, session, appSpace,
+          session.formats, vulkan, clearColor, depthLayer);
+
+      vkDeviceWaitIdle(vulkan.device);
+      // session. the mock runtime reports here
+    }
+    // vulkan
+  }
+
+  printf("wall       %.3f s\n",
+         std::chrono::duration<double>(Clock::now() - start).count());
+  return 0;
+}
@@ -2,6 +2,7 @@
 #include <DirectXMath.h>
 #include <functional>
 #include <span>
+#include <vector>
 
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 #include <vuloxr/vk/swapchain.h>
@@ -83,18 +84,34 @@ struct InputData {
 
 struct ViewRenderer {
   struct Impl *_impl;
+  // depthSwapchain: XR_KHR_composition_layer_depth. render acquires and
+  // releases its image. nullptr for a private depth buffer
   ViewRenderer(const Graphics *_graphics,
-               const std::shared_ptr<GraphicsSwapchain> &swapchain);
+               const std::shared_ptr<GraphicsSwapchain> &swapchain,
+               const std::shared_ptr<GraphicsSwapchain> &depthSwapchain =
+                   nullptr);
   ~ViewRenderer();
   void initScene(const char *vs, const char *fs,
                  std::span<const VertexAttributeLayout> layouts,
                  const InputData &vertices, const InputData &indices = {});
   void initSwapchain(int width, int height,
                      std::span<const SwapchainImageType> images);
+  // models are the world matrices of the cubes. shared by the views
   void render(uint32_t index, const XrColor4f &clearColor,
-              std::span<const DirectX::XMFLOAT4X4> matrices = {});
+              const DirectX::XMFLOAT4X4 &viewProjection,
+              std::span<const DirectX::XMFLOAT4X4> models = {});
+  // gpu time of the latest measured render. 0 if not measured
+  double gpuMs() const;
+  // gpuMs is measured. dynamic resolution needs it
+  static bool measuresGpuTime();
 };
 
+// hello_xr. appends the world matrices of more cubes to the scene. called on
+// the frame thread with the predicted display time. xr_bench adds a crowd
+using SceneHook =
+    std::function<void(XrTime, std::vector<DirectX::XMFLOAT4X4> &)>;
+extern SceneHook xr_scene_hook;
+
 void xr_main_loop(
     const std::function<bool(bool)> &runLoop, XrInstance instance,
     XrSystemId systemId, XrSession session, XrSpace appSpace,
@@ -103,6 +120,8 @@ void xr_main_loop(
     const Graphics &graphics,
     //
     const XrColor4f &clearColor,
+    // XR_KHR_composition_layer_depth is enabled
+    bool depthLayer = false,
     XrEnvironmentBlendMode blendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE,
     XrViewConfigurationType viewConfigurationType =
         XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO);
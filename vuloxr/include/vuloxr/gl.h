@@ -1,4 +1,5 @@
 #pragma once
+#include <optional>
 
 namespace vuloxr {
 
@@ -102,6 +103,18 @@ struct DepthTexture : vuloxr::NonCopyable {
   void unbind() { glBindRenderbuffer(GL_RENDERBUFFER, 0); }
 };
 
+// GL_TEXTURE_2D_ARRAY for multiview
+struct DepthArrayTexture : vuloxr::NonCopyable {
+  uint32_t id;
+  DepthArrayTexture(int width, int height, int layers) {
+    glGenTextures(1, &this->id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, width, height,
+                   layers);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  }
+};
+
 struct FramebufferObject : vuloxr::NonCopyable {
   uint32_t id;
   FramebufferObject() { glGenFramebuffers(1, &this->id); }
@@ -118,17 +131,58 @@ struct FramebufferObject : vuloxr::NonCopyable {
     assert(stat == GL_FRAMEBUFFER_COMPLETE);
     unbind();
   }
+  // depth is a GL_TEXTURE_2D. from a depth swapchain
+  void attachDepthTexture(uint32_t depth_id) {
+    bind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                           depth_id, 0);
+    unbind();
+  }
+  // GL_OVR_multiview. color and depth are GL_TEXTURE_2D_ARRAY
+  void attachMultiview(uint32_t color_id, uint32_t depth_id,
+                       uint32_t numViews) {
+    bind();
+    glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                     color_id, 0, 0, numViews);
+    glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                     depth_id, 0, 0, numViews);
+    GLenum stat = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    assert(stat == GL_FRAMEBUFFER_COMPLETE);
+    unbind();
+  }
 };
 
 struct RenderTarget : vuloxr::NonCopyable {
-  DepthTexture depth;
+  // none with a depth swapchain
+  std::optional<DepthTexture> depth;
   FramebufferObject fbo;
+  uint32_t depthImage = 0;
 
   RenderTarget(uint32_t image_id, int width, int height)
-      : depth(width, height) {
-    fbo.attach(image_id, this->depth.id);
+      : depth(std::in_place, width, height) {
+    fbo.attach(image_id, this->depth->id);
     vuloxr::Logger::Info("SwapchainImage FBO:%d, TEXC:%d, TEXZ:%d, WH(%d, %d)",
-                         this->fbo.id, image_id, this->depth.id, width, height);
+                         this->fbo.id, image_id, this->depth->id, width,
+                         height);
+  }
+
+  // the depth comes from a depth swapchain. attachDepth before beginFrame
+  RenderTarget(uint32_t image_id, uint32_t depth_image_id, int width,
+               int height) {
+    fbo.attach(image_id, 0);
+    attachDepth(depth_image_id);
+    vuloxr::Logger::Info("SwapchainImage FBO:%d, TEXC:%d, TEXZ(swapchain):%d, "
+                         "WH(%d, %d)",
+                         this->fbo.id, image_id, depth_image_id, width,
+                         height);
+  }
+
+  // the acquired image of the depth swapchain
+  void attachDepth(uint32_t depth_image_id) {
+    if (depth_image_id != this->depthImage) {
+      this->fbo.attachDepthTexture(depth_image_id);
+      this->depthImage = depth_image_id;
+    }
   }
 
   void beginFrame(int width, int height, const XrColor4f &clearColor) {
@@ -146,6 +200,21 @@ struct RenderTarget : vuloxr::NonCopyable {
   void endFrame() { this->fbo.unbind(); }
 };
 
+// render all layers of an array swapchain image in one pass
+struct MultiviewRenderTarget : vuloxr::NonCopyable {
+  DepthArrayTexture depth;
+  FramebufferObject fbo;
+
+  MultiviewRenderTarget(uint32_t image_id, int width, int height,
+                        uint32_t numViews = 2)
+      : depth(width, height, numViews) {
+    fbo.attachMultiview(image_id, this->depth.id, numViews);
+    vuloxr::Logger::Info(
+        "SwapchainImage(multiview) FBO:%d, TEXC:%d, TEXZ:%d, WH(%d, %d)",
+        this->fbo.id, image_id, this->depth.id, width, height);
+  }
+};
+
 struct Vbo {
   uint32_t id;
   uint32_t drawCount = 0;
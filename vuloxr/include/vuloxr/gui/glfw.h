@@ -126,8 +126,9 @@ public:
     vk::Device device;
     device.layers = instance.layers;
     device.addExtension(*physicalDevice, "VK_KHR_swapchain");
-    vk::CheckVkResult(device.create(instance, *physicalDevice,
-                                    physicalDevice->graphicsFamilyIndex));
+    vk::CheckVkResult(device.create(
+        instance, *physicalDevice, physicalDevice->graphicsFamilyIndex,
+        physicalDevice->getDedicatedTransferQueueFamily().value_or(UINT_MAX)));
 
     vk::Swapchain swapchain(instance, surface, *physicalDevice,
                             *presentFamilyIndex, device, device.queueFamily);
@@ -1,9 +1,11 @@
 #pragma once
 #include "../vuloxr.h"
+#include "vk/allocator.h"
 #include <assert.h>
 #include <chrono>
 #include <climits>
 #include <cstdint>
+#include <cstring>
 #include <list>
 #include <magic_enum/magic_enum.hpp>
 #include <span>
@@ -95,26 +97,44 @@ inline VkDeviceMemory createBindMemory(VkDevice device, uint32_t reqSize,
 struct Memory : NonCopyable {
   VkDevice device = VK_NULL_HANDLE;
   VkDeviceMemory memory = VK_NULL_HANDLE;
+  // sub allocated from a MemoryAllocator block if allocator is not null
+  MemoryAllocator *allocator = nullptr;
+  SubAllocation allocation;
+  VkDeviceSize offset() const { return this->allocation.offset; }
   Memory() = default;
   Memory(VkDevice _device, VkDeviceMemory _memory = VK_NULL_HANDLE)
       : device(_device), memory(_memory) {}
+  Memory(VkDevice _device, MemoryAllocator *_allocator,
+         const SubAllocation &_allocation)
+      : device(_device), memory(_allocation.memory), allocator(_allocator),
+        allocation(_allocation) {}
   ~Memory() { release(); }
   Memory(Memory &&rhs) {
     release();
     this->memory = rhs.memory;
     rhs.memory = VK_NULL_HANDLE;
     this->device = rhs.device;
+    this->allocator = rhs.allocator;
+    this->allocation = rhs.allocation;
   }
   Memory &operator=(Memory &&rhs) {
     release();
     this->memory = rhs.memory;
     rhs.memory = VK_NULL_HANDLE;
     this->device = rhs.device;
+    this->allocator = rhs.allocator;
+    this->allocation = rhs.allocation;
     return *this;
   }
   void mapWrite(const void *src, uint32_t srcSize) const {
+    if (this->allocation.mapped) {
+      // persistently mapped block. HOST_COHERENT
+      memcpy(this->allocation.mapped, src, srcSize);
+      return;
+    }
     void *dst;
-    CheckVkResult(vkMapMemory(device, memory, 0, srcSize, 0, &dst));
+    CheckVkResult(
+        vkMapMemory(device, memory, this->offset(), srcSize, 0, &dst));
     memcpy(dst, src, srcSize);
     vkUnmapMemory(device, memory);
   }
@@ -122,7 +142,11 @@ struct Memory : NonCopyable {
 private:
   void release() {
     if (this->memory != VK_NULL_HANDLE) {
-      vkFreeMemory(this->device, this->memory, nullptr);
+      if (this->allocator) {
+        this->allocator->free(this->allocation);
+      } else {
+        vkFreeMemory(this->device, this->memory, nullptr);
+      }
       this->memory = VK_NULL_HANDLE;
     }
   }
@@ -138,6 +162,9 @@ struct PhysicalDevice {
   std::vector<VkQueueFamilyProperties> queueFamilyProperties;
   uint32_t graphicsFamilyIndex = UINT_MAX;
   VkPhysicalDeviceMemoryProperties memoryProps = {};
+  // allocFor* sub allocate from this if set. one vkAllocateMemory per resource
+  // otherwise
+  MemoryAllocator *allocator = nullptr;
 
   PhysicalDevice() {}
   PhysicalDevice(VkPhysicalDevice _physicalDevice)
@@ -180,6 +207,18 @@ struct PhysicalDevice {
     return false;
   }
 
+  // a transfer (DMA) family without graphics and compute. async uploads
+  std::optional<uint32_t> getDedicatedTransferQueueFamily() const {
+    for (uint32_t i = 0; i < this->queueFamilyProperties.size(); ++i) {
+      auto flags = this->queueFamilyProperties[i].queueFlags;
+      if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+          !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+        return i;
+      }
+    }
+    return {};
+  }
+
   std::optional<uint32_t>
   getFirstPresentQueueFamily(VkSurfaceKHR surface) const {
     for (uint32_t i = 0; i < this->queueFamilyProperties.size(); ++i) {
@@ -260,6 +299,11 @@ struct PhysicalDevice {
                                   // for map
                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (this->allocator) {
+      auto sub = this->allocator->allocate(memoryRequirements, typeIndex, false);
+      CheckVkResult(vkBindBufferMemory(device, buffer, sub.memory, sub.offset));
+      return {device, this->allocator, sub};
+    }
     auto memory = createBindMemory(device, requiredSize, typeIndex);
     // bind
     vkBindBufferMemory(device, buffer, memory, 0);
@@ -274,6 +318,11 @@ struct PhysicalDevice {
         this->findMemoryTypeIndex(device, memoryRequirements,
                                   // for map
                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (this->allocator) {
+      auto sub = this->allocator->allocate(memoryRequirements, typeIndex, false);
+      CheckVkResult(vkBindBufferMemory(device, buffer, sub.memory, sub.offset));
+      return {device, this->allocator, sub};
+    }
     auto memory = createBindMemory(device, requiredSize, typeIndex);
     // bind
     vkBindBufferMemory(device, buffer, memory, 0);
@@ -288,6 +337,12 @@ struct PhysicalDevice {
         this->findMemoryTypeIndex(device, memoryRequirements,
                                   // for copy command
                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (this->allocator) {
+      // optimal tiling. kept apart from buffers (bufferImageGranularity)
+      auto sub = this->allocator->allocate(memoryRequirements, typeIndex, true);
+      CheckVkResult(vkBindImageMemory(device, image, sub.memory, sub.offset));
+      return {device, this->allocator, sub};
+    }
     auto memory = createBindMemory(device, requiredSize, typeIndex);
     // bind
     vkBindImageMemory(device, image, memory, 0);
@@ -592,8 +647,73 @@ struct Instance : NonCopyable {
     }
     return {picked, presentFamily};
   }
+
+  // without a surface. the first device whose name contains nameFilter
+  // (e.g. "llvmpipe" for lavapipe), or the first device with a graphics queue
+  const PhysicalDevice *
+  pickHeadlessPhysicalDevice(const char *nameFilter = nullptr) const {
+    const PhysicalDevice *picked = nullptr;
+    for (auto &physicalDevice : this->physicalDevices) {
+      Logger::Info("[%s]", physicalDevice.properties.deviceName);
+      if (physicalDevice.graphicsFamilyIndex == UINT_MAX) {
+        continue;
+      }
+      if (nameFilter && *nameFilter) {
+        if (strstr(physicalDevice.properties.deviceName, nameFilter)) {
+          return &physicalDevice;
+        }
+      } else if (!picked) {
+        picked = &physicalDevice;
+      }
+    }
+    return picked;
+  }
 };
 
+// core in vulkan 1.2. fill enabled with the features that a bindless
+// sampled image array needs and return true if all of them are supported
+inline bool getDescriptorIndexingFeatures(
+    VkInstance instance, VkPhysicalDevice physicalDevice,
+    VkPhysicalDeviceDescriptorIndexingFeatures *enabled) {
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  if (properties.apiVersion < VK_API_VERSION_1_2) {
+    return false;
+  }
+  auto f_vkGetPhysicalDeviceFeatures2 =
+      (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(
+          instance, "vkGetPhysicalDeviceFeatures2");
+  if (!f_vkGetPhysicalDeviceFeatures2) {
+    return false;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeatures supported{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+  };
+  VkPhysicalDeviceFeatures2 features2{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext = &supported,
+  };
+  f_vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+  if (!supported.shaderSampledImageArrayNonUniformIndexing ||
+      !supported.descriptorBindingSampledImageUpdateAfterBind ||
+      !supported.descriptorBindingUpdateUnusedWhilePending ||
+      !supported.descriptorBindingPartiallyBound ||
+      !supported.runtimeDescriptorArray) {
+    return false;
+  }
+
+  *enabled = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+      .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+      .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+      .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+      .descriptorBindingPartiallyBound = VK_TRUE,
+      .runtimeDescriptorArray = VK_TRUE,
+  };
+  return true;
+}
+
 struct Device : NonCopyable {
   std::vector<const char *> layers;
 
@@ -612,6 +732,13 @@ struct Device : NonCopyable {
   operator VkDevice() const { return this->device; }
   uint32_t queueFamily = UINT_MAX;
   VkQueue queue = VK_NULL_HANDLE;
+  // same as queue if the device has no dedicated transfer queue
+  uint32_t transferQueueFamily = UINT_MAX;
+  VkQueue transferQueue = VK_NULL_HANDLE;
+  // not owned. PipelineBuilder passes this to vkCreateGraphicsPipelines
+  VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+  // descriptor indexing features for BindlessTextureTable are enabled
+  bool descriptorIndexing = false;
 
   Device() {}
   ~Device() {
@@ -621,33 +748,56 @@ struct Device : NonCopyable {
     }
   }
   Device(Device &&rhs) {
-    reset(rhs.device, rhs.queueFamily);
+    reset(rhs.device, rhs.queueFamily, rhs.transferQueueFamily);
+    this->pipelineCache = rhs.pipelineCache;
+    this->descriptorIndexing = rhs.descriptorIndexing;
     rhs.device = VK_NULL_HANDLE;
   }
   Device &operator=(Device &&rhs) {
-    reset(rhs.device, rhs.queueFamily);
+    reset(rhs.device, rhs.queueFamily, rhs.transferQueueFamily);
+    this->pipelineCache = rhs.pipelineCache;
+    this->descriptorIndexing = rhs.descriptorIndexing;
     rhs.device = VK_NULL_HANDLE;
     return *this;
   }
 
-  // Create Logical Device (with 1 queue)
+  // Create Logical Device (with 1 queue, and 1 transfer queue if
+  // transferQueueFamily is a different family)
   VkResult create(VkInstance instance, const VkPhysicalDevice physicalDevice,
-                  uint32_t queueFamily) {
+                  uint32_t queueFamily,
+                  uint32_t transferQueueFamily = UINT_MAX) {
     const float queue_priority[] = {1.0f};
-    VkDeviceQueueCreateInfo queue_info[1] = {};
+    VkDeviceQueueCreateInfo queue_info[2] = {};
     queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queue_info[0].queueFamilyIndex = queueFamily;
     queue_info[0].queueCount = 1;
     queue_info[0].pQueuePriorities = queue_priority;
+    if (transferQueueFamily == UINT_MAX) {
+      transferQueueFamily = queueFamily;
+    }
+    queue_info[1] = queue_info[0];
+    queue_info[1].queueFamilyIndex = transferQueueFamily;
+    VkPhysicalDeviceFeatures supported;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supported);
     VkPhysicalDeviceFeatures features{
         .samplerAnisotropy = VK_TRUE,
+        // for GpuProfiler
+        .pipelineStatisticsQuery = supported.pipelineStatisticsQuery,
+    };
+    // for BindlessTextureTable
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing{
+        .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
     };
+    this->descriptorIndexing =
+        getDescriptorIndexingFeatures(instance, physicalDevice, &indexing);
     VkDeviceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = this->descriptorIndexing ? &indexing : nullptr,
         .pEnabledFeatures = &features,
     };
     create_info.queueCreateInfoCount =
-        sizeof(queue_info) / sizeof(queue_info[0]);
+        transferQueueFamily != queueFamily ? 2 : 1;
     create_info.pQueueCreateInfos = queue_info;
 
     for (auto name : this->extensions) {
@@ -661,16 +811,22 @@ struct Device : NonCopyable {
     CheckVkResult(
         vkCreateDevice(physicalDevice, &create_info, nullptr, &device));
 
-    reset(device, queueFamily);
+    reset(device, queueFamily, transferQueueFamily);
 
     return VK_SUCCESS;
   }
 
-  void reset(VkDevice _device, uint32_t _quemeFamily) {
+  void reset(VkDevice _device, uint32_t _quemeFamily,
+             uint32_t _transferQueueFamily = UINT_MAX) {
     assert(this->device == VK_NULL_HANDLE);
     this->device = _device;
     this->queueFamily = _quemeFamily;
     vkGetDeviceQueue(this->device, this->queueFamily, 0, &this->queue);
+    this->transferQueueFamily = _transferQueueFamily == UINT_MAX
+                                    ? _quemeFamily
+                                    : _transferQueueFamily;
+    vkGetDeviceQueue(this->device, this->transferQueueFamily, 0,
+                     &this->transferQueue);
   }
 
   VkResult submit(VkCommandBuffer cmd,
@@ -0,0 +1,561 @@
+#pragma once
+#include "../../vuloxr.h"
+#include <algorithm>
+#include <assert.h>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace vuloxr {
+
+namespace vk {
+
+inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+enum class AllocationStrategy {
+  // bump pointer. the block is reset when every allocation is freed.
+  // for resources that are released together (per scene, per level)
+  Linear,
+  // two level segregated fit. O(1) allocate / free with coalescing
+  Tlsf,
+};
+
+// offsets of a linear block
+struct LinearMetadata {
+  VkDeviceSize size;
+  VkDeviceSize head = 0;
+  uint32_t live = 0;
+
+  LinearMetadata(VkDeviceSize _size) : size(_size) {}
+
+  std::optional<VkDeviceSize> allocate(VkDeviceSize allocSize,
+                                       VkDeviceSize alignment) {
+    auto offset = alignUp(this->head, alignment);
+    if (offset + allocSize > this->size) {
+      return {};
+    }
+    this->head = offset + allocSize;
+    ++this->live;
+    return offset;
+  }
+
+  void free() {
+    if (--this->live == 0) {
+      this->head = 0;
+    }
+  }
+};
+
+// offsets of a tlsf block
+//
+// http://www.gii.upv.es/tlsf/
+// first level: power of two. second level: 16 linear subdivisions.
+struct TlsfMetadata {
+  static constexpr uint32_t SL_BITS = 4;
+  static constexpr uint32_t SL_COUNT = 1 << SL_BITS;
+  // sizes below SMALL_SIZE share the first level 0
+  static constexpr uint32_t SMALL_SHIFT = 8;
+  static constexpr VkDeviceSize SMALL_SIZE = 1 << SMALL_SHIFT;
+  static constexpr uint32_t FL_COUNT = 64 - SMALL_SHIFT + 1;
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct Node {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint32_t prevPhysical = NONE;
+    uint32_t nextPhysical = NONE;
+    uint32_t prevFree = NONE;
+    uint32_t nextFree = NONE;
+    bool free = false;
+  };
+
+  VkDeviceSize size;
+  std::vector<Node> nodes;
+  std::vector<uint32_t> unusedNodes;
+  uint64_t flBitmap = 0;
+  uint32_t slBitmap[FL_COUNT] = {};
+  uint32_t heads[FL_COUNT][SL_COUNT];
+
+  TlsfMetadata(VkDeviceSize _size) : size(_size) {
+    for (auto &fl : this->heads) {
+      std::fill(std::begin(fl), std::end(fl), NONE);
+    }
+    insertFree(newNode({.offset = 0, .size = _size}));
+  }
+
+  static std::pair<uint32_t, uint32_t> mapping(VkDeviceSize value) {
+    if (value < SMALL_SIZE) {
+      return {0, static_cast<uint32_t>(value / (SMALL_SIZE / SL_COUNT))};
+    }
+    auto f = static_cast<uint32_t>(std::bit_width(value) - 1);
+    auto sl = static_cast<uint32_t>(value >> (f - SL_BITS)) ^ SL_COUNT;
+    return {f - SMALL_SHIFT + 1, sl};
+  }
+
+  // round up so that any block of the found list is large enough
+  static std::pair<uint32_t, uint32_t> mappingSearch(VkDeviceSize value) {
+    if (value < SMALL_SIZE) {
+      value = alignUp(value, SMALL_SIZE / SL_COUNT);
+    } else {
+      auto f = std::bit_width(value) - 1;
+      value += (VkDeviceSize(1) << (f - SL_BITS)) - 1;
+    }
+    return mapping(value);
+  }
+
+  // offset and node (the handle for free)
+  std::optional<std::pair<VkDeviceSize, uint32_t>>
+  allocate(VkDeviceSize allocSize, VkDeviceSize alignment) {
+    // a block of size + alignment - 1 always fits after aligning the offset
+    auto index = findFree(allocSize + alignment - 1);
+    if (index == NONE) {
+      return {};
+    }
+    removeFree(index);
+
+    // front padding goes back to the free lists
+    auto offset = alignUp(this->nodes[index].offset, alignment);
+    auto padding = offset - this->nodes[index].offset;
+    if (padding > 0) {
+      auto front = split(index, padding);
+      std::swap(front, index);
+      insertFree(front);
+    }
+    if (this->nodes[index].size > allocSize) {
+      insertFree(split(index, allocSize));
+    }
+    this->nodes[index].free = false;
+    return std::make_pair(offset, index);
+  }
+
+  void free(uint32_t index) {
+    auto &node = this->nodes[index];
+    assert(!node.free);
+    // coalesce with physical neighbours
+    if (node.prevPhysical != NONE && this->nodes[node.prevPhysical].free) {
+      auto prev = node.prevPhysical;
+      removeFree(prev);
+      index = merge(prev, index);
+    }
+    auto next = this->nodes[index].nextPhysical;
+    if (next != NONE && this->nodes[next].free) {
+      removeFree(next);
+      index = merge(index, next);
+    }
+    insertFree(index);
+  }
+
+private:
+  uint32_t newNode(const Node &node) {
+    if (this->unusedNodes.empty()) {
+      this->nodes.push_back(node);
+      return static_cast<uint32_t>(this->nodes.size() - 1);
+    }
+    auto index = this->unusedNodes.back();
+    this->unusedNodes.pop_back();
+    this->nodes[index] = node;
+    return index;
+  }
+
+  // [index: head][return: rest]
+  uint32_t split(uint32_t index, VkDeviceSize headSize) {
+    auto &node = this->nodes[index];
+    auto rest = newNode({
+        .offset = node.offset + headSize,
+        .size = node.size - headSize,
+        .prevPhysical = index,
+        .nextPhysical = node.nextPhysical,
+    });
+    // newNode may reallocate nodes
+    auto &head = this->nodes[index];
+    if (head.nextPhysical != NONE) {
+      this->nodes[head.nextPhysical].prevPhysical = rest;
+    }
+    head.nextPhysical = rest;
+    head.size = headSize;
+    return rest;
+  }
+
+  // [front][back] => [front]
+  uint32_t merge(uint32_t front, uint32_t back) {
+    auto &f = this->nodes[front];
+    auto &b = this->nodes[back];
+    f.size += b.size;
+    f.nextPhysical = b.nextPhysical;
+    if (f.nextPhysical != NONE) {
+      this->nodes[f.nextPhysical].prevPhysical = front;
+    }
+    this->unusedNodes.push_back(back);
+    return front;
+  }
+
+  void insertFree(uint32_t index) {
+    auto &node = this->nodes[index];
+    auto [fl, sl] = mapping(node.size);
+    node.free = true;
+    node.prevFree = NONE;
+    node.nextFree = this->heads[fl][sl];
+    if (node.nextFree != NONE) {
+      this->nodes[node.nextFree].prevFree = index;
+    }
+    this->heads[fl][sl] = index;
+    this->flBitmap |= 1ull << fl;
+    this->slBitmap[fl] |= 1u << sl;
+  }
+
+  void removeFree(uint32_t index) {
+    auto &node = this->nodes[index];
+    auto [fl, sl] = mapping(node.size);
+    if (node.prevFree != NONE) {
+      this->nodes[node.prevFree].nextFree = node.nextFree;
+    } else {
+      this->heads[fl][sl] = node.nextFree;
+      if (this->heads[fl][sl] == NONE) {
+        this->slBitmap[fl] &= ~(1u << sl);
+        if (this->slBitmap[fl] == 0) {
+          this->flBitmap &= ~(1ull << fl);
+        }
+      }
+    }
+    if (node.nextFree != NONE) {
+      this->nodes[node.nextFree].prevFree = node.prevFree;
+    }
+    node.free = false;
+  }
+
+  uint32_t findFree(VkDeviceSize value) {
+    if (value > this->size) {
+      return NONE;
+    }
+    auto [fl, sl] = mappingSearch(value);
+    if (fl >= FL_COUNT) {
+      return NONE;
+    }
+    auto slMap = sl < SL_COUNT ? this->slBitmap[fl] & (~0u << sl) : 0;
+    if (slMap == 0) {
+      auto flMap =
+          fl + 1 < 64 ? this->flBitmap & (~0ull << (fl + 1)) : uint64_t(0);
+      if (flMap == 0) {
+        return NONE;
+      }
+      fl = std::countr_zero(flMap);
+      slMap = this->slBitmap[fl];
+    }
+    sl = std::countr_zero(slMap);
+    return this->heads[fl][sl];
+  }
+};
+
+// a range of a VkDeviceMemory owned by MemoryAllocator
+struct SubAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  // persistently mapped if host visible. nullptr otherwise
+  void *mapped = nullptr;
+  // block index in the pool. NONE for a dedicated allocation
+  uint32_t pool = 0;
+  uint32_t block = 0;
+  uint32_t node = 0;
+};
+
+//
+// Carve resources out of large VkDeviceMemory blocks instead of one
+// vkAllocateMemory per resource.
+//
+// - one pool of blocks per memory type and resource kind. buffers and optimal
+//   images never share a block, so bufferImageGranularity always holds.
+// - host visible blocks are mapped once and stay mapped
+//   (a VkDeviceMemory can not be mapped twice).
+// - allocations larger than half a block get a dedicated VkDeviceMemory.
+//
+struct MemoryAllocator : NonCopyable {
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void *mapped = nullptr;
+    VkDeviceSize used = 0;
+    uint32_t allocationCount = 0;
+    std::unique_ptr<LinearMetadata> linear;
+    std::unique_ptr<TlsfMetadata> tlsf;
+  };
+
+  struct Pool {
+    uint32_t memoryTypeIndex;
+    bool image;
+    AllocationStrategy strategy;
+    std::vector<Block> blocks;
+  };
+
+  struct Stats {
+    uint32_t vkAllocateMemoryCount = 0;
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize usedBytes = 0;
+    VkDeviceSize dedicatedBytes = 0;
+  };
+
+  VkDevice device;
+  VkPhysicalDeviceMemoryProperties memoryProps;
+  VkDeviceSize bufferImageGranularity;
+  uint32_t maxMemoryAllocationCount;
+  VkDeviceSize blockSize;
+  AllocationStrategy strategy;
+  std::mutex mutex;
+  std::vector<Pool> pools;
+  uint32_t dedicatedCount = 0;
+  VkDeviceSize dedicatedBytes = 0;
+
+  MemoryAllocator(VkDevice _device,
+                  const VkPhysicalDeviceMemoryProperties &_memoryProps,
+                  const VkPhysicalDeviceLimits &limits,
+                  VkDeviceSize _blockSize = 64 * 1024 * 1024,
+                  AllocationStrategy _strategy = AllocationStrategy::Tlsf)
+      : device(_device), memoryProps(_memoryProps),
+        bufferImageGranularity(limits.bufferImageGranularity),
+        maxMemoryAllocationCount(limits.maxMemoryAllocationCount),
+        blockSize(_blockSize), strategy(_strategy) {}
+
+  ~MemoryAllocator() {
+    for (auto &pool : this->pools) {
+      for (auto &block : pool.blocks) {
+        if (block.allocationCount) {
+          Logger::Warn("[MemoryAllocator] %d allocations leaked",
+                       block.allocationCount);
+        }
+        releaseBlock(block);
+      }
+    }
+  }
+
+  // image: optimal tiling image. kept apart from buffers and linear images
+  SubAllocation allocate(const VkMemoryRequirements &requirements,
+                         uint32_t memoryTypeIndex, bool image) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (requirements.size > this->blockSize / 2) {
+      auto memory = allocateMemory(requirements.size, memoryTypeIndex);
+      ++this->dedicatedCount;
+      this->dedicatedBytes += requirements.size;
+      return {
+          .memory = memory,
+          .offset = 0,
+          .size = requirements.size,
+          .mapped = map(memory, memoryTypeIndex),
+          .pool = NONE,
+      };
+    }
+
+    auto poolIndex = getOrCreatePool(memoryTypeIndex, image);
+    auto &pool = this->pools[poolIndex];
+    for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+      if (auto sub = allocateFromBlock(pool.blocks[i], requirements)) {
+        sub->pool = poolIndex;
+        sub->block = i;
+        return *sub;
+      }
+    }
+
+    // reuse a released block slot
+    uint32_t i = 0;
+    for (; i < pool.blocks.size(); ++i) {
+      if (pool.blocks[i].memory == VK_NULL_HANDLE) {
+        break;
+      }
+    }
+    if (i == pool.blocks.size()) {
+      pool.blocks.push_back({});
+    }
+    auto &block = pool.blocks[i];
+    block.memory = allocateMemory(this->blockSize, memoryTypeIndex);
+    block.size = this->blockSize;
+    block.mapped = map(block.memory, memoryTypeIndex);
+    if (pool.strategy == AllocationStrategy::Linear) {
+      block.linear = std::make_unique<LinearMetadata>(block.size);
+    } else {
+      block.tlsf = std::make_unique<TlsfMetadata>(block.size);
+    }
+    auto sub = allocateFromBlock(block, requirements);
+    assert(sub);
+    sub->pool = poolIndex;
+    sub->block = i;
+    return *sub;
+  }
+
+  void free(const SubAllocation &sub) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (sub.pool == NONE) {
+      vkFreeMemory(this->device, sub.memory, nullptr);
+      --this->dedicatedCount;
+      this->dedicatedBytes -= sub.size;
+      return;
+    }
+
+    auto &pool = this->pools[sub.pool];
+    auto &block = pool.blocks[sub.block];
+    if (block.linear) {
+      block.linear->free();
+    } else {
+      block.tlsf->free(sub.node);
+    }
+    block.used -= sub.size;
+    if (--block.allocationCount == 0) {
+      // keep one empty block per pool to avoid vkAllocateMemory ping pong
+      auto empty = std::count_if(
+          pool.blocks.begin(), pool.blocks.end(), [](const Block &b) {
+            return b.memory != VK_NULL_HANDLE && b.allocationCount == 0;
+          });
+      if (empty > 1) {
+        releaseBlock(block);
+      }
+    }
+  }
+
+  Stats stats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Stats stats{
+        .dedicatedCount = this->dedicatedCount,
+        .dedicatedBytes = this->dedicatedBytes,
+    };
+    for (auto &pool : this->pools) {
+      for (auto &block : pool.blocks) {
+        if (block.memory != VK_NULL_HANDLE) {
+          ++stats.blockCount;
+          stats.blockBytes += block.size;
+          stats.usedBytes += block.used;
+          stats.allocationCount += block.allocationCount;
+        }
+      }
+    }
+    stats.vkAllocateMemoryCount = stats.blockCount + stats.dedicatedCount;
+    return stats;
+  }
+
+  void dumpStats() {
+    auto s = stats();
+    Logger::Info("[MemoryAllocator] vkAllocateMemory: %d / %d", //
+                 s.vkAllocateMemoryCount, this->maxMemoryAllocationCount);
+    Logger::Info("  blocks: %d, %llu KB, %d allocations, %llu KB used (%.1f%%)",
+                 s.blockCount, (unsigned long long)s.blockBytes / 1024,
+                 s.allocationCount, (unsigned long long)s.usedBytes / 1024,
+                 s.blockBytes ? 100.0 * s.usedBytes / s.blockBytes : 0.0);
+    Logger::Info("  dedicated: %d, %llu KB", s.dedicatedCount,
+                 (unsigned long long)s.dedicatedBytes / 1024);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto &pool : this->pools) {
+      for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+        auto &block = pool.blocks[i];
+        if (block.memory == VK_NULL_HANDLE) {
+          continue;
+        }
+        Logger::Info("  [type %d%s][%d] %d allocations, %llu / %llu KB",
+                     pool.memoryTypeIndex, pool.image ? ",image" : "", i,
+                     block.allocationCount,
+                     (unsigned long long)block.used / 1024,
+                     (unsigned long long)block.size / 1024);
+      }
+    }
+  }
+
+private:
+  VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryTypeIndex) {
+    VkMemoryAllocateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryTypeIndex,
+    };
+    VkDeviceMemory memory;
+    auto result = vkAllocateMemory(this->device, &info, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+      Throw(fmt("vkAllocateMemory: %d", result), "MemoryAllocator");
+    }
+    return memory;
+  }
+
+  void *map(VkDeviceMemory memory, uint32_t memoryTypeIndex) {
+    if (!(this->memoryProps.memoryTypes[memoryTypeIndex].propertyFlags &
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+      return nullptr;
+    }
+    void *mapped;
+    auto result =
+        vkMapMemory(this->device, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+    if (result != VK_SUCCESS) {
+      Throw(fmt("vkMapMemory: %d", result), "MemoryAllocator");
+    }
+    return mapped;
+  }
+
+  void releaseBlock(Block &block) {
+    if (block.memory != VK_NULL_HANDLE) {
+      // vkFreeMemory unmaps
+      vkFreeMemory(this->device, block.memory, nullptr);
+    }
+    block = {};
+  }
+
+  uint32_t getOrCreatePool(uint32_t memoryTypeIndex, bool image) {
+    // with granularity 1 buffers and images can be neighbours
+    if (this->bufferImageGranularity <= 1) {
+      image = false;
+    }
+    for (uint32_t i = 0; i < this->pools.size(); ++i) {
+      if (this->pools[i].memoryTypeIndex == memoryTypeIndex &&
+          this->pools[i].image == image) {
+        return i;
+      }
+    }
+    this->pools.push_back({
+        .memoryTypeIndex = memoryTypeIndex,
+        .image = image,
+        .strategy = this->strategy,
+    });
+    return static_cast<uint32_t>(this->pools.size() - 1);
+  }
+
+  std::optional<SubAllocation>
+  allocateFromBlock(Block &block, const VkMemoryRequirements &requirements) {
+    if (block.memory == VK_NULL_HANDLE) {
+      return {};
+    }
+    SubAllocation sub{
+        .memory = block.memory,
+        .size = requirements.size,
+    };
+    if (block.linear) {
+      auto offset =
+          block.linear->allocate(requirements.size, requirements.alignment);
+      if (!offset) {
+        return {};
+      }
+      sub.offset = *offset;
+    } else {
+      auto found =
+          block.tlsf->allocate(requirements.size, requirements.alignment);
+      if (!found) {
+        return {};
+      }
+      sub.offset = found->first;
+      sub.node = found->second;
+    }
+    if (block.mapped) {
+      sub.mapped = (uint8_t *)block.mapped + sub.offset;
+    }
+    block.used += requirements.size;
+    ++block.allocationCount;
+    return sub;
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
@@ -38,6 +38,9 @@ struct Buffer : NonCopyable {
     rhs.buffer = VK_NULL_HANDLE;
   }
   Buffer &operator=(Buffer &&rhs) {
+    if (this->buffer != VK_NULL_HANDLE) {
+      vkDestroyBuffer(this->device, this->buffer, nullptr);
+    }
     this->device = rhs.device;
     this->buffer = rhs.buffer;
     rhs.buffer = VK_NULL_HANDLE;
@@ -63,6 +66,65 @@ template <typename T> struct UniformBuffer : NonCopyable {
   void mapWrite() const { this->memory.mapWrite(&this->value, sizeof(T)); }
 };
 
+// One persistently mapped, host coherent buffer of sliceCount slices of T.
+// Bind it once as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC and select the
+// slice of the frame in flight with a dynamic offset:
+//
+//   auto offset = ring.write(frameIndex, value);
+//   vkCmdBindDescriptorSets(..., 1, &offset);
+template <typename T> struct UniformRing : NonCopyable {
+  VkDevice device;
+  // minUniformBufferOffsetAlignment
+  uint32_t stride;
+  uint32_t sliceCount;
+  Buffer buffer;
+  Memory memory;
+  uint8_t *mapped = nullptr;
+  VkDescriptorBufferInfo info{
+      // .buffer = ring->buffer,
+      .offset = 0,
+      .range = sizeof(T),
+  };
+
+  UniformRing(const PhysicalDevice &physicalDevice, VkDevice _device,
+              uint32_t _sliceCount)
+      : device(_device),
+        stride(static_cast<uint32_t>(alignUp(
+            sizeof(T),
+            physicalDevice.properties.limits.minUniformBufferOffsetAlignment))),
+        sliceCount(_sliceCount),
+        buffer(_device, stride * _sliceCount,
+               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+    this->memory = physicalDevice.allocForMap(device, this->buffer);
+    if (this->memory.allocation.mapped) {
+      // sub allocated from a mapped block
+      this->mapped = (uint8_t *)this->memory.allocation.mapped;
+    } else {
+      CheckVkResult(vkMapMemory(this->device, this->memory.memory,
+                                this->memory.offset(), VK_WHOLE_SIZE, 0,
+                                (void **)&this->mapped));
+    }
+    this->info.buffer = this->buffer;
+  }
+
+  ~UniformRing() {
+    if (this->mapped && !this->memory.allocation.mapped) {
+      vkUnmapMemory(this->device, this->memory.memory);
+    }
+  }
+
+  uint32_t dynamicOffset(uint32_t slice) const {
+    return (slice % this->sliceCount) * this->stride;
+  }
+
+  // the gpu must have finished the frame that used this slice
+  uint32_t write(uint32_t slice, const T &value) {
+    auto offset = dynamicOffset(slice);
+    memcpy(this->mapped + offset, &value, sizeof(T));
+    return offset;
+  }
+};
+
 struct VertexBuffer : NonCopyable {
   std::vector<VkVertexInputBindingDescription> bindings;
   std::vector<VkVertexInputAttributeDescription> attributes;
@@ -1,5 +1,7 @@
 #pragma once
 #include "../vk.h"
+#include <chrono>
+#include <functional>
 
 namespace vuloxr {
 
@@ -274,5 +276,227 @@ struct CommandScope : NonCopyable {
   }
 };
 
+// one of the frames in flight
+struct FrameContext {
+  uint32_t index = 0;
+  uint64_t frameNumber = 0;
+  VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+  VkFence submitFence = VK_NULL_HANDLE;
+  // signaled by vkAcquireNextImageKHR, waited by the submit
+  VkSemaphore acquireSemaphore = VK_NULL_HANDLE;
+  // signaled by the submit, waited by present
+  VkSemaphore renderSemaphore = VK_NULL_HANDLE;
+  // transient resources of this frame. called after the gpu has finished it
+  std::vector<std::function<void()>> deferred;
+  bool submitted = false;
+
+  // time blocked on submitFence in FrameContextRing::next
+  std::chrono::nanoseconds cpuWait = {};
+  // gpu time of the last submit of this context (timestamp queries)
+  std::chrono::nanoseconds gpuBusy = {};
+
+  void defer(const std::function<void()> &release) {
+    this->deferred.push_back(release);
+  }
+};
+
+// N frames in flight. the cpu records frame n + 1 while the gpu draws frame n
+//
+//   auto &frame = ring.next();  // wait the fence of the oldest frame
+//   swapchain.acquireNextImage(frame.acquireSemaphore);
+//   ring.begin(frame);
+//   { RenderPassScope pass(frame.commandBuffer, ...); }
+//   ring.submit(frame);
+//   swapchain.present(imageIndex, frame.renderSemaphore);
+struct FrameContextRing : NonCopyable {
+  VkDevice device;
+  VkQueue queue = VK_NULL_HANDLE;
+  VkCommandPool pool = VK_NULL_HANDLE;
+  std::vector<FrameContext> frames;
+  uint64_t frameCount = 0;
+  // [begin, end] timestamps for each frame. null if not supported
+  VkQueryPool queryPool = VK_NULL_HANDLE;
+  double timestampPeriod = 1.0;
+  uint64_t timestampMask = ~0ull;
+
+  FrameContextRing(const PhysicalDevice &physicalDevice, VkDevice _device,
+                   uint32_t queueFamilyIndex, uint32_t framesInFlight = 2)
+      : device(_device), frames(framesInFlight) {
+    vkGetDeviceQueue(this->device, queueFamilyIndex, 0, &this->queue);
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                 VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queueFamilyIndex,
+    };
+    CheckVkResult(vkCreateCommandPool(this->device, &commandPoolCreateInfo,
+                                      nullptr, &this->pool));
+
+    std::vector<VkCommandBuffer> commandBuffers(framesInFlight);
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = this->pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = framesInFlight,
+    };
+    CheckVkResult(vkAllocateCommandBuffers(
+        this->device, &commandBufferAllocateInfo, commandBuffers.data()));
+
+    for (uint32_t i = 0; i < framesInFlight; ++i) {
+      auto &frame = this->frames[i];
+      frame.index = i;
+      frame.commandBuffer = commandBuffers[i];
+
+      VkFenceCreateInfo fenceInfo = {
+          .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+          .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+      };
+      CheckVkResult(vkCreateFence(this->device, &fenceInfo, nullptr,
+                                  &frame.submitFence));
+
+      VkSemaphoreCreateInfo semaphoreInfo = {
+          .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      };
+      CheckVkResult(vkCreateSemaphore(this->device, &semaphoreInfo, nullptr,
+                                      &frame.acquireSemaphore));
+      CheckVkResult(vkCreateSemaphore(this->device, &semaphoreInfo, nullptr,
+                                      &frame.renderSemaphore));
+    }
+
+    auto validBits =
+        physicalDevice.queueFamilyProperties[queueFamilyIndex]
+            .timestampValidBits;
+    if (validBits > 0) {
+      this->timestampPeriod =
+          physicalDevice.properties.limits.timestampPeriod;
+      if (validBits < 64) {
+        this->timestampMask = (1ull << validBits) - 1;
+      }
+      VkQueryPoolCreateInfo queryPoolInfo{
+          .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+          .queryType = VK_QUERY_TYPE_TIMESTAMP,
+          .queryCount = framesInFlight * 2,
+      };
+      CheckVkResult(vkCreateQueryPool(this->device, &queryPoolInfo, nullptr,
+                                      &this->queryPool));
+    }
+  }
+
+  ~FrameContextRing() {
+    for (auto &frame : this->frames) {
+      vkWaitForFences(this->device, 1, &frame.submitFence, VK_TRUE,
+                      UINT64_MAX);
+      for (auto &release : frame.deferred) {
+        release();
+      }
+      vkDestroyFence(this->device, frame.submitFence, nullptr);
+      vkDestroySemaphore(this->device, frame.acquireSemaphore, nullptr);
+      vkDestroySemaphore(this->device, frame.renderSemaphore, nullptr);
+    }
+    if (this->queryPool != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(this->device, this->queryPool, nullptr);
+    }
+    // frees the command buffers
+    vkDestroyCommandPool(this->device, this->pool, nullptr);
+  }
+
+  uint32_t size() const { return static_cast<uint32_t>(this->frames.size()); }
+
+  // wait until the gpu has finished the last use of the next context
+  FrameContext &next() {
+    auto &frame = this->frames[this->frameCount % this->frames.size()];
+    frame.frameNumber = this->frameCount++;
+
+    auto begin = std::chrono::steady_clock::now();
+    CheckVkResult(vkWaitForFences(this->device, 1, &frame.submitFence, VK_TRUE,
+                                  UINT64_MAX));
+    frame.cpuWait = std::chrono::steady_clock::now() - begin;
+
+    if (frame.submitted) {
+      frame.submitted = false;
+      if (this->queryPool != VK_NULL_HANDLE) {
+        uint64_t timestamps[2];
+        if (vkGetQueryPoolResults(this->device, this->queryPool,
+                                  frame.index * 2, 2, sizeof(timestamps),
+                                  timestamps, sizeof(uint64_t),
+                                  VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+          auto ticks = (timestamps[1] - timestamps[0]) & this->timestampMask;
+          frame.gpuBusy = std::chrono::nanoseconds(
+              static_cast<int64_t>(ticks * this->timestampPeriod));
+        }
+      }
+    }
+
+    for (auto &release : frame.deferred) {
+      release();
+    }
+    frame.deferred.clear();
+    return frame;
+  }
+
+  void begin(FrameContext &frame, VkCommandBufferUsageFlags flags =
+                                      VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) {
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = flags,
+    };
+    CheckVkResult(vkBeginCommandBuffer(frame.commandBuffer, &beginInfo));
+    if (this->queryPool != VK_NULL_HANDLE) {
+      vkCmdResetQueryPool(frame.commandBuffer, this->queryPool,
+                          frame.index * 2, 2);
+      vkCmdWriteTimestamp(frame.commandBuffer,
+                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->queryPool,
+                          frame.index * 2);
+    }
+  }
+
+  // waitDstStageMask 0: submit without acquireSemaphore / renderSemaphore
+  VkResult submit(FrameContext &frame,
+                  VkPipelineStageFlags waitDstStageMask =
+                      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT) {
+    if (this->queryPool != VK_NULL_HANDLE) {
+      vkCmdWriteTimestamp(frame.commandBuffer,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                          this->queryPool, frame.index * 2 + 1);
+    }
+    CheckVkResult(vkEndCommandBuffer(frame.commandBuffer));
+
+    if (waitDstStageMask == 0) {
+      // headless. no swapchain image to wait and nothing to present
+      VkSubmitInfo submitInfo = {
+          .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+          .commandBufferCount = 1,
+          .pCommandBuffers = &frame.commandBuffer,
+      };
+      CheckVkResult(vkResetFences(this->device, 1, &frame.submitFence));
+      auto result =
+          vkQueueSubmit(this->queue, 1, &submitInfo, frame.submitFence);
+      frame.submitted = result == VK_SUCCESS;
+      return result;
+    }
+
+    VkSubmitInfo submitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        // wait swapchain image ready
+        .waitSemaphoreCount = 1,
+        .pWaitSemaphores = &frame.acquireSemaphore,
+        .pWaitDstStageMask = &waitDstStageMask,
+        // command
+        .commandBufferCount = 1,
+        .pCommandBuffers = &frame.commandBuffer,
+        // signal
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &frame.renderSemaphore,
+    };
+    // reset just before the submit. a frame that failed to acquire keeps its
+    // fence signaled
+    CheckVkResult(vkResetFences(this->device, 1, &frame.submitFence));
+    auto result = vkQueueSubmit(this->queue, 1, &submitInfo, frame.submitFence);
+    frame.submitted = result == VK_SUCCESS;
+    return result;
+  }
+};
+
 } // namespace vk
 } // namespace vuloxr
@@ -0,0 +1,445 @@
+#pragma once
+#include "../vk.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+
+namespace vuloxr {
+
+namespace vk {
+
+// VkDescriptorSetLayout cached by its bindings. the cache owns the layouts.
+//
+//   DescriptorLayoutCache layouts(device);
+//   auto layout = layouts.get({{
+//       .binding = 0,
+//       .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+//       .descriptorCount = 1,
+//       .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+//   }});
+//
+struct DescriptorLayoutCache : NonCopyable {
+  VkDevice device;
+  // flags, then binding, type, count, stages, binding flags and immutable
+  // samplers of each binding in binding order
+  using Key = std::vector<uint64_t>;
+  std::map<Key, VkDescriptorSetLayout> layouts;
+
+  DescriptorLayoutCache(VkDevice _device) : device(_device) {}
+
+  ~DescriptorLayoutCache() {
+    for (auto &[key, layout] : this->layouts) {
+      vkDestroyDescriptorSetLayout(this->device, layout, nullptr);
+    }
+  }
+
+  // bindingFlags is empty or one VkDescriptorBindingFlags for each binding
+  VkDescriptorSetLayout
+  get(std::span<const VkDescriptorSetLayoutBinding> bindings,
+      VkDescriptorSetLayoutCreateFlags flags = 0,
+      std::span<const VkDescriptorBindingFlags> bindingFlags = {}) {
+    assert(bindingFlags.empty() || bindingFlags.size() == bindings.size());
+    std::vector<uint32_t> order(bindings.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [bindings](uint32_t l, uint32_t r) {
+      return bindings[l].binding < bindings[r].binding;
+    });
+
+    Key key{flags};
+    for (auto i : order) {
+      auto &binding = bindings[i];
+      key.push_back(binding.binding);
+      key.push_back(binding.descriptorType);
+      key.push_back(binding.descriptorCount);
+      key.push_back(binding.stageFlags);
+      key.push_back(bindingFlags.empty() ? 0 : bindingFlags[i]);
+      if (binding.pImmutableSamplers) {
+        for (uint32_t j = 0; j < binding.descriptorCount; ++j) {
+          key.push_back((uint64_t)binding.pImmutableSamplers[j]);
+        }
+      }
+    }
+
+    auto found = this->layouts.find(key);
+    if (found != this->layouts.end()) {
+      return found->second;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{
+        .sType =
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data(),
+    };
+    VkDescriptorSetLayoutCreateInfo layoutInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo,
+        .flags = flags,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+    VkDescriptorSetLayout layout;
+    CheckVkResult(
+        vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &layout));
+    this->layouts.insert({key, layout});
+    return layout;
+  }
+
+  VkDescriptorSetLayout
+  get(std::initializer_list<VkDescriptorSetLayoutBinding> bindings) {
+    return get(std::span<const VkDescriptorSetLayoutBinding>(bindings.begin(),
+                                                             bindings.end()));
+  }
+};
+
+// allocates sets from a list of pools and adds a pool when the current one
+// runs out (VK_ERROR_OUT_OF_POOL_MEMORY). reset() returns every set at once.
+// keep one allocator for each frame in flight for per draw sets:
+//
+//   std::vector<DescriptorAllocator> transient;
+//   ... wait the fence of the frame
+//   transient[frame.index].reset();
+//   auto set = transient[frame.index].allocate(layout);
+//   DescriptorWriter().buffer(0, ...).update(device, set);
+//
+struct DescriptorAllocator : NonCopyable {
+  struct PoolRatio {
+    VkDescriptorType type;
+    // descriptors per set
+    float ratio;
+  };
+  static std::vector<PoolRatio> defaultRatios() {
+    return {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+    };
+  }
+
+  VkDevice device = VK_NULL_HANDLE;
+  std::vector<PoolRatio> ratios;
+  VkDescriptorPoolCreateFlags flags = 0;
+  // sets of the next pool. doubles up to MAX_SETS_PER_POOL
+  uint32_t setsPerPool = 0;
+  static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+  // the last one is the current pool
+  std::vector<VkDescriptorPool> usedPools;
+  std::vector<VkDescriptorPool> freePools;
+
+  DescriptorAllocator(VkDevice _device, uint32_t _setsPerPool = 64,
+                      std::vector<PoolRatio> _ratios = defaultRatios(),
+                      VkDescriptorPoolCreateFlags _flags = 0)
+      : device(_device), ratios(std::move(_ratios)), flags(_flags),
+        setsPerPool(_setsPerPool) {}
+
+  ~DescriptorAllocator() { release(); }
+
+  DescriptorAllocator(DescriptorAllocator &&rhs) { *this = std::move(rhs); }
+  DescriptorAllocator &operator=(DescriptorAllocator &&rhs) {
+    release();
+    this->device = rhs.device;
+    this->ratios = std::move(rhs.ratios);
+    this->flags = rhs.flags;
+    this->setsPerPool = rhs.setsPerPool;
+    std::swap(this->usedPools, rhs.usedPools);
+    std::swap(this->freePools, rhs.freePools);
+    return *this;
+  }
+
+  void release() {
+    for (auto pool : this->usedPools) {
+      vkDestroyDescriptorPool(this->device, pool, nullptr);
+    }
+    this->usedPools.clear();
+    for (auto pool : this->freePools) {
+      vkDestroyDescriptorPool(this->device, pool, nullptr);
+    }
+    this->freePools.clear();
+  }
+
+  uint32_t poolCount() const {
+    return static_cast<uint32_t>(this->usedPools.size() +
+                                 this->freePools.size());
+  }
+
+  // the gpu must have finished every set allocated since the last reset
+  void reset() {
+    for (auto pool : this->usedPools) {
+      CheckVkResult(vkResetDescriptorPool(this->device, pool, 0));
+      this->freePools.push_back(pool);
+    }
+    this->usedPools.clear();
+  }
+
+  // pNext. e.g. VkDescriptorSetVariableDescriptorCountAllocateInfo
+  VkDescriptorSet allocate(VkDescriptorSetLayout layout,
+                           const void *pNext = nullptr) {
+    if (this->usedPools.empty()) {
+      this->usedPools.push_back(getPool());
+    }
+
+    VkDescriptorSetAllocateInfo info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = pNext,
+        .descriptorPool = this->usedPools.back(),
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+    VkDescriptorSet set;
+    auto res = vkAllocateDescriptorSets(this->device, &info, &set);
+    if (res == VK_ERROR_OUT_OF_POOL_MEMORY || res == VK_ERROR_FRAGMENTED_POOL) {
+      // the current pool is full. retry once with a new one
+      this->usedPools.push_back(getPool());
+      info.descriptorPool = this->usedPools.back();
+      res = vkAllocateDescriptorSets(this->device, &info, &set);
+    }
+    CheckVkResult(res);
+    return set;
+  }
+
+private:
+  VkDescriptorPool getPool() {
+    if (!this->freePools.empty()) {
+      auto pool = this->freePools.back();
+      this->freePools.pop_back();
+      return pool;
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (auto ratio : this->ratios) {
+      poolSizes.push_back({
+          .type = ratio.type,
+          .descriptorCount = std::max(
+              1u, static_cast<uint32_t>(ratio.ratio * this->setsPerPool)),
+      });
+    }
+    VkDescriptorPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = this->flags,
+        .maxSets = this->setsPerPool,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+    VkDescriptorPool pool;
+    CheckVkResult(
+        vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &pool));
+    Logger::Verbose("DescriptorAllocator: new pool of %d sets",
+                    this->setsPerPool);
+
+    this->setsPerPool = std::min(this->setsPerPool * 2, MAX_SETS_PER_POOL);
+    return pool;
+  }
+};
+
+// collect VkWriteDescriptorSet of any descriptor type.
+//
+//   DescriptorWriter()
+//       .buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ubo.buffer, sizeof(T))
+//       .image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, view, sampler)
+//       .update(device, set);
+//
+struct DescriptorWriter {
+  // stable addresses for pBufferInfo and pImageInfo
+  std::deque<VkDescriptorBufferInfo> bufferInfos;
+  std::deque<VkDescriptorImageInfo> imageInfos;
+  std::vector<VkWriteDescriptorSet> writes;
+
+  DescriptorWriter &buffer(uint32_t binding, VkDescriptorType type,
+                           VkBuffer buffer, VkDeviceSize range,
+                           VkDeviceSize offset = 0,
+                           uint32_t arrayElement = 0) {
+    auto &info = this->bufferInfos.emplace_back(VkDescriptorBufferInfo{
+        .buffer = buffer,
+        .offset = offset,
+        .range = range,
+    });
+    this->writes.push_back({
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding = binding,
+        .dstArrayElement = arrayElement,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pBufferInfo = &info,
+    });
+    return *this;
+  }
+
+  DescriptorWriter &
+  image(uint32_t binding, VkDescriptorType type, VkImageView imageView,
+        VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        uint32_t arrayElement = 0) {
+    auto &info = this->imageInfos.emplace_back(VkDescriptorImageInfo{
+        .sampler = sampler,
+        .imageView = imageView,
+        .imageLayout = layout,
+    });
+    this->writes.push_back({
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding = binding,
+        .dstArrayElement = arrayElement,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pImageInfo = &info,
+    });
+    return *this;
+  }
+
+  void update(VkDevice device, VkDescriptorSet set) {
+    for (auto &write : this->writes) {
+      write.dstSet = set;
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(this->writes.size()),
+                           this->writes.data(), 0, nullptr);
+  }
+};
+
+// one large sampled image array in a single set, indexed by a push constant.
+// needs Device::descriptorIndexing. a material is an index, not a set.
+//
+//   #extension GL_EXT_nonuniform_qualifier : require
+//   layout (set = 0, binding = 0) uniform sampler2D textures[];
+//   layout (push_constant) uniform Draw { uint textureIndex; };
+//   ... texture(textures[nonuniformEXT(textureIndex)], uv)
+//
+//   BindlessTextureTable table(device, 1024);
+//   auto index = table.add(texture.imageView, sampler);
+//   auto layout = table.createPipelineLayout(sizeof(uint32_t));
+//   vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0,
+//                           1, &table.descriptorSet, 0, nullptr);
+//   vkCmdPushConstants(cmd, layout, table.stageFlags, 0, 4, &index);
+//
+struct BindlessTextureTable : NonCopyable {
+  VkDevice device;
+  uint32_t capacity;
+  VkShaderStageFlags stageFlags;
+  VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+  VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+  VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+  uint32_t next = 0;
+  std::vector<uint32_t> freeIndices;
+
+  BindlessTextureTable(const Device &_device, uint32_t _capacity = 1024,
+                       VkShaderStageFlags _stageFlags =
+                           VK_SHADER_STAGE_VERTEX_BIT |
+                           VK_SHADER_STAGE_FRAGMENT_BIT)
+      : device(_device), capacity(_capacity), stageFlags(_stageFlags) {
+    if (!_device.descriptorIndexing) {
+      throw std::runtime_error("BindlessTextureTable: no descriptor indexing");
+    }
+
+    VkDescriptorSetLayoutBinding binding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = this->capacity,
+        .stageFlags = this->stageFlags,
+    };
+    // unused slots may stay empty. add() while frames are in flight
+    VkDescriptorBindingFlags bindingFlags =
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{
+        .sType =
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindingFlags = &bindingFlags,
+    };
+    VkDescriptorSetLayoutCreateInfo layoutInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+    CheckVkResult(vkCreateDescriptorSetLayout(
+        this->device, &layoutInfo, nullptr, &this->descriptorSetLayout));
+
+    VkDescriptorPoolSize poolSize{
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = this->capacity,
+    };
+    VkDescriptorPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+    CheckVkResult(vkCreateDescriptorPool(this->device, &poolInfo, nullptr,
+                                         &this->descriptorPool));
+
+    VkDescriptorSetAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = this->descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &this->descriptorSetLayout,
+    };
+    CheckVkResult(vkAllocateDescriptorSets(this->device, &allocInfo,
+                                           &this->descriptorSet));
+  }
+
+  ~BindlessTextureTable() {
+    vkDestroyDescriptorPool(this->device, this->descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(this->device, this->descriptorSetLayout,
+                                 nullptr);
+  }
+
+  // return the index for the shader
+  uint32_t add(VkImageView imageView, VkSampler sampler,
+               VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    uint32_t index;
+    if (!this->freeIndices.empty()) {
+      index = this->freeIndices.back();
+      this->freeIndices.pop_back();
+    } else if (this->next < this->capacity) {
+      index = this->next++;
+    } else {
+      throw std::runtime_error("BindlessTextureTable: full");
+    }
+
+    DescriptorWriter()
+        .image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageView, sampler,
+               layout, index)
+        .update(this->device, this->descriptorSet);
+    return index;
+  }
+
+  // no draw in flight may sample the index
+  void remove(uint32_t index) {
+    assert(index < this->next);
+    this->freeIndices.push_back(index);
+  }
+
+  // set 0 is the table. extraSets follow as set 1, 2, ...
+  VkPipelineLayout createPipelineLayout(
+      uint32_t pushConstantSize,
+      std::span<const VkDescriptorSetLayout> extraSets = {}) const {
+    std::vector<VkDescriptorSetLayout> setLayouts{this->descriptorSetLayout};
+    setLayouts.insert(setLayouts.end(), extraSets.begin(), extraSets.end());
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = this->stageFlags,
+        .offset = 0,
+        .size = pushConstantSize,
+    };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = pushConstantSize ? 1u : 0u,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    VkPipelineLayout layout;
+    CheckVkResult(vkCreatePipelineLayout(this->device, &pipelineLayoutInfo,
+                                         nullptr, &layout));
+    return layout;
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
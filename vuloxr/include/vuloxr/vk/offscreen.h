@@ -0,0 +1,165 @@
+#pragma once
+#include "swapchain.h"
+#include <cstring>
+#include <vector>
+
+namespace vuloxr {
+
+namespace vk {
+
+// color images + shared depth + framebuffers without a window.
+// same interface as SwapchainSharedDepthFramebufferList. images[i] stands in
+// for the swapchain image i.
+//
+//   auto [renderPass, depthStencil] = createColorDepthRenderPass(
+//       device, format, depthFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+//   OffscreenTarget target(device, format, depthFormat, VK_SAMPLE_COUNT_1_BIT);
+//   target.reset(physicalDevice, renderPass, extent, 2);
+//   ... render to target[i].framebuffer
+//   target.copyToReadback(cmd, i);
+//   ... wait the submit
+//   target.readbackPixels();
+//
+struct OffscreenTarget : NonCopyable {
+  VkDevice device;
+  VkFormat format;
+  VkExtent2D extent = {};
+
+  struct ColorImage {
+    VkImage image = VK_NULL_HANDLE;
+    Memory memory;
+  };
+  std::vector<ColorImage> colors;
+  std::vector<VkImage> images;
+  SwapchainSharedDepthFramebufferList framebuffers;
+
+  // one frame of tightly packed texels
+  Buffer readbackBuffer;
+  Memory readbackMemory;
+  void *readbackMapped = nullptr;
+
+  OffscreenTarget(VkDevice _device, VkFormat _format, VkFormat _depthFormat,
+                  VkSampleCountFlagBits _sampleCountFlagBits)
+      : device(_device), format(_format),
+        framebuffers(_device, _format, _depthFormat, _sampleCountFlagBits) {}
+
+  ~OffscreenTarget() { release(); }
+
+  void release() {
+    this->framebuffers.release();
+    if (this->readbackMapped && !this->readbackMemory.allocation.mapped) {
+      vkUnmapMemory(this->device, this->readbackMemory.memory);
+    }
+    this->readbackMapped = nullptr;
+    this->readbackMemory = {};
+    this->readbackBuffer = {};
+    for (auto &color : this->colors) {
+      vkDestroyImage(this->device, color.image, nullptr);
+    }
+    this->colors.clear();
+    this->images.clear();
+  }
+
+  bool empty() const { return this->colors.empty(); }
+  uint32_t size() const { return static_cast<uint32_t>(this->colors.size()); }
+  const SwapchainSharedDepthFramebufferList::Framebuffer &
+  operator[](uint32_t index) const {
+    return this->framebuffers[index];
+  }
+
+  void reset(const PhysicalDevice &physicalDevice, VkRenderPass renderPass,
+             VkExtent2D _extent, uint32_t imageCount) {
+    release();
+    this->extent = _extent;
+
+    this->colors.resize(imageCount);
+    for (auto &color : this->colors) {
+      VkImageCreateInfo imageInfo{
+          .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+          .imageType = VK_IMAGE_TYPE_2D,
+          .format = this->format,
+          .extent = {this->extent.width, this->extent.height, 1},
+          .mipLevels = 1,
+          .arrayLayers = 1,
+          .samples = VK_SAMPLE_COUNT_1_BIT,
+          .tiling = VK_IMAGE_TILING_OPTIMAL,
+          .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                   VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+          .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+          .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      };
+      CheckVkResult(
+          vkCreateImage(this->device, &imageInfo, nullptr, &color.image));
+      color.memory = physicalDevice.allocForTransfer(this->device, color.image);
+      this->images.push_back(color.image);
+    }
+
+    this->framebuffers.reset(physicalDevice, renderPass, this->extent,
+                             this->images);
+
+    this->readbackBuffer =
+        Buffer(this->device, readbackSize(), VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    this->readbackMemory =
+        physicalDevice.allocForMap(this->device, this->readbackBuffer);
+    if (this->readbackMemory.allocation.mapped) {
+      this->readbackMapped = this->readbackMemory.allocation.mapped;
+    } else {
+      CheckVkResult(vkMapMemory(this->device, this->readbackMemory.memory,
+                                this->readbackMemory.offset(), VK_WHOLE_SIZE,
+                                0, &this->readbackMapped));
+    }
+  }
+
+  // 8bit 4 channel formats
+  uint32_t readbackSize() const {
+    return this->extent.width * this->extent.height * 4;
+  }
+
+  // record after the render pass that left images[index] in
+  // VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+  void copyToReadback(VkCommandBuffer cmd, uint32_t index) const {
+    VkMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+
+    VkBufferImageCopy region{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {this->extent.width, this->extent.height, 1},
+    };
+    vkCmdCopyImageToBuffer(cmd, this->images[index],
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           this->readbackBuffer, 1, &region);
+
+    VkMemoryBarrier hostBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+    };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0,
+                         nullptr, 0, nullptr);
+  }
+
+  // valid after the fence of the copyToReadback submit
+  std::span<const uint8_t> readbackPixels() const {
+    return {(const uint8_t *)this->readbackMapped, readbackSize()};
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
@@ -0,0 +1,279 @@
+#pragma once
+#include "../vk.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+
+namespace vuloxr {
+
+namespace vk {
+
+// record one render pass on worker threads with secondary command buffers.
+// each (frame in flight, thread) pair has its own VkCommandPool, so the
+// workers never share a pool. the calling thread works as thread 0.
+//
+//   ParallelRecorder recorder(device, queueFamilyIndex, framesInFlight);
+//   auto &frame = ring.next();          // wait the fence of the frame
+//   recorder.beginFrame(frame.index);   // reset the pools of the frame
+//   ring.begin(frame);
+//   recorder.recordRenderPass(frame.commandBuffer, renderPass, framebuffer,
+//                             extent, clearValues, drawCount,
+//                             [](VkCommandBuffer cmd, uint32_t begin,
+//                                uint32_t end) { ... draw [begin, end) });
+//   ring.submit(frame);
+//
+// per eye, record each eye as a task and execute it in the primary of the
+// eye
+//
+//   recorder.dispatch(2, [&](uint32_t eye, uint32_t thread) {
+//     secondaries[eye] = recorder.beginSecondary(thread, renderPass,
+//                                                framebuffers[eye], extent);
+//     ... draw
+//     CheckVkResult(vkEndCommandBuffer(secondaries[eye]));
+//   });
+struct ParallelRecorder : NonCopyable {
+  // secondary command buffer, draw begin, draw end
+  using RangeFunc = std::function<void(VkCommandBuffer, uint32_t, uint32_t)>;
+  // task index, thread index
+  using TaskFunc = std::function<void(uint32_t, uint32_t)>;
+
+  struct ThreadPool {
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> commandBuffers;
+    uint32_t used = 0;
+  };
+
+  VkDevice device;
+  uint32_t threadCount;
+  uint32_t frameIndex = 0;
+  // [frame * threadCount + thread]
+  std::vector<ThreadPool> pools;
+  std::vector<VkCommandBuffer> secondaries;
+
+  ParallelRecorder(VkDevice _device, uint32_t queueFamilyIndex,
+                   uint32_t framesInFlight,
+                   uint32_t _threadCount = std::thread::hardware_concurrency())
+      : device(_device), threadCount(std::max(1u, _threadCount)),
+        pools(framesInFlight * this->threadCount) {
+    for (auto &pool : this->pools) {
+      VkCommandPoolCreateInfo commandPoolCreateInfo{
+          .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+          .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+          .queueFamilyIndex = queueFamilyIndex,
+      };
+      CheckVkResult(vkCreateCommandPool(this->device, &commandPoolCreateInfo,
+                                        nullptr, &pool.pool));
+    }
+    for (uint32_t i = 1; i < this->threadCount; ++i) {
+      this->workers.emplace_back([this, i]() { this->workerLoop(i); });
+    }
+    Logger::Info("ParallelRecorder: %u threads, %u frames", this->threadCount,
+                 framesInFlight);
+  }
+
+  ~ParallelRecorder() {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->quit = true;
+    }
+    this->wake.notify_all();
+    for (auto &worker : this->workers) {
+      worker.join();
+    }
+    // frees the command buffers. the caller has waited the frames
+    for (auto &pool : this->pools) {
+      vkDestroyCommandPool(this->device, pool.pool, nullptr);
+    }
+  }
+
+  // the gpu must have finished the last use of frame
+  void beginFrame(uint32_t frame) {
+    this->frameIndex = frame % (this->pools.size() / this->threadCount);
+    for (uint32_t i = 0; i < this->threadCount; ++i) {
+      auto &pool = this->pools[this->frameIndex * this->threadCount + i];
+      if (pool.used > 0) {
+        CheckVkResult(vkResetCommandPool(this->device, pool.pool, 0));
+        pool.used = 0;
+      }
+    }
+  }
+
+  // call from the thread of threadIndex in dispatch.
+  // viewport and scissor are set to extent
+  VkCommandBuffer beginSecondary(uint32_t threadIndex, VkRenderPass renderPass,
+                                 VkFramebuffer framebuffer, VkExtent2D extent,
+                                 uint32_t subpass = 0) {
+    auto &pool =
+        this->pools[this->frameIndex * this->threadCount + threadIndex];
+    if (pool.used == pool.commandBuffers.size()) {
+      VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
+          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+          .commandPool = pool.pool,
+          .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+          .commandBufferCount = 1,
+      };
+      VkCommandBuffer commandBuffer;
+      CheckVkResult(vkAllocateCommandBuffers(
+          this->device, &commandBufferAllocateInfo, &commandBuffer));
+      pool.commandBuffers.push_back(commandBuffer);
+    }
+    auto cmd = pool.commandBuffers[pool.used++];
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = renderPass,
+        .subpass = subpass,
+        .framebuffer = framebuffer,
+    };
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                 VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo,
+    };
+    CheckVkResult(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    // dynamic state is not inherited from the primary
+    VkViewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(extent.width),
+        .height = static_cast<float>(extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    VkRect2D scissor{
+        .offset = {0, 0},
+        .extent = extent,
+    };
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    return cmd;
+  }
+
+  // run func(task, thread) for each task in [0, taskCount) on the workers and
+  // block until all are done. the first exception is rethrown here
+  void dispatch(uint32_t taskCount, const TaskFunc &func) {
+    if (taskCount == 0) {
+      return;
+    }
+    if (this->threadCount == 1 || taskCount == 1) {
+      for (uint32_t i = 0; i < taskCount; ++i) {
+        func(i, 0);
+      }
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->task = &func;
+      this->taskCount = taskCount;
+      this->nextTask = 0;
+      this->running = this->threadCount;
+      this->error = nullptr;
+      ++this->generation;
+    }
+    this->wake.notify_all();
+
+    this->runTasks(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this]() { return this->running == 0; });
+    this->task = nullptr;
+    if (this->error) {
+      std::rethrow_exception(this->error);
+    }
+  }
+
+  // split [0, drawCount) into one range per thread, record each range into a
+  // secondary command buffer and execute them in order in the primary
+  void recordRenderPass(VkCommandBuffer primary, VkRenderPass renderPass,
+                        VkFramebuffer framebuffer, VkExtent2D extent,
+                        std::span<const VkClearValue> clearValues,
+                        uint32_t drawCount, const RangeFunc &func) {
+    auto taskCount = std::max(1u, std::min(this->threadCount, drawCount));
+    this->secondaries.resize(taskCount);
+    this->dispatch(taskCount, [&](uint32_t task, uint32_t thread) {
+      auto cmd = this->beginSecondary(thread, renderPass, framebuffer, extent);
+      func(cmd, static_cast<uint32_t>(uint64_t(drawCount) * task / taskCount),
+           static_cast<uint32_t>(uint64_t(drawCount) * (task + 1) /
+                                 taskCount));
+      CheckVkResult(vkEndCommandBuffer(cmd));
+      this->secondaries[task] = cmd;
+    });
+
+    VkRenderPassBeginInfo renderPassInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = renderPass,
+        .framebuffer = framebuffer,
+        .renderArea = {.offset = {0, 0}, .extent = extent},
+        .clearValueCount = static_cast<uint32_t>(std::size(clearValues)),
+        .pClearValues = clearValues.data(),
+    };
+    vkCmdBeginRenderPass(primary, &renderPassInfo,
+                         VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(primary,
+                         static_cast<uint32_t>(this->secondaries.size()),
+                         this->secondaries.data());
+    vkCmdEndRenderPass(primary);
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  bool quit = false;
+  uint64_t generation = 0;
+  const TaskFunc *task = nullptr;
+  uint32_t taskCount = 0;
+  std::atomic<uint32_t> nextTask = 0;
+  uint32_t running = 0;
+  std::exception_ptr error;
+
+  void runTasks(uint32_t threadIndex) {
+    try {
+      for (uint32_t i = this->nextTask++; i < this->taskCount;
+           i = this->nextTask++) {
+        (*this->task)(i, threadIndex);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (!this->error) {
+        this->error = std::current_exception();
+      }
+      // let the others drain
+      this->nextTask = this->taskCount;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (--this->running == 0) {
+      this->done.notify_one();
+    }
+  }
+
+  void workerLoop(uint32_t threadIndex) {
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->wake.wait(lock, [this, seen]() {
+          return this->quit || this->generation != seen;
+        });
+        if (this->quit) {
+          return;
+        }
+        seen = this->generation;
+      }
+      this->runTasks(threadIndex);
+    }
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
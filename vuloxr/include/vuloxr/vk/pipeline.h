@@ -92,8 +92,10 @@ createColorRenderPass(VkDevice device, VkFormat format) {
 }
 
 inline std::tuple<VkRenderPass, VkPipelineDepthStencilStateCreateInfo>
-createColorDepthRenderPass(VkDevice device, VkFormat colorFormat,
-                           VkFormat depthFormat) {
+createColorDepthRenderPass(
+    VkDevice device, VkFormat colorFormat, VkFormat depthFormat,
+    // VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL for OffscreenTarget
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
 
   VkAttachmentDescription attachments[] = {
       {
@@ -106,7 +108,7 @@ createColorDepthRenderPass(VkDevice device, VkFormat colorFormat,
           // .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
           .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
           // .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-          .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+          .finalLayout = finalLayout,
           //                 VkImageLayout initialLayout =
           //                 VK_IMAGE_LAYOUT_UNDEFINED for clear VkImageLayout
           //                 finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
@@ -257,6 +259,8 @@ struct Pipeline : NonCopyable {
 };
 
 struct PipelineBuilder {
+  VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
   VkPipelineVertexInputStateCreateInfo vertexInputInfo{
       .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
       .pNext = NULL,
@@ -419,7 +423,7 @@ struct PipelineBuilder {
         .basePipelineIndex = 0,
     };
     VkPipeline pipeline;
-    CheckVkResult(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1,
+    CheckVkResult(vkCreateGraphicsPipelines(device, this->pipelineCache, 1,
                                             &pipelineInfo, nullptr, &pipeline));
 
     return {device, renderPass, pipelineLayout, pipeline};
@@ -516,9 +520,10 @@ struct DescriptorSet : NonCopyable {
 
     std::vector<VkDescriptorPoolSize> poolSizes;
     for (auto binding : bindings) {
+      // allocateCount sets of each binding
       poolSizes.push_back({
           .type = binding.descriptorType,
-          .descriptorCount = 1,
+          .descriptorCount = binding.descriptorCount * allocateCount,
       });
     }
     VkDescriptorPoolCreateInfo poolInfo{
@@ -567,6 +572,8 @@ struct DescriptorSet : NonCopyable {
       assert(infos[i].type == this->writes[i].descriptorType);
       switch (infos[i].type) {
       case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
         this->writes[i].pBufferInfo = infos[i].pBufferInfo;
         break;
       case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
@@ -604,27 +611,29 @@ createPipelineLayoutWithConstantSize(VkDevice device, uint32_t constantSize) {
   return layout;
 }
 
-struct RenderPassRecording : NonCopyable {
+// record a render pass into a command buffer that is already recording.
+// e.g. FrameContextRing::begin
+//
+// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS: only vkCmdExecuteCommands
+// is allowed in the pass. viewport, scissor and descriptorSet are left to the
+// secondaries. see ParallelRecorder
+struct RenderPassScope : NonCopyable {
   VkCommandBuffer commandBuffer;
+  bool open = true;
 
   struct ClearColor {
     float r, g, b, a;
   };
 
-  RenderPassRecording(VkCommandBuffer _commandBuffer,
-                      VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
-                      VkFramebuffer framebuffer, VkExtent2D extent,
-                      std::span<const VkClearValue> clearValues,
-                      VkDescriptorSet descriptorSet = VK_NULL_HANDLE,
-                      VkCommandBufferUsageFlags flags =
-                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)
+  RenderPassScope(VkCommandBuffer _commandBuffer,
+                  VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+                  VkFramebuffer framebuffer, VkExtent2D extent,
+                  std::span<const VkClearValue> clearValues,
+                  VkDescriptorSet descriptorSet = VK_NULL_HANDLE,
+                  // for VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                  std::span<const uint32_t> dynamicOffsets = {},
+                  VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE)
       : commandBuffer(_commandBuffer) {
-    VkCommandBufferBeginInfo beginInfo{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = flags,
-    };
-    CheckVkResult(vkBeginCommandBuffer(this->commandBuffer, &beginInfo));
-
     VkRenderPassBeginInfo renderPassInfo{
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
         .renderPass = renderPass,
@@ -633,8 +642,10 @@ struct RenderPassRecording : NonCopyable {
         .clearValueCount = static_cast<uint32_t>(std::size(clearValues)),
         .pClearValues = clearValues.data(),
     };
-    vkCmdBeginRenderPass(this->commandBuffer, &renderPassInfo,
-                         VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(this->commandBuffer, &renderPassInfo, contents);
+    if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+      return;
+    }
 
     VkViewport viewport{
         .x = 0.0f,
@@ -655,14 +666,20 @@ struct RenderPassRecording : NonCopyable {
     if (pipelineLayout != VK_NULL_HANDLE && descriptorSet != VK_NULL_HANDLE) {
       // take the descriptor set for the corresponding swap image, and bind it
       // to the descriptors in the shader
-      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                              pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+      vkCmdBindDescriptorSets(
+          commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+          &descriptorSet, static_cast<uint32_t>(dynamicOffsets.size()),
+          dynamicOffsets.data());
     }
   }
 
-  ~RenderPassRecording() {
-    vkCmdEndRenderPass(this->commandBuffer);
-    CheckVkResult(vkEndCommandBuffer(this->commandBuffer));
+  ~RenderPassScope() { end(); }
+
+  void end() {
+    if (this->open) {
+      vkCmdEndRenderPass(this->commandBuffer);
+      this->open = false;
+    }
   }
 
   void draw(VkPipeline pipeline, VkBuffer buffer, uint32_t vertexCount) {
@@ -691,6 +708,39 @@ struct RenderPassRecording : NonCopyable {
   // }
 };
 
+// begin the command buffer and record a render pass
+struct RenderPassRecording : RenderPassScope {
+  RenderPassRecording(VkCommandBuffer _commandBuffer,
+                      VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+                      VkFramebuffer framebuffer, VkExtent2D extent,
+                      std::span<const VkClearValue> clearValues,
+                      VkDescriptorSet descriptorSet = VK_NULL_HANDLE,
+                      VkCommandBufferUsageFlags flags =
+                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                      // for VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                      std::span<const uint32_t> dynamicOffsets = {},
+                      VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE)
+      : RenderPassScope(beginCommandBuffer(_commandBuffer, flags),
+                        pipelineLayout, renderPass, framebuffer, extent,
+                        clearValues, descriptorSet, dynamicOffsets, contents) {}
+
+  ~RenderPassRecording() {
+    end();
+    CheckVkResult(vkEndCommandBuffer(this->commandBuffer));
+  }
+
+private:
+  static VkCommandBuffer beginCommandBuffer(VkCommandBuffer commandBuffer,
+                                            VkCommandBufferUsageFlags flags) {
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = flags,
+    };
+    CheckVkResult(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+    return commandBuffer;
+  }
+};
+
 
 } // namespace vk
 } // namespace vuloxr
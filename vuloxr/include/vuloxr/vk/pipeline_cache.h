@@ -0,0 +1,155 @@
+#pragma once
+#include "../vk.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace vuloxr {
+
+namespace vk {
+
+// VkPipelineCache persisted to a file.
+//
+// The blob is prefixed with our own header. A file written by another
+// device, another driver version or a half written file is discarded and
+// the cache starts empty, instead of trusting the driver to reject it.
+struct PipelineCache : NonCopyable {
+  struct FileHeader {
+    char magic[4] = {'V', 'X', 'P', 'C'};
+    uint32_t version = 1;
+    uint32_t vendorID = 0;
+    uint32_t deviceID = 0;
+    uint32_t driverVersion = 0;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE] = {};
+    uint64_t dataSize = 0;
+    // FNV-1a of the data
+    uint64_t dataHash = 0;
+  };
+
+  VkDevice device = VK_NULL_HANDLE;
+  VkPipelineCache cache = VK_NULL_HANDLE;
+  operator VkPipelineCache() const { return this->cache; }
+  std::filesystem::path path;
+  FileHeader expected;
+  // true if the initial data was loaded from path
+  bool loaded = false;
+
+  PipelineCache(const PhysicalDevice &physicalDevice, VkDevice _device,
+                const std::filesystem::path &_path)
+      : device(_device), path(_path) {
+    auto &props = physicalDevice.properties;
+    this->expected.vendorID = props.vendorID;
+    this->expected.deviceID = props.deviceID;
+    this->expected.driverVersion = props.driverVersion;
+    memcpy(this->expected.pipelineCacheUUID, props.pipelineCacheUUID,
+           VK_UUID_SIZE);
+
+    auto data = load();
+    this->loaded = !data.empty();
+    VkPipelineCacheCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+    CheckVkResult(
+        vkCreatePipelineCache(this->device, &info, nullptr, &this->cache));
+    Logger::Info("PipelineCache: %s %s (%zu bytes)",
+                 this->path.string().c_str(),
+                 this->loaded ? "loaded" : "empty", data.size());
+  }
+
+  ~PipelineCache() {
+    // no throw from a destructor. the next run starts with an empty cache
+    try {
+      save();
+    } catch (const std::exception &e) {
+      Logger::Error("PipelineCache: fail to save. %s", e.what());
+    }
+    vkDestroyPipelineCache(this->device, this->cache, nullptr);
+  }
+
+  static uint64_t hash(const uint8_t *p, size_t size) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+      h ^= p[i];
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+  bool save() const {
+    size_t size = 0;
+    CheckVkResult(
+        vkGetPipelineCacheData(this->device, this->cache, &size, nullptr));
+    std::vector<uint8_t> data(size);
+    CheckVkResult(
+        vkGetPipelineCacheData(this->device, this->cache, &size, data.data()));
+    data.resize(size);
+
+    auto header = this->expected;
+    header.dataSize = size;
+    header.dataHash = hash(data.data(), data.size());
+
+    std::error_code ec;
+    if (this->path.has_parent_path()) {
+      std::filesystem::create_directories(this->path.parent_path(), ec);
+    }
+    auto tmp = this->path;
+    tmp += ".tmp";
+    {
+      std::ofstream os(tmp, std::ios::binary);
+      if (!os) {
+        Logger::Warn("PipelineCache: fail to write %s",
+                     tmp.string().c_str());
+        return false;
+      }
+      os.write((const char *)&header, sizeof(header));
+      os.write((const char *)data.data(), data.size());
+    }
+    std::filesystem::rename(tmp, this->path, ec);
+    return !ec;
+  }
+
+private:
+  std::vector<uint8_t> load() const {
+    std::ifstream is(this->path, std::ios::binary);
+    if (!is) {
+      return {};
+    }
+    FileHeader header;
+    if (!is.read((char *)&header, sizeof(header))) {
+      Logger::Warn("PipelineCache: truncated header");
+      return {};
+    }
+    if (memcmp(header.magic, this->expected.magic, 4) != 0 ||
+        header.version != this->expected.version) {
+      Logger::Warn("PipelineCache: unknown file");
+      return {};
+    }
+    if (header.vendorID != this->expected.vendorID ||
+        header.deviceID != this->expected.deviceID ||
+        header.driverVersion != this->expected.driverVersion ||
+        memcmp(header.pipelineCacheUUID, this->expected.pipelineCacheUUID,
+               VK_UUID_SIZE) != 0) {
+      Logger::Info("PipelineCache: device or driver changed. discard");
+      return {};
+    }
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(this->path, ec);
+    if (ec || header.dataSize != fileSize - sizeof(header)) {
+      Logger::Warn("PipelineCache: size mismatch");
+      return {};
+    }
+    std::vector<uint8_t> data(header.dataSize);
+    if (!is.read((char *)data.data(), data.size()) ||
+        hash(data.data(), data.size()) != header.dataHash) {
+      Logger::Warn("PipelineCache: broken data");
+      return {};
+    }
+    return data;
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
@@ -0,0 +1,398 @@
+#pragma once
+#include "../vk.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vuloxr {
+
+namespace vk {
+
+// scoped gpu timestamps (+ pipeline statistics) per frame in flight.
+//
+//   GpuProfiler profiler(physicalDevice, device, queueFamily, 2);
+//   auto &frame = frames.next();        // the fence of this slot is waited
+//   profiler.beginFrame(frame.commandBuffer, frame.index);  // after begin
+//   {
+//     GpuZone zone(profiler, frame.commandBuffer, "scene");
+//     ...
+//   }
+//   frames.submit(frame);
+//
+// beginFrame resolves the queries the slot recorded framesInFlight frames
+// ago. the fence of the slot has been waited, so this never stalls. a zone
+// name must be a string literal (the pointer is kept).
+//
+// pipeline statistics are queried for the outermost zones only (a query type
+// can not be nested) and need VkPhysicalDeviceFeatures::pipelineStatisticsQuery.
+struct GpuProfiler : NonCopyable {
+  static constexpr uint32_t STATISTICS_COUNT = 4;
+  static constexpr VkQueryPipelineStatisticFlags STATISTICS =
+      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+  // rolling window of ZoneStats
+  static constexpr uint32_t WINDOW = 120;
+  static constexpr uint32_t NO_QUERY = UINT32_MAX;
+
+  struct Zone {
+    const char *name;
+    uint32_t depth;
+    uint32_t beginQuery;
+    uint32_t endQuery = NO_QUERY;
+    uint32_t statisticsQuery = NO_QUERY;
+  };
+
+  struct Slot {
+    uint64_t frameNumber = 0;
+    // cpu time of beginFrame. the gpu timeline of the slot is placed here
+    double cpuBeginUs = 0;
+    std::vector<Zone> zones;
+    uint32_t timestampCount = 0;
+    uint32_t statisticsCount = 0;
+    uint32_t depth = 0;
+    bool recorded = false;
+  };
+
+  struct ZoneStats {
+    std::vector<double> samples;
+    uint32_t next = 0;
+    double sum = 0;
+    // the latest sample. for a feedback loop that can not wait the window
+    double lastMs = 0;
+    uint64_t statistics[STATISTICS_COUNT] = {};
+
+    void push(double ms) {
+      this->lastMs = ms;
+      if (this->samples.size() < WINDOW) {
+        this->samples.push_back(ms);
+      } else {
+        this->sum -= this->samples[this->next];
+        this->samples[this->next] = ms;
+        this->next = (this->next + 1) % WINDOW;
+      }
+      this->sum += ms;
+    }
+    double averageMs() const {
+      return this->samples.empty() ? 0 : this->sum / this->samples.size();
+    }
+  };
+
+  // chrome://tracing "X" event
+  struct TraceEvent {
+    const char *name;
+    uint32_t tid;
+    double tsUs;
+    double durUs;
+  };
+  static constexpr uint32_t GPU_TID = 0;
+
+  VkDevice device;
+  VkQueryPool timestampPool = VK_NULL_HANDLE;
+  VkQueryPool statisticsPool = VK_NULL_HANDLE;
+  uint32_t maxZones;
+  double timestampPeriod = 1.0;
+  uint64_t timestampMask = ~0ull;
+  std::vector<Slot> slots;
+  Slot *current = nullptr;
+  std::map<std::string, ZoneStats> stats;
+
+  std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+  // capture trace events while true. bounded by maxTraceEvents
+  bool capture = false;
+  size_t maxTraceEvents = 1000000;
+  std::mutex traceMutex;
+  std::vector<TraceEvent> trace;
+  std::map<std::thread::id, uint32_t> threadIds;
+
+  GpuProfiler(const PhysicalDevice &physicalDevice, VkDevice _device,
+              uint32_t queueFamilyIndex, uint32_t framesInFlight = 2,
+              uint32_t _maxZones = 64, bool pipelineStatistics = false)
+      : device(_device), maxZones(_maxZones), slots(framesInFlight) {
+    auto validBits =
+        physicalDevice.queueFamilyProperties[queueFamilyIndex]
+            .timestampValidBits;
+    if (validBits == 0) {
+      Logger::Warn("GpuProfiler: no timestamp support");
+      return;
+    }
+    this->timestampPeriod = physicalDevice.properties.limits.timestampPeriod;
+    if (validBits < 64) {
+      this->timestampMask = (1ull << validBits) - 1;
+    }
+
+    VkQueryPoolCreateInfo timestampInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = framesInFlight * this->maxZones * 2,
+    };
+    CheckVkResult(vkCreateQueryPool(this->device, &timestampInfo, nullptr,
+                                    &this->timestampPool));
+
+    if (pipelineStatistics) {
+      if (physicalDevice.features.pipelineStatisticsQuery) {
+        VkQueryPoolCreateInfo statisticsInfo{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+            .queryCount = framesInFlight * this->maxZones,
+            .pipelineStatistics = STATISTICS,
+        };
+        CheckVkResult(vkCreateQueryPool(this->device, &statisticsInfo,
+                                        nullptr, &this->statisticsPool));
+      } else {
+        Logger::Warn("GpuProfiler: no pipelineStatisticsQuery");
+      }
+    }
+  }
+
+  ~GpuProfiler() {
+    if (this->statisticsPool != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(this->device, this->statisticsPool, nullptr);
+    }
+    if (this->timestampPool != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(this->device, this->timestampPool, nullptr);
+    }
+  }
+
+  bool enabled() const { return this->timestampPool != VK_NULL_HANDLE; }
+
+  double nowUs() const {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - this->epoch)
+        .count();
+  }
+
+  // after vkBeginCommandBuffer. the fence of slotIndex must be signaled
+  void beginFrame(VkCommandBuffer cmd, uint32_t slotIndex,
+                  uint64_t frameNumber = 0) {
+    auto &slot = this->slots[slotIndex];
+    if (slot.recorded) {
+      resolve(slot);
+    }
+
+    slot.frameNumber = frameNumber;
+    slot.cpuBeginUs = nowUs();
+    slot.zones.clear();
+    slot.timestampCount = 0;
+    slot.statisticsCount = 0;
+    slot.depth = 0;
+    slot.recorded = enabled();
+    this->current = &slot;
+    if (!enabled()) {
+      return;
+    }
+
+    auto base = slotIndex * this->maxZones;
+    vkCmdResetQueryPool(cmd, this->timestampPool, base * 2,
+                        this->maxZones * 2);
+    if (this->statisticsPool != VK_NULL_HANDLE) {
+      vkCmdResetQueryPool(cmd, this->statisticsPool, base, this->maxZones);
+    }
+  }
+
+  // returns the zone index or NO_QUERY
+  uint32_t beginZone(VkCommandBuffer cmd, const char *name,
+                     VkPipelineStageFlagBits stage =
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT) {
+    auto slot = this->current;
+    if (!slot || !slot->recorded || slot->zones.size() >= this->maxZones) {
+      return NO_QUERY;
+    }
+    auto base = slotIndex(*slot) * this->maxZones;
+    Zone zone{
+        .name = name,
+        .depth = slot->depth++,
+        .beginQuery = base * 2 + slot->timestampCount++,
+    };
+    vkCmdWriteTimestamp(cmd, stage, this->timestampPool, zone.beginQuery);
+    if (this->statisticsPool != VK_NULL_HANDLE && zone.depth == 0) {
+      zone.statisticsQuery = base + slot->statisticsCount++;
+      vkCmdBeginQuery(cmd, this->statisticsPool, zone.statisticsQuery, 0);
+    }
+    slot->zones.push_back(zone);
+    return static_cast<uint32_t>(slot->zones.size() - 1);
+  }
+
+  void endZone(VkCommandBuffer cmd, uint32_t zoneIndex,
+               VkPipelineStageFlagBits stage =
+                   VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) {
+    auto slot = this->current;
+    if (!slot || zoneIndex == NO_QUERY) {
+      return;
+    }
+    auto &zone = slot->zones[zoneIndex];
+    if (zone.statisticsQuery != NO_QUERY) {
+      vkCmdEndQuery(cmd, this->statisticsPool, zone.statisticsQuery);
+    }
+    zone.endQuery =
+        slotIndex(*slot) * this->maxZones * 2 + slot->timestampCount++;
+    vkCmdWriteTimestamp(cmd, stage, this->timestampPool, zone.endQuery);
+    --slot->depth;
+  }
+
+  // resolve every recorded slot. after vkDeviceWaitIdle
+  void flush() {
+    for (auto &slot : this->slots) {
+      if (slot.recorded) {
+        resolve(slot);
+      }
+    }
+    this->current = nullptr;
+  }
+
+  // cpu side of the trace. thread safe
+  void addCpuEvent(const char *name, double beginUs, double endUs) {
+    if (!this->capture) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(this->traceMutex);
+    auto [it, inserted] = this->threadIds.insert(
+        {std::this_thread::get_id(),
+         static_cast<uint32_t>(this->threadIds.size() + 1)});
+    pushTrace({name, it->second, beginUs, endUs - beginUs});
+  }
+
+  void logStats() const {
+    for (auto &[name, zone] : this->stats) {
+      if (this->statisticsPool != VK_NULL_HANDLE) {
+        Logger::Info("[gpu] %-16s %7.3fms prim %llu vs %llu clip %llu fs %llu",
+                     name.c_str(), zone.averageMs(),
+                     (unsigned long long)zone.statistics[0],
+                     (unsigned long long)zone.statistics[1],
+                     (unsigned long long)zone.statistics[2],
+                     (unsigned long long)zone.statistics[3]);
+      } else {
+        Logger::Info("[gpu] %-16s %7.3fms", name.c_str(), zone.averageMs());
+      }
+    }
+  }
+
+  // chrome://tracing or https://ui.perfetto.dev
+  bool exportChromeTrace(const std::string &path) {
+    std::ofstream os(path);
+    if (!os) {
+      Logger::Error("GpuProfiler: fail to write %s", path.c_str());
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(this->traceMutex);
+    os << "{\"traceEvents\":[\n";
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+       << GPU_TID << ",\"args\":{\"name\":\"gpu\"}}";
+    for (auto &[id, tid] : this->threadIds) {
+      os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+         << tid << ",\"args\":{\"name\":\"cpu " << tid << "\"}}";
+    }
+    char buf[64];
+    for (auto &e : this->trace) {
+      os << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+         << e.tid;
+      snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"dur\":%.3f}", e.tsUs,
+               e.durUs);
+      os << buf;
+    }
+    os << "\n]}\n";
+    return true;
+  }
+
+private:
+  uint32_t slotIndex(const Slot &slot) const {
+    return static_cast<uint32_t>(&slot - this->slots.data());
+  }
+
+  void pushTrace(const TraceEvent &e) {
+    if (this->trace.size() < this->maxTraceEvents) {
+      this->trace.push_back(e);
+    }
+  }
+
+  void resolve(Slot &slot) {
+    slot.recorded = false;
+    if (slot.timestampCount == 0) {
+      return;
+    }
+    auto base = slotIndex(slot) * this->maxZones;
+    std::vector<uint64_t> timestamps(slot.timestampCount);
+    // no VK_QUERY_RESULT_WAIT_BIT. skip the frame rather than stall
+    if (vkGetQueryPoolResults(this->device, this->timestampPool, base * 2,
+                              slot.timestampCount,
+                              timestamps.size() * sizeof(uint64_t),
+                              timestamps.data(), sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+      return;
+    }
+    std::vector<uint64_t> statistics(slot.statisticsCount * STATISTICS_COUNT);
+    bool hasStatistics =
+        slot.statisticsCount > 0 &&
+        vkGetQueryPoolResults(
+            this->device, this->statisticsPool, base, slot.statisticsCount,
+            statistics.size() * sizeof(uint64_t), statistics.data(),
+            STATISTICS_COUNT * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+    auto origin = timestamps[0] & this->timestampMask;
+    auto toUs = [this, origin](uint64_t t) {
+      return ((t & this->timestampMask) - origin) * this->timestampPeriod /
+             1000.0;
+    };
+
+    std::unique_lock<std::mutex> lock(this->traceMutex, std::defer_lock);
+    if (this->capture) {
+      lock.lock();
+    }
+    for (auto &zone : slot.zones) {
+      if (zone.endQuery == NO_QUERY) {
+        // not closed
+        continue;
+      }
+      auto beginUs = toUs(timestamps[zone.beginQuery - base * 2]);
+      auto endUs = toUs(timestamps[zone.endQuery - base * 2]);
+      auto &s = this->stats[zone.name];
+      s.push((endUs - beginUs) / 1000.0);
+      if (hasStatistics && zone.statisticsQuery != NO_QUERY) {
+        memcpy(s.statistics,
+               &statistics[(zone.statisticsQuery - base) * STATISTICS_COUNT],
+               sizeof(s.statistics));
+      }
+      if (this->capture) {
+        // gpu clock is not calibrated with the cpu clock. the frame is placed
+        // at the cpu time of beginFrame
+        pushTrace({zone.name, GPU_TID, slot.cpuBeginUs + beginUs,
+                   endUs - beginUs});
+      }
+    }
+  }
+};
+
+// RAII zone
+struct GpuZone : NonCopyable {
+  GpuProfiler &profiler;
+  VkCommandBuffer cmd;
+  uint32_t zone;
+  GpuZone(GpuProfiler &_profiler, VkCommandBuffer _cmd, const char *name)
+      : profiler(_profiler), cmd(_cmd),
+        zone(_profiler.beginZone(_cmd, name)) {}
+  ~GpuZone() { this->profiler.endZone(this->cmd, this->zone); }
+};
+
+// RAII cpu zone for the same trace
+struct CpuZone : NonCopyable {
+  GpuProfiler &profiler;
+  const char *name;
+  double beginUs;
+  CpuZone(GpuProfiler &_profiler, const char *_name)
+      : profiler(_profiler), name(_name), beginUs(_profiler.nowUs()) {}
+  ~CpuZone() {
+    this->profiler.addCpuEvent(this->name, this->beginUs,
+                               this->profiler.nowUs());
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
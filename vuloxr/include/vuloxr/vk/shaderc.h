@@ -1,5 +1,11 @@
+#pragma once
 #include "../../vuloxr.h"
 
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
 #include <shaderc/shaderc.hpp>
 #include <string>
 #include <vector>
@@ -7,12 +13,99 @@
 namespace vuloxr {
 namespace vk {
 
+// content addressed spv cache on disk.
+//
+//   vuloxr::vk::ShaderCache::get().directory = "cache/shaders";
+//
+// compile_glsl looks up <directory>/<hash of source, kind and options>.spv
+// before compiling. disabled while directory is empty.
+struct ShaderCache {
+  // bump when the compile options or the file layout change
+  static constexpr uint32_t VERSION = 1;
+  std::filesystem::path directory;
+  std::atomic<uint32_t> hits = 0;
+  std::atomic<uint32_t> misses = 0;
+
+  static ShaderCache &get() {
+    static ShaderCache s_cache;
+    return s_cache;
+  }
+
+  static uint64_t hash(shaderc_shader_kind kind, const std::string &data) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ull;
+    auto push = [&h](const void *p, size_t size) {
+      for (size_t i = 0; i < size; ++i) {
+        h ^= ((const uint8_t *)p)[i];
+        h *= 1099511628211ull;
+      }
+    };
+    push(&VERSION, sizeof(VERSION));
+    push(&kind, sizeof(kind));
+    push(data.data(), data.size());
+    return h;
+  }
+
+  std::filesystem::path pathFor(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)key);
+    return this->directory / name;
+  }
+
+  std::optional<std::vector<uint32_t>> load(uint64_t key) {
+    std::ifstream is(pathFor(key), std::ios::binary | std::ios::ate);
+    if (!is) {
+      ++this->misses;
+      return {};
+    }
+    auto size = static_cast<size_t>(is.tellg());
+    std::vector<uint32_t> spv(size / 4);
+    is.seekg(0);
+    is.read((char *)spv.data(), spv.size() * 4);
+    // truncated or not spir-v
+    if (!is || size % 4 != 0 || spv.empty() || spv[0] != 0x07230203) {
+      Logger::Warn("ShaderCache: broken %s", pathFor(key).string().c_str());
+      ++this->misses;
+      return {};
+    }
+    ++this->hits;
+    return spv;
+  }
+
+  void store(uint64_t key, const std::vector<uint32_t> &spv) const {
+    std::error_code ec;
+    std::filesystem::create_directories(this->directory, ec);
+    auto path = pathFor(key);
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+      std::ofstream os(tmp, std::ios::binary);
+      if (!os) {
+        Logger::Warn("ShaderCache: fail to write %s", tmp.string().c_str());
+        return;
+      }
+      os.write((const char *)spv.data(), spv.size() * 4);
+    }
+    // a concurrent reader sees the old file or the whole new one
+    std::filesystem::rename(tmp, path, ec);
+  }
+};
+
 // https://developer.android.com/ndk/guides/graphics/shader-compilers?hl=ja
 inline std::vector<uint32_t> compile_glsl(const std::string &name,
                                           shaderc_shader_kind kind,
                                           const std::string &data) {
+  auto &cache = ShaderCache::get();
+  uint64_t key = 0;
+  if (!cache.directory.empty()) {
+    key = ShaderCache::hash(kind, data);
+    if (auto spv = cache.load(key)) {
+      return *spv;
+    }
+  }
 
-  shaderc::Compiler compiler;
+  // creating a compiler is not free. one per thread
+  thread_local shaderc::Compiler compiler;
   shaderc::CompileOptions options;
 
   shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(
@@ -23,6 +116,9 @@ inline std::vector<uint32_t> compile_glsl(const std::string &name,
   }
 
   std::vector<uint32_t> result(module.cbegin(), module.cend());
+  if (!cache.directory.empty() && !result.empty()) {
+    cache.store(key, result);
+  }
   return result;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "buffer.h"
+#include "pipeline_cache.h"
 #include <magic_enum/magic_enum.hpp>
 #include <optional>
 #include <span>
@@ -267,7 +268,8 @@ struct Swapchain : public NonCopyable {
     auto result = vkAcquireNextImageKHR(this->device, this->swapchain,
                                         UINT64_MAX, imageAvailableSemaphore,
                                         VK_NULL_HANDLE, &imageIndex);
-    if (result != VK_SUCCESS) {
+    // VK_SUBOPTIMAL_KHR acquired the image and signals the semaphore
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
       return {result, {}};
     }
 
@@ -604,12 +606,131 @@ struct SwapchainIsolatedDepthFramebufferList : NonCopyable {
   }
 };
 
+// color and depth both from swapchains (XR_KHR_composition_layer_depth).
+// the two swapchains are acquired separately, so there is a framebuffer for
+// every pair of images
+struct SwapchainDepthFramebufferList : NonCopyable {
+  VkDevice device;
+  VkFormat format;
+  VkFormat depthFormat;
+  std::vector<VkImageView> imageViews;
+  std::vector<VkImageView> depthViews;
+  // [colorIndex * depthViews.size() + depthIndex]
+  std::vector<VkFramebuffer> framebuffers;
+
+  SwapchainDepthFramebufferList(VkDevice _device, VkFormat _format,
+                                VkFormat _depthFormat)
+      : device(_device), format(_format), depthFormat(_depthFormat) {}
+
+  ~SwapchainDepthFramebufferList() { release(); }
+
+  void release() {
+    for (auto framebuffer : this->framebuffers) {
+      vkDestroyFramebuffer(this->device, framebuffer, nullptr);
+    }
+    this->framebuffers.clear();
+    for (auto view : this->imageViews) {
+      vkDestroyImageView(this->device, view, nullptr);
+    }
+    this->imageViews.clear();
+    for (auto view : this->depthViews) {
+      vkDestroyImageView(this->device, view, nullptr);
+    }
+    this->depthViews.clear();
+  }
+
+  VkFramebuffer operator()(uint32_t colorIndex, uint32_t depthIndex) const {
+    return this->framebuffers[colorIndex * this->depthViews.size() +
+                              depthIndex];
+  }
+
+  void reset(VkRenderPass renderPass, VkExtent2D extent,
+             std::span<const VkImage> images,
+             std::span<const VkImage> depthImages) {
+    release();
+    for (auto image : images) {
+      this->imageViews.push_back(
+          createView(image, this->format, VK_IMAGE_ASPECT_COLOR_BIT));
+    }
+    for (auto image : depthImages) {
+      this->depthViews.push_back(
+          createView(image, this->depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT));
+    }
+    for (auto imageView : this->imageViews) {
+      for (auto depthView : this->depthViews) {
+        VkImageView attachments[] = {imageView, depthView};
+        VkFramebufferCreateInfo framebufferInfo{
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .renderPass = renderPass,
+            .attachmentCount = static_cast<uint32_t>(std::size(attachments)),
+            .pAttachments = attachments,
+            .width = extent.width,
+            .height = extent.height,
+            .layers = 1,
+        };
+        VkFramebuffer framebuffer;
+        CheckVkResult(vkCreateFramebuffer(this->device, &framebufferInfo,
+                                          nullptr, &framebuffer));
+        this->framebuffers.push_back(framebuffer);
+      }
+    }
+  }
+
+private:
+  VkImageView createView(VkImage image, VkFormat viewFormat,
+                         VkImageAspectFlags aspectMask) {
+    VkImageViewCreateInfo imageViewCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = viewFormat,
+        .components = {.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                       .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                       .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                       .a = VK_COMPONENT_SWIZZLE_IDENTITY},
+        .subresourceRange = {.aspectMask = aspectMask,
+                             .baseMipLevel = 0,
+                             .levelCount = 1,
+                             .baseArrayLayer = 0,
+                             .layerCount = 1},
+    };
+    VkImageView view;
+    CheckVkResult(
+        vkCreateImageView(this->device, &imageViewCreateInfo, nullptr, &view));
+    return view;
+  }
+};
+
 struct Vulkan {
   Instance instance;
   PhysicalDevice physicalDevice;
   Device device;
+  // released after the swapchain and before the device
+  std::unique_ptr<MemoryAllocator> allocator;
+  // saved to disk before the device is destroyed
+  std::unique_ptr<PipelineCache> pipelineCache;
   Swapchain swapchain;
 
+  // sub allocate PhysicalDevice::allocFor* from large blocks
+  MemoryAllocator &
+  enableAllocator(VkDeviceSize blockSize = 64 * 1024 * 1024,
+                  AllocationStrategy strategy = AllocationStrategy::Tlsf) {
+    this->allocator = std::make_unique<MemoryAllocator>(
+        this->device, this->physicalDevice.memoryProps,
+        this->physicalDevice.properties.limits, blockSize, strategy);
+    this->physicalDevice.allocator = this->allocator.get();
+    return *this->allocator;
+  }
+
+  // load from path now and save to path at shutdown.
+  // PipelineBuilder::pipelineCache = Device::pipelineCache
+  PipelineCache &enablePipelineCache(const std::filesystem::path &path) {
+    this->pipelineCache =
+        std::make_unique<PipelineCache>(this->physicalDevice, this->device, path);
+    this->device.pipelineCache = *this->pipelineCache;
+    return *this->pipelineCache;
+  }
+
   static VkFormat selectColorSwapchainFormat(std::span<const int64_t> formats) {
 
     // List of supported color swapchain formats.
@@ -647,6 +768,22 @@ struct Vulkan {
 
     return selected;
   }
+
+  // for a depth swapchain. VK_FORMAT_UNDEFINED if the runtime has none
+  static VkFormat selectDepthSwapchainFormat(std::span<const int64_t> formats) {
+    constexpr VkFormat candidates[] = {
+        VK_FORMAT_D32_SFLOAT,
+        VK_FORMAT_D24_UNORM_S8_UINT,
+        VK_FORMAT_D16_UNORM,
+    };
+    for (auto candidate : candidates) {
+      if (std::find(formats.begin(), formats.end(), candidate) !=
+          formats.end()) {
+        return candidate;
+      }
+    }
+    return VK_FORMAT_UNDEFINED;
+  }
 };
 
 } // namespace vk
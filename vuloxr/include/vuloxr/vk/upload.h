@@ -0,0 +1,460 @@
+#pragma once
+#include "buffer.h"
+#include <cstring>
+#include <deque>
+#include <optional>
+
+namespace vuloxr {
+
+namespace vk {
+
+//
+// Batched, non blocking staging uploads.
+//
+//   upload.copyBuffer(vertexBuffer, 0, vertices, size);
+//   upload.copyImage(texture.image, {w, h}, pixels, w * h * 4);
+//   auto ticket = upload.flush();  // one submit for all of the copies
+//   ...
+//   if (upload.isComplete(ticket)) { use the resources }
+//
+// The copies run on the dedicated transfer queue of the Device if there is
+// one. The ownership of every resource is then released to the graphics
+// family and acquired by a second submit on the graphics queue that waits on
+// a semaphore, so the render loop never waits on the cpu. Otherwise the
+// copies run on the graphics queue.
+//
+// The staging arena is one persistently mapped ring. Space is reclaimed
+// when the batch that used it completes. The graphics queue is shared with
+// the render loop: call from the render thread.
+//
+struct UploadService : NonCopyable {
+  struct BufferCopy {
+    VkBuffer dst;
+    VkBufferCopy region;
+  };
+
+  struct ImageCopy {
+    VkImage dst;
+    VkBufferImageCopy region;
+    VkImageLayout finalLayout;
+  };
+
+  struct Batch {
+    uint64_t ticket = 0;
+    VkCommandBuffer transferCommand = VK_NULL_HANDLE;
+    VkCommandBuffer acquireCommand = VK_NULL_HANDLE;
+    // signaled by the transfer submit. waited by the acquire submit
+    VkSemaphore transferred = VK_NULL_HANDLE;
+    // signaled by the last submit of the batch
+    VkFence fence = VK_NULL_HANDLE;
+    // head of the staging ring after this batch
+    VkDeviceSize stagingEnd = 0;
+    bool stagingWrapped = false;
+  };
+
+  VkDevice device;
+  uint32_t graphicsFamily;
+  uint32_t transferFamily;
+  VkQueue graphicsQueue;
+  VkQueue transferQueue;
+  VkCommandPool graphicsPool = VK_NULL_HANDLE;
+  VkCommandPool transferPool = VK_NULL_HANDLE;
+
+  Buffer staging;
+  Memory stagingMemory;
+  uint8_t *mapped = nullptr;
+  VkDeviceSize capacity;
+  // live data is [tail, head), or [tail, capacity) + [0, head) if wrapped
+  VkDeviceSize head = 0;
+  VkDeviceSize tail = 0;
+  bool wrapped = false;
+
+  std::vector<BufferCopy> pendingBuffers;
+  std::vector<ImageCopy> pendingImages;
+  std::deque<Batch> inFlight;
+  std::vector<Batch> freeBatches;
+  uint64_t nextTicket = 1;
+  uint64_t completedTicket = 0;
+
+  UploadService(const PhysicalDevice &physicalDevice, const Device &_device,
+                VkDeviceSize stagingSize = 32 * 1024 * 1024)
+      : device(_device), graphicsFamily(_device.queueFamily),
+        transferFamily(_device.transferQueueFamily),
+        graphicsQueue(_device.queue), transferQueue(_device.transferQueue),
+        staging(_device, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT),
+        capacity(stagingSize) {
+    this->stagingMemory = physicalDevice.allocForMap(device, this->staging);
+    if (this->stagingMemory.allocation.mapped) {
+      this->mapped = (uint8_t *)this->stagingMemory.allocation.mapped;
+    } else {
+      CheckVkResult(vkMapMemory(this->device, this->stagingMemory.memory,
+                                this->stagingMemory.offset(), VK_WHOLE_SIZE, 0,
+                                (void **)&this->mapped));
+    }
+
+    this->graphicsPool = createPool(this->graphicsFamily);
+    this->transferPool =
+        dedicated() ? createPool(this->transferFamily) : this->graphicsPool;
+  }
+
+  ~UploadService() {
+    waitIdle();
+    for (auto &batch : this->freeBatches) {
+      vkDestroyFence(this->device, batch.fence, nullptr);
+      vkDestroySemaphore(this->device, batch.transferred, nullptr);
+    }
+    if (this->transferPool != this->graphicsPool) {
+      vkDestroyCommandPool(this->device, this->transferPool, nullptr);
+    }
+    vkDestroyCommandPool(this->device, this->graphicsPool, nullptr);
+    if (!this->stagingMemory.allocation.mapped) {
+      vkUnmapMemory(this->device, this->stagingMemory.memory);
+    }
+  }
+
+  bool dedicated() const { return this->transferFamily != this->graphicsFamily; }
+
+  // false if the staging ring is full. poll() and retry
+  bool copyBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void *data,
+                  VkDeviceSize size) {
+    auto offset = allocateStaging(size, 4);
+    if (!offset) {
+      return false;
+    }
+    memcpy(this->mapped + *offset, data, size);
+    this->pendingBuffers.push_back({
+        .dst = dst,
+        .region =
+            {
+                .srcOffset = *offset,
+                .dstOffset = dstOffset,
+                .size = size,
+            },
+    });
+    return true;
+  }
+
+  // tightly packed texels of mip 0, layer 0
+  bool copyImage(VkImage dst, VkExtent2D extent, const void *pixels,
+                 VkDeviceSize size,
+                 VkImageLayout finalLayout =
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    // optimalBufferCopyOffsetAlignment is at most 16 in practice
+    auto offset = allocateStaging(size, 16);
+    if (!offset) {
+      return false;
+    }
+    memcpy(this->mapped + *offset, pixels, size);
+    this->pendingImages.push_back({
+        .dst = dst,
+        .region =
+            {
+                .bufferOffset = *offset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource =
+                    {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = 0,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                .imageOffset = {0, 0, 0},
+                .imageExtent = {extent.width, extent.height, 1},
+            },
+        .finalLayout = finalLayout,
+    });
+    return true;
+  }
+
+  // submit every pending copy. 0 if there was nothing to submit
+  uint64_t flush() {
+    if (this->pendingBuffers.empty() && this->pendingImages.empty()) {
+      return 0;
+    }
+
+    auto batch = getOrCreateBatch();
+    batch.ticket = this->nextTicket++;
+    batch.stagingEnd = this->head;
+    batch.stagingWrapped = this->wrapped;
+
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+
+    // transfer
+    begin(batch.transferCommand);
+    for (auto &copy : this->pendingImages) {
+      imageBarriers.push_back(
+          imageBarrier(copy.dst, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                       VK_IMAGE_LAYOUT_UNDEFINED,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED));
+    }
+    barrier(batch.transferCommand, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, {}, imageBarriers);
+    for (auto &copy : this->pendingBuffers) {
+      vkCmdCopyBuffer(batch.transferCommand, this->staging, copy.dst, 1,
+                      &copy.region);
+    }
+    for (auto &copy : this->pendingImages) {
+      vkCmdCopyBufferToImage(batch.transferCommand, this->staging, copy.dst,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                             &copy.region);
+    }
+
+    // release (dedicated) or make visible (same queue)
+    auto src = dedicated() ? this->transferFamily : VK_QUEUE_FAMILY_IGNORED;
+    auto dst = dedicated() ? this->graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+    const VkAccessFlags READ =
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+        VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    const VkPipelineStageFlags READ_STAGES =
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    bufferBarriers.clear();
+    imageBarriers.clear();
+    for (auto &copy : this->pendingBuffers) {
+      bufferBarriers.push_back({
+          .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+          .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+          .dstAccessMask = dedicated() ? 0 : READ,
+          .srcQueueFamilyIndex = src,
+          .dstQueueFamilyIndex = dst,
+          .buffer = copy.dst,
+          .offset = copy.region.dstOffset,
+          .size = copy.region.size,
+      });
+    }
+    for (auto &copy : this->pendingImages) {
+      imageBarriers.push_back(
+          imageBarrier(copy.dst, VK_ACCESS_TRANSFER_WRITE_BIT,
+                       dedicated() ? 0 : READ,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copy.finalLayout,
+                       src, dst));
+    }
+    barrier(batch.transferCommand, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            dedicated() ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : READ_STAGES,
+            bufferBarriers, imageBarriers);
+    CheckVkResult(vkEndCommandBuffer(batch.transferCommand));
+
+    CheckVkResult(vkResetFences(this->device, 1, &batch.fence));
+    if (!dedicated()) {
+      submit(this->graphicsQueue, batch.transferCommand, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, batch.fence);
+    } else {
+      submit(this->transferQueue, batch.transferCommand, VK_NULL_HANDLE, 0,
+             batch.transferred, VK_NULL_HANDLE);
+
+      // acquire. the same barriers with the access masks of the other side
+      begin(batch.acquireCommand);
+      for (auto &b : bufferBarriers) {
+        b.srcAccessMask = 0;
+        b.dstAccessMask = READ;
+      }
+      for (auto &b : imageBarriers) {
+        b.srcAccessMask = 0;
+        b.dstAccessMask = READ;
+      }
+      barrier(batch.acquireCommand, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+              READ_STAGES, bufferBarriers, imageBarriers);
+      CheckVkResult(vkEndCommandBuffer(batch.acquireCommand));
+      submit(this->graphicsQueue, batch.acquireCommand, batch.transferred,
+             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_NULL_HANDLE, batch.fence);
+    }
+
+    this->pendingBuffers.clear();
+    this->pendingImages.clear();
+    auto ticket = batch.ticket;
+    this->inFlight.push_back(batch);
+    return ticket;
+  }
+
+  // retire completed batches without blocking
+  void poll() {
+    while (!this->inFlight.empty()) {
+      auto &batch = this->inFlight.front();
+      if (vkGetFenceStatus(this->device, batch.fence) != VK_SUCCESS) {
+        break;
+      }
+      retire(batch);
+      this->freeBatches.push_back(batch);
+      this->inFlight.pop_front();
+    }
+  }
+
+  bool isComplete(uint64_t ticket) {
+    poll();
+    return ticket <= this->completedTicket;
+  }
+
+  void waitIdle() {
+    for (auto &batch : this->inFlight) {
+      vkWaitForFences(this->device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    }
+    poll();
+  }
+
+private:
+  VkCommandPool createPool(uint32_t family) {
+    VkCommandPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                 VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = family,
+    };
+    VkCommandPool pool;
+    CheckVkResult(vkCreateCommandPool(this->device, &info, nullptr, &pool));
+    return pool;
+  }
+
+  VkCommandBuffer allocateCommandBuffer(VkCommandPool pool) {
+    VkCommandBufferAllocateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    VkCommandBuffer cmd;
+    CheckVkResult(vkAllocateCommandBuffers(this->device, &info, &cmd));
+    return cmd;
+  }
+
+  Batch getOrCreateBatch() {
+    poll();
+    if (!this->freeBatches.empty()) {
+      auto batch = this->freeBatches.back();
+      this->freeBatches.pop_back();
+      return batch;
+    }
+    Batch batch{
+        .transferCommand = allocateCommandBuffer(this->transferPool),
+        .acquireCommand = allocateCommandBuffer(this->graphicsPool),
+    };
+    VkFenceCreateInfo fenceInfo = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+    };
+    CheckVkResult(
+        vkCreateFence(this->device, &fenceInfo, nullptr, &batch.fence));
+    VkSemaphoreCreateInfo semaphoreInfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+    CheckVkResult(vkCreateSemaphore(this->device, &semaphoreInfo, nullptr,
+                                    &batch.transferred));
+    return batch;
+  }
+
+  std::optional<VkDeviceSize> allocateStaging(VkDeviceSize size,
+                                              VkDeviceSize alignment) {
+    poll();
+    if (this->inFlight.empty() && this->pendingBuffers.empty() &&
+        this->pendingImages.empty()) {
+      // nothing live
+      this->head = this->tail = 0;
+      this->wrapped = false;
+    }
+    auto offset = alignUp(this->head, alignment);
+    if (!this->wrapped) {
+      if (offset + size <= this->capacity) {
+        this->head = offset + size;
+        return offset;
+      }
+      // wrap around
+      if (size <= this->tail) {
+        this->head = size;
+        this->wrapped = true;
+        return 0;
+      }
+      return {};
+    }
+    if (offset + size <= this->tail) {
+      this->head = offset + size;
+      return offset;
+    }
+    return {};
+  }
+
+  void retire(const Batch &batch) {
+    this->completedTicket = batch.ticket;
+    // everything up to the end of this batch is free
+    if (this->wrapped && !batch.stagingWrapped) {
+      // the batch ended in the upper segment. tail stays above head
+      this->tail = batch.stagingEnd;
+      if (this->tail == this->capacity) {
+        this->tail = 0;
+        this->wrapped = false;
+      }
+    } else {
+      this->tail = batch.stagingEnd;
+      this->wrapped = false;
+    }
+  }
+
+  static void begin(VkCommandBuffer cmd) {
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    CheckVkResult(vkBeginCommandBuffer(cmd, &beginInfo));
+  }
+
+  static VkImageMemoryBarrier
+  imageBarrier(VkImage image, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+               VkImageLayout oldLayout, VkImageLayout newLayout,
+               uint32_t srcFamily, uint32_t dstFamily) {
+    return {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = srcFamily,
+        .dstQueueFamilyIndex = dstFamily,
+        .image = image,
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+  }
+
+  static void barrier(VkCommandBuffer cmd, VkPipelineStageFlags srcStage,
+                      VkPipelineStageFlags dstStage,
+                      std::span<const VkBufferMemoryBarrier> buffers,
+                      std::span<const VkImageMemoryBarrier> images) {
+    if (buffers.empty() && images.empty()) {
+      return;
+    }
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr,
+                         static_cast<uint32_t>(buffers.size()), buffers.data(),
+                         static_cast<uint32_t>(images.size()), images.data());
+  }
+
+  static void submit(VkQueue queue, VkCommandBuffer cmd, VkSemaphore wait,
+                     VkPipelineStageFlags waitStage, VkSemaphore signal,
+                     VkFence fence) {
+    VkSubmitInfo submitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &cmd,
+    };
+    if (wait != VK_NULL_HANDLE) {
+      submitInfo.waitSemaphoreCount = 1;
+      submitInfo.pWaitSemaphores = &wait;
+      submitInfo.pWaitDstStageMask = &waitStage;
+    }
+    if (signal != VK_NULL_HANDLE) {
+      submitInfo.signalSemaphoreCount = 1;
+      submitInfo.pSignalSemaphores = &signal;
+    }
+    CheckVkResult(vkQueueSubmit(queue, 1, &submitInfo, fence));
+  }
+};
+
+} // namespace vk
+} // namespace vuloxr
@@ -8,6 +8,8 @@
 #endif
 #include <openxr/openxr_platform.h>
 
+#include <cstring>
+
 namespace vuloxr {
 
 namespace xr {
@@ -100,6 +102,34 @@ struct Instance : NonCopyable {
     }
   }
 
+  // push name if the runtime has it. call before create.
+  // on android after xrInitializeLoaderKHR.
+  // does not throw. false without a runtime, then create reports it
+  bool enableIfSupported(const char *name) {
+    uint32_t count = 0;
+    auto result = xrEnumerateInstanceExtensionProperties(NULL, 0, &count, NULL);
+    if (XR_FAILED(result)) {
+      Logger::Warn("xrEnumerateInstanceExtensionProperties [%d]", result);
+      return false;
+    }
+    std::vector<XrExtensionProperties> properties(
+        count, {XR_TYPE_EXTENSION_PROPERTIES, NULL});
+    result = xrEnumerateInstanceExtensionProperties(NULL, count, &count,
+                                                    properties.data());
+    if (XR_FAILED(result)) {
+      Logger::Warn("xrEnumerateInstanceExtensionProperties [%d]", result);
+      return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      if (strcmp(properties[i].extensionName, name) == 0) {
+        this->extensions.push_back(name);
+        return true;
+      }
+    }
+    Logger::Warn("openxr extension: %s is not supported", name);
+    return false;
+  }
+
   XrResult create(void *next) {
     for (auto name : this->extensions) {
       Logger::Info("openxr extension: %s", name);
@@ -43,6 +43,24 @@ struct OpenGLES {
 
     return *swapchainFormatIt;
   }
+
+  // for a depth swapchain. 0 if the runtime has none
+  static int64_t
+  selectDepthSwapchainFormat(std::span<const int64_t> runtimeFormats) {
+    constexpr int64_t supportedDepthSwapchainFormats[] = {
+        GL_DEPTH_COMPONENT32F,
+        GL_DEPTH24_STENCIL8,
+        GL_DEPTH_COMPONENT24,
+        GL_DEPTH_COMPONENT16,
+    };
+    auto swapchainFormatIt =
+        std::find_first_of(std::begin(supportedDepthSwapchainFormats),
+                           std::end(supportedDepthSwapchainFormats),
+                           runtimeFormats.begin(), runtimeFormats.end());
+    return swapchainFormatIt != std::end(supportedDepthSwapchainFormats)
+               ? *swapchainFormatIt
+               : 0;
+  }
 };
 
 } // namespace egl
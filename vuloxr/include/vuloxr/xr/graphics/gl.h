@@ -48,6 +48,24 @@ struct OpenGL {
 
     return *swapchainFormatIt;
   }
+
+  // for a depth swapchain. 0 if the runtime has none
+  static int64_t
+  selectDepthSwapchainFormat(std::span<const int64_t> runtimeFormats) {
+    constexpr int64_t SupportedDepthSwapchainFormats[] = {
+        GL_DEPTH_COMPONENT32F,
+        GL_DEPTH24_STENCIL8,
+        GL_DEPTH_COMPONENT24,
+        GL_DEPTH_COMPONENT16,
+    };
+    auto swapchainFormatIt =
+        std::find_first_of(std::begin(SupportedDepthSwapchainFormats),
+                           std::end(SupportedDepthSwapchainFormats),
+                           runtimeFormats.begin(), runtimeFormats.end());
+    return swapchainFormatIt != std::end(SupportedDepthSwapchainFormats)
+               ? *swapchainFormatIt
+               : 0;
+  }
 };
 
 } // namespace gl
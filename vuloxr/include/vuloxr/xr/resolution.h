@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace vuloxr {
+
+namespace xr {
+
+// render scale of the eye swapchains from the measured gpu time.
+//
+//   // allocate maxImageRect
+//   auto swapchain = std::make_shared<Swapchain<T>>(session, i, view, format,
+//                                                   image, 1, true);
+//   DynamicResolution resolution(swapchain->maxRenderScale());
+//   ...
+//   auto scale = resolution.update(gpuMs, frameState.predictedDisplayPeriod);
+//   swapchain->setRenderScale(scale);
+//   // viewport and scissor = swapchain->renderExtent
+//
+// the gpu time of a frame is about proportional to the pixels, scale^2. the
+// scale drops when the smoothed time exceeds the budget and rises when it is
+// well below, so it does not oscillate around a single threshold.
+struct DynamicResolution {
+  float minScale = 0.5f;
+  float maxScale = 1.0f;
+  // budget = predictedDisplayPeriod * headroom. leaves room for the
+  // compositor
+  float headroom = 0.8f;
+  // hold while budget * raiseBelow <= gpu <= budget
+  float raiseBelow = 0.7f;
+  // frames to wait after a change for the new scale to show in the queries
+  uint32_t cooldown = 15;
+  // the largest step up. steps down are not limited
+  float maxRaise = 1.1f;
+  // exponential moving average of the gpu time
+  float smoothing = 0.1f;
+
+  float scale = 1.0f;
+  double averageMs = 0;
+
+  explicit DynamicResolution(float _maxScale = 1.0f)
+      : maxScale(std::max(_maxScale, 1.0f / 1024)) {
+    this->scale = std::min(1.0f, this->maxScale);
+    this->minScale = std::min(this->minScale, this->maxScale);
+  }
+
+  // gpuMs <= 0: not measured (yet). keeps the current scale
+  float update(double gpuMs, int64_t predictedDisplayPeriodNs) {
+    if (gpuMs <= 0 || predictedDisplayPeriodNs <= 0) {
+      return this->scale;
+    }
+    this->averageMs = this->averageMs == 0
+                          ? gpuMs
+                          : this->averageMs +
+                                (gpuMs - this->averageMs) * this->smoothing;
+    if (this->wait > 0) {
+      --this->wait;
+      return this->scale;
+    }
+
+    auto budgetMs = predictedDisplayPeriodNs / 1e6 * this->headroom;
+    if (this->averageMs > budgetMs) {
+      // over budget. drop right to the estimated scale
+      this->change(static_cast<float>(
+          this->scale * std::sqrt(budgetMs / this->averageMs)));
+    } else if (this->averageMs < budgetMs * this->raiseBelow &&
+               this->scale < this->maxScale) {
+      // aim at the middle of the band
+      auto target = budgetMs * (1 + this->raiseBelow) / 2;
+      this->change(std::min(
+          static_cast<float>(this->scale *
+                             std::sqrt(target / this->averageMs)),
+          this->scale * this->maxRaise));
+    }
+    return this->scale;
+  }
+
+private:
+  uint32_t wait = 0;
+
+  void change(float newScale) {
+    newScale = std::clamp(newScale, this->minScale, this->maxScale);
+    if (newScale == this->scale) {
+      return;
+    }
+    // the expected time at the new scale. the next samples correct it
+    this->averageMs *= (newScale * newScale) / (this->scale * this->scale);
+    this->scale = newScale;
+    this->wait = this->cooldown;
+  }
+};
+
+} // namespace xr
+} // namespace vuloxr
@@ -1,7 +1,15 @@
 #pragma once
 
 #include "../xr.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <magic_enum/magic_enum.hpp>
+#include <mutex>
+#include <thread>
 
 namespace vuloxr {
 
@@ -51,6 +59,10 @@ class LayerComposition {
   std::vector<XrCompositionLayerBaseHeader *> layers;
   XrCompositionLayerProjection layer;
   std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
+  // type 0 for a view without depth
+  std::vector<XrCompositionLayerDepthInfoKHR> depthInfos;
+  // over the projection layer. in push order
+  std::vector<XrCompositionLayerQuad> quads;
 
 public:
   LayerComposition(XrSpace appSpace, XrEnvironmentBlendMode blendMode =
@@ -71,10 +83,30 @@ public:
   // left / right
   void pushView(const XrCompositionLayerProjectionView &view) {
     this->projectionLayerViews.push_back(view);
+    this->depthInfos.push_back({});
+  }
+
+  // XR_KHR_composition_layer_depth must be enabled
+  void pushView(const XrCompositionLayerProjectionView &view,
+                const XrCompositionLayerDepthInfoKHR &depthInfo) {
+    this->projectionLayerViews.push_back(view);
+    this->depthInfos.push_back(depthInfo);
+  }
+
+  // a panel. see QuadPanel
+  void pushQuad(const XrCompositionLayerQuad &quad) {
+    this->quads.push_back(quad);
   }
 
   const std::vector<XrCompositionLayerBaseHeader *> &commitLayers() {
     this->layers.clear();
+    // the vectors do not move from here
+    for (size_t i = 0; i < this->projectionLayerViews.size(); ++i) {
+      auto &depthInfo = this->depthInfos[i];
+      if (depthInfo.type == XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR) {
+        this->projectionLayerViews[i].next = &depthInfo;
+      }
+    }
     if (projectionLayerViews.size()) {
       this->layer.viewCount =
           static_cast<uint32_t>(projectionLayerViews.size());
@@ -82,6 +114,10 @@ public:
       this->layers.push_back(
           reinterpret_cast<XrCompositionLayerBaseHeader *>(&layer));
     }
+    for (auto &quad : this->quads) {
+      this->layers.push_back(
+          reinterpret_cast<XrCompositionLayerBaseHeader *>(&quad));
+    }
     return this->layers;
   }
 };
@@ -100,6 +136,273 @@ endFrame(XrSession session, XrTime predictedDisplayTime,
   CheckXrResult(xrEndFrame(session, &frameEndInfo));
 }
 
+// milliseconds of each stage of a pipelined frame
+struct FrameTimings {
+  // blocked in xrWaitFrame
+  double wait = 0;
+  // simulate callback on the frame thread
+  double simulate = 0;
+  // from the end of simulate to the pop on the render thread
+  double queue = 0;
+  // xrBeginFrame
+  double begin = 0;
+  // from xrBeginFrame to xrEndFrame. recording and submit
+  double render = 0;
+  // xrEndFrame
+  double end = 0;
+
+  void blend(const FrameTimings &t, double a) {
+    this->wait += (t.wait - this->wait) * a;
+    this->simulate += (t.simulate - this->simulate) * a;
+    this->queue += (t.queue - this->queue) * a;
+    this->begin += (t.begin - this->begin) * a;
+    this->render += (t.render - this->render) * a;
+    this->end += (t.end - this->end) * a;
+  }
+};
+
+// pipelined frame loop.
+// a frame thread owns xrWaitFrame and the simulation, the render thread owns
+// xrBeginFrame / xrEndFrame. frames are handed over in xrWaitFrame order
+// through a bounded queue, so the simulation of frame n + 1 overlaps the
+// rendering of frame n. the runtime blocks xrWaitFrame of frame n + 1 until
+// xrBeginFrame of frame n, which is the overlap the spec allows.
+//
+//   FramePipeline<Scene> pipeline(session, [](const XrFrameState &state,
+//                                             Scene &scene) { ... });
+//   state.m_beforeEndSession = [&]() { pipeline.stop(); };
+//   while (...) {
+//     state.PollEvents();
+//     ...
+//     pipeline.start();
+//     auto frame = pipeline.beginFrame();  // xrBeginFrame
+//     ... render frame->state, frame->scene
+//     pipeline.endFrame(*frame, layers);   // xrEndFrame
+//   }
+//
+// T is the scene snapshot. written by the frame thread, read by the render
+// thread, never both at once. simulate is called for every frame, check
+// XrFrameState::shouldRender in it.
+template <typename T> struct FramePipeline : NonCopyable {
+  using SimulateFunc = std::function<void(const XrFrameState &, T &)>;
+
+  struct Frame {
+    uint64_t frameNumber = 0;
+    XrFrameState state{XR_TYPE_FRAME_STATE};
+    T scene;
+    FrameTimings timings;
+    std::chrono::steady_clock::time_point simulated;
+    std::chrono::steady_clock::time_point begun;
+  };
+
+  XrSession session;
+  SimulateFunc simulate;
+  // moving average of the stages
+  FrameTimings average;
+
+  // depth: frames simulated ahead of the render thread
+  FramePipeline(XrSession _session, const SimulateFunc &_simulate,
+                uint32_t depth = 1)
+      : session(_session), simulate(_simulate), depth(std::max(1u, depth)),
+        frames(this->depth + 2) {
+    for (auto &frame : this->frames) {
+      this->free.push_back(&frame);
+    }
+  }
+
+  ~FramePipeline() { stop(); }
+
+  bool running() const { return this->thread.joinable(); }
+
+  // call while the session is running
+  void start() {
+    if (this->running()) {
+      return;
+    }
+    this->stopping = false;
+    this->error = nullptr;
+    this->thread = std::thread([this]() { this->frameLoop(); });
+  }
+
+  // call from the render thread before xrEndSession.
+  // the frames already waited are begun and ended without layers, so the
+  // frame thread is never left blocked in xrWaitFrame
+  void stop() {
+    if (!this->running()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->stopping = true;
+    }
+    this->cv.notify_all();
+    for (;;) {
+      Frame *frame = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cv.wait(lock, [this]() {
+          return !this->ready.empty() || this->finished;
+        });
+        if (this->ready.empty()) {
+          break;
+        }
+        frame = this->ready.front();
+        this->ready.pop_front();
+      }
+      XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+      auto result = xrBeginFrame(this->session, &frameBeginInfo);
+      if (XR_SUCCEEDED(result)) {
+        XrFrameEndInfo frameEndInfo{
+            .type = XR_TYPE_FRAME_END_INFO,
+            .displayTime = frame->state.predictedDisplayTime,
+            .environmentBlendMode = this->blendMode,
+        };
+        result = xrEndFrame(this->session, &frameEndInfo);
+        if (XR_FAILED(result)) {
+          Logger::Warn("FramePipeline::stop: xrEndFrame [%d]", result);
+        }
+      } else {
+        Logger::Warn("FramePipeline::stop: xrBeginFrame [%d]", result);
+      }
+      this->release(frame);
+    }
+    this->thread.join();
+    this->finished = false;
+  }
+
+  // pop the next simulated frame and xrBeginFrame.
+  // null if the pipeline is stopped. rethrows an error of the frame thread
+  Frame *beginFrame() {
+    Frame *frame = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv.wait(lock, [this]() {
+        return !this->ready.empty() || this->finished || !this->running();
+      });
+      if (this->ready.empty()) {
+        if (this->error) {
+          std::rethrow_exception(this->error);
+        }
+        return nullptr;
+      }
+      frame = this->ready.front();
+      this->ready.pop_front();
+    }
+    this->cv.notify_all();
+
+    auto now = std::chrono::steady_clock::now();
+    frame->timings.queue = ms(frame->simulated, now);
+    XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+    CheckXrResult(xrBeginFrame(this->session, &frameBeginInfo));
+    frame->begun = std::chrono::steady_clock::now();
+    frame->timings.begin = ms(now, frame->begun);
+    return frame;
+  }
+
+  void endFrame(
+      Frame &frame, const std::vector<XrCompositionLayerBaseHeader *> &layers,
+      XrEnvironmentBlendMode blendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE) {
+    auto now = std::chrono::steady_clock::now();
+    frame.timings.render = ms(frame.begun, now);
+    // stop ends the drained frames with it
+    this->blendMode = blendMode;
+    vuloxr::xr::endFrame(this->session, frame.state.predictedDisplayTime,
+                         layers, blendMode);
+    frame.timings.end = ms(now, std::chrono::steady_clock::now());
+
+    this->average.blend(frame.timings, frame.frameNumber == 0 ? 1.0 : 0.05);
+    if (frame.frameNumber % 300 == 299) {
+      Logger::Info("FramePipeline: wait %.2f, simulate %.2f, queue %.2f, "
+                   "begin %.2f, render %.2f, end %.2f (ms)",
+                   this->average.wait, this->average.simulate,
+                   this->average.queue, this->average.begin,
+                   this->average.render, this->average.end);
+    }
+    this->release(&frame);
+  }
+
+private:
+  uint32_t depth;
+  std::vector<Frame> frames;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Frame *> free;
+  std::deque<Frame *> ready;
+  bool stopping = false;
+  bool finished = false;
+  std::exception_ptr error;
+  uint64_t frameCount = 0;
+  // of the last endFrame. the runtime may not support opaque
+  XrEnvironmentBlendMode blendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+
+  static double ms(std::chrono::steady_clock::time_point begin,
+                   std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+  }
+
+  void release(Frame *frame) {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->free.push_back(frame);
+    }
+    this->cv.notify_all();
+  }
+
+  void frameLoop() {
+    try {
+      for (;;) {
+        Frame *frame = nullptr;
+        {
+          // bounded. at most depth frames wait for the render thread
+          std::unique_lock<std::mutex> lock(this->mutex);
+          this->cv.wait(lock, [this]() {
+            return this->stopping || (!this->free.empty() &&
+                                      this->ready.size() < this->depth);
+          });
+          if (this->stopping) {
+            break;
+          }
+          frame = this->free.front();
+          this->free.pop_front();
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
+        frame->state = {XR_TYPE_FRAME_STATE};
+        auto res = xrWaitFrame(this->session, &frameWaitInfo, &frame->state);
+        auto t1 = std::chrono::steady_clock::now();
+        if (XR_FAILED(res)) {
+          this->release(frame);
+          ThrowXrResult(res, "xrWaitFrame");
+        }
+        frame->frameNumber = this->frameCount++;
+        frame->timings = {};
+        frame->timings.wait = ms(t0, t1);
+        // waited. must reach xrBeginFrame even if stopping
+        this->simulate(frame->state, frame->scene);
+        frame->simulated = std::chrono::steady_clock::now();
+        frame->timings.simulate = ms(t1, frame->simulated);
+
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->ready.push_back(frame);
+        }
+        this->cv.notify_all();
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->finished = true;
+    }
+    this->cv.notify_all();
+  }
+};
+
 struct Stereoscope {
   std::vector<XrViewConfigurationView> viewConfigurations;
   std::vector<XrView> views;
@@ -197,6 +500,8 @@ public:
   bool m_sessionRunning = false;
   bool m_exitRenderLoop = false;
   bool m_requestRestart = false;
+  // e.g. FramePipeline::stop. no xrWaitFrame may be pending in xrEndSession
+  std::function<void()> m_beforeEndSession;
   SessionState(XrInstance instance, XrSession session,
                XrViewConfigurationType viewConfigurationType)
       : m_instance(instance), m_session(session),
@@ -409,6 +714,9 @@ private:
     case XR_SESSION_STATE_STOPPING: {
       assert(m_session != XR_NULL_HANDLE);
       m_sessionRunning = false;
+      if (m_beforeEndSession) {
+        m_beforeEndSession();
+      }
       CheckXrResult(xrEndSession(m_session));
       break;
     }
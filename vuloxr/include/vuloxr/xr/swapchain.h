@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../xr.h"
+#include <algorithm>
 #include <magic_enum/magic_enum.hpp>
 
 namespace vuloxr {
@@ -12,31 +13,56 @@ struct Swapchain : NonCopyable {
   std::vector<T> swapchainImages;
   XrSwapchainCreateInfo swapchainCreateInfo;
   XrSwapchain swapchain;
+  // recommendedImageRect of the view
+  XrExtent2Di recommendedExtent;
+  // the region rendered this frame. the top left of the image.
+  // subImage.imageRect of ProjectionView
+  XrExtent2Di renderExtent;
 
+  // arraySize = 2 for multiview. one layer per eye.
+  // dynamicResolution allocates maxImageRect and renders a part of it. see
+  // setRenderScale
+  // XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT for a depth swapchain.
+  // see DepthInfo
   Swapchain(XrSession session, uint32_t i, const XrViewConfigurationView &vp,
-            int64_t format, const T &defaultImage) {
+            int64_t format, const T &defaultImage, uint32_t arraySize = 1,
+            bool dynamicResolution = false,
+            XrSwapchainUsageFlags usageFlags =
+                XR_SWAPCHAIN_USAGE_SAMPLED_BIT |
+                XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT)
+      : recommendedExtent{static_cast<int32_t>(vp.recommendedImageRectWidth),
+                          static_cast<int32_t>(
+                              vp.recommendedImageRectHeight)} {
+    auto width = dynamicResolution ? vp.maxImageRectWidth
+                                   : vp.recommendedImageRectWidth;
+    auto height = dynamicResolution ? vp.maxImageRectHeight
+                                    : vp.recommendedImageRectHeight;
 
     Logger::Info("Creating swapchain for view %d with dimensions "
-                 "Width=%d Height=%d SampleCount=%d",
-                 i, vp.recommendedImageRectWidth, vp.recommendedImageRectHeight,
-                 vp.recommendedSwapchainSampleCount);
+                 "Width=%d Height=%d SampleCount=%d ArraySize=%d",
+                 i, width, height, vp.recommendedSwapchainSampleCount,
+                 arraySize);
 
     // Create the swapchain.
     this->swapchainCreateInfo = {
         .type = XR_TYPE_SWAPCHAIN_CREATE_INFO,
         .createFlags = 0,
-        .usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT |
-                      XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT,
+        .usageFlags = usageFlags,
         .format = format,
         .sampleCount = 1,
-        .width = vp.recommendedImageRectWidth,
-        .height = vp.recommendedImageRectHeight,
+        .width = width,
+        .height = height,
         .faceCount = 1,
-        .arraySize = 1,
+        .arraySize = arraySize,
         .mipCount = 1,
     };
     CheckXrResult(xrCreateSwapchain(session, &this->swapchainCreateInfo,
                                     &this->swapchain));
+    this->renderExtent = {static_cast<int32_t>(width),
+                          static_cast<int32_t>(height)};
+    if (dynamicResolution) {
+      this->setRenderScale(1.0f);
+    }
     // static XrSwapchain oxr_create_swapchain(XrSession session, uint32_t
     // width,
     //                                         uint32_t height) {
@@ -72,8 +98,28 @@ struct Swapchain : NonCopyable {
 
   ~Swapchain() { xrDestroySwapchain(this->swapchain); }
 
-  std::tuple<uint32_t, T, XrCompositionLayerProjectionView>
-  AcquireSwapchain(const XrView &view) {
+  // scale of recommendedExtent that fits in the images
+  float maxRenderScale() const {
+    return std::min(
+        static_cast<float>(this->swapchainCreateInfo.width) /
+            this->recommendedExtent.width,
+        static_cast<float>(this->swapchainCreateInfo.height) /
+            this->recommendedExtent.height);
+  }
+
+  // renderExtent = recommendedExtent * scale. clamped to the images
+  void setRenderScale(float scale) {
+    auto fit = [scale](int32_t recommended, uint32_t size) {
+      return std::clamp(static_cast<int32_t>(recommended * scale + 0.5f), 1,
+                        static_cast<int32_t>(size));
+    };
+    this->renderExtent = {
+        fit(this->recommendedExtent.width, this->swapchainCreateInfo.width),
+        fit(this->recommendedExtent.height, this->swapchainCreateInfo.height),
+    };
+  }
+
+  std::tuple<uint32_t, T> AcquireImage() {
     XrSwapchainImageAcquireInfo acquireInfo{
         .type = XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO,
     };
@@ -87,26 +133,56 @@ struct Swapchain : NonCopyable {
     };
     CheckXrResult(xrWaitSwapchainImage(this->swapchain, &waitInfo));
 
+    return {swapchainImageIndex, this->swapchainImages[swapchainImageIndex]};
+  }
+
+  XrCompositionLayerProjectionView
+  ProjectionView(const XrView &view, uint32_t imageArrayIndex = 0) const {
     return {
-        swapchainImageIndex,
-        this->swapchainImages[swapchainImageIndex],
-        {
-            .type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW,
-            .pose = view.pose,
-            .fov = view.fov,
-            .subImage =
-                {
-                    .swapchain = this->swapchain,
-                    .imageRect =
-                        {
-                            .offset = {0, 0},
-                            .extent = {.width = static_cast<int32_t>(
-                                           this->swapchainCreateInfo.width),
-                                       .height = static_cast<int32_t>(
-                                           this->swapchainCreateInfo.height)},
-                        },
-                },
-        }};
+        .type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW,
+        .pose = view.pose,
+        .fov = view.fov,
+        .subImage =
+            {
+                .swapchain = this->swapchain,
+                .imageRect =
+                    {
+                        .offset = {0, 0},
+                        .extent = this->renderExtent,
+                    },
+                .imageArrayIndex = imageArrayIndex,
+            },
+    };
+  }
+
+  // XR_KHR_composition_layer_depth. chained to the ProjectionView of the same
+  // eye by LayerComposition::pushView. nearZ and farZ of the projection
+  // matrix. depth 0 at nearZ, 1 at farZ
+  XrCompositionLayerDepthInfoKHR DepthInfo(float nearZ, float farZ,
+                                           uint32_t imageArrayIndex = 0) const {
+    return {
+        .type = XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR,
+        .subImage =
+            {
+                .swapchain = this->swapchain,
+                .imageRect =
+                    {
+                        .offset = {0, 0},
+                        .extent = this->renderExtent,
+                    },
+                .imageArrayIndex = imageArrayIndex,
+            },
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+        .nearZ = nearZ,
+        .farZ = farZ,
+    };
+  }
+
+  std::tuple<uint32_t, T, XrCompositionLayerProjectionView>
+  AcquireSwapchain(const XrView &view) {
+    auto [index, image] = AcquireImage();
+    return {index, image, ProjectionView(view)};
   }
 
   void EndSwapchain() {
@@ -117,5 +193,79 @@ struct Swapchain : NonCopyable {
   }
 };
 
+// a swapchain submitted as XrCompositionLayerQuad. the compositor samples the
+// last released image at display resolution every frame, so the image is
+// rendered again only when the content changes.
+//
+//   QuadPanel<T> panel(session, width, height, format, image, {1.0f, 0.5f});
+//   // every frame
+//   panel.update(hash, [](uint32_t index, const T &image) { ... });
+//   panel.pose = ...;
+//   composition.pushQuad(panel.layer(appSpace));
+template <typename T> struct QuadPanel : NonCopyable {
+  Swapchain<T> swapchain;
+  // meters
+  XrExtent2Df size;
+  // center of the quad in the space of layer()
+  XrPosef pose{.orientation = {0, 0, 0, 1.0f}, .position = {0, 0, 0}};
+
+  QuadPanel(XrSession session, uint32_t width, uint32_t height,
+            int64_t format, const T &defaultImage, const XrExtent2Df &_size)
+      : swapchain(session, 0, panelView(width, height), format, defaultImage),
+        size(_size) {}
+
+  // the first update always renders. then only for another contentHash.
+  // returns true if rendered
+  template <typename F> bool update(uint64_t contentHash, const F &render) {
+    if (this->released && contentHash == this->hash) {
+      return false;
+    }
+    auto [index, image] = this->swapchain.AcquireImage();
+    render(index, image);
+    this->swapchain.EndSwapchain();
+    this->hash = contentHash;
+    this->released = true;
+    return true;
+  }
+
+  // the image is premultiplied alpha. valid after the first update
+  XrCompositionLayerQuad layer(XrSpace space) const {
+    return {
+        .type = XR_TYPE_COMPOSITION_LAYER_QUAD,
+        .layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT,
+        .space = space,
+        .eyeVisibility = XR_EYE_VISIBILITY_BOTH,
+        .subImage =
+            {
+                .swapchain = this->swapchain.swapchain,
+                .imageRect =
+                    {
+                        .offset = {0, 0},
+                        .extent = this->swapchain.renderExtent,
+                    },
+                .imageArrayIndex = 0,
+            },
+        .pose = this->pose,
+        .size = this->size,
+    };
+  }
+
+private:
+  uint64_t hash = 0;
+  bool released = false;
+
+  static XrViewConfigurationView panelView(uint32_t width, uint32_t height) {
+    return {
+        .type = XR_TYPE_VIEW_CONFIGURATION_VIEW,
+        .recommendedImageRectWidth = width,
+        .maxImageRectWidth = width,
+        .recommendedImageRectHeight = height,
+        .maxImageRectHeight = height,
+        .recommendedSwapchainSampleCount = 1,
+        .maxSwapchainSampleCount = 1,
+    };
+  }
+};
+
 } // namespace xr
 } // namespace vuloxr